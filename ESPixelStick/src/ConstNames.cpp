@@ -35,11 +35,13 @@ const CN_PROGMEM char CN_b                        [] = "b";
 const CN_PROGMEM char CN_b16                      [] = "b16";
 const CN_PROGMEM char CN_baudrate                 [] = "baudrate";
 const CN_PROGMEM char CN_blanktime                [] = "blanktime";
+const CN_PROGMEM char CN_boards                   [] = "boards";
 const CN_PROGMEM char CN_bridge                   [] = "bridge";
 const CN_PROGMEM char CN_brightness               [] = "brightness";
 const CN_PROGMEM char CN_cfgver                   [] = "cfgver";
 const CN_PROGMEM char CN_channels                 [] = "channels";
 const CN_PROGMEM char CN_clean                    [] = "clean";
+const CN_PROGMEM char CN_clock_khz                [] = "clock_khz";
 const CN_PROGMEM char CN_clock_pin                [] = "clock_pin";
 const CN_PROGMEM char CN_cmd                      [] = "cmd";
 const CN_PROGMEM char CN_color                    [] = "color";
@@ -55,8 +57,10 @@ const CN_PROGMEM char CN_current_sequence         [] = "current_sequence";
 const CN_PROGMEM char CN_data_pin                 [] = "data_pin";
 const CN_PROGMEM char CN_device                   [] = "device";
 const CN_PROGMEM char CN_dhcp                     [] = "dhcp";
+const CN_PROGMEM char CN_dither                   [] = "dither";
 const CN_PROGMEM char CN_Dotfseq                  [] = ".fseq";
 const CN_PROGMEM char CN_Dotpl                    [] = ".pl";
+const CN_PROGMEM char CN_doublebuffer             [] = "doublebuffer";
 const CN_PROGMEM char CN_duration                 [] = "duration";
 const CN_PROGMEM char CN_effect                   [] = "effect";
 const CN_PROGMEM char CN_effect_list              [] = "effect_list";
@@ -77,6 +81,7 @@ const CN_PROGMEM char CN_ESP8266                  [] = "ESP8266";
 const CN_PROGMEM char CN_ESPixelStick             [] = "ESPixelStick";
 const CN_PROGMEM char CN_eth                      [] = "eth";
 const CN_PROGMEM char CN_EthDrv                   [] = "EthDrv";
+const CN_PROGMEM char CN_fadetime                 [] = "fadetime";
 const CN_PROGMEM char CN_false                    [] = "false";
 const CN_PROGMEM char CN_File                     [] = "File";
 const CN_PROGMEM char CN_file                     [] = "file";
@@ -95,6 +100,8 @@ const CN_PROGMEM char CN_group_size               [] = "group_size";
 const CN_PROGMEM char CN_Heap_colon               [] = "Heap: ";
 const CN_PROGMEM char CN_hadisco                  [] = "hadisco";
 const CN_PROGMEM char CN_haprefix                 [] = "haprefix";
+const CN_PROGMEM char CN_hdr                      [] = "hdr";
+const CN_PROGMEM char CN_holdframe                [] = "holdframe";
 const CN_PROGMEM char CN_HostName                 [] = "HostName";
 const CN_PROGMEM char CN_hostname                 [] = "hostname";
 const CN_PROGMEM char CN_hv                       [] = "hv";
@@ -106,9 +113,15 @@ const CN_PROGMEM char CN_inv                      [] = "inv";
 const CN_PROGMEM char CN_ip                       [] = "ip";
 const CN_PROGMEM char CN_input                    [] = "input";
 const CN_PROGMEM char CN_input_config             [] = "input_config";
+const CN_PROGMEM char CN_keepalive                [] = "keepalive";
 const CN_PROGMEM char CN_last_clientIP            [] = "last_clientIP";
 const CN_PROGMEM char CN_lwt                      [] = "lwt";
 const CN_PROGMEM char CN_mac                      [] = "mac";
+const CN_PROGMEM char CN_map_file                 [] = "map_file";
+const CN_PROGMEM char CN_map_mirror               [] = "map_mirror";
+const CN_PROGMEM char CN_map_rotation             [] = "map_rotation";
+const CN_PROGMEM char CN_map_serpentine           [] = "map_serpentine";
+const CN_PROGMEM char CN_map_width                [] = "map_width";
 const CN_PROGMEM char CN_mdc_pin                  [] = "mdc_pin";
 const CN_PROGMEM char CN_mdio_pin                 [] = "mdio_pin";
 const CN_PROGMEM char CN_Max                      [] = "Max";
@@ -142,8 +155,11 @@ const CN_PROGMEM char CN_polarity                 [] = "polarity";
 const CN_PROGMEM char CN_port                     [] = "port";
 const CN_PROGMEM char CN_power_pin                [] = "power_pin";
 const CN_PROGMEM char CN_prependnullcount         [] = "prependnullcount";
+const CN_PROGMEM char CN_prepareframe             [] = "prepareframe";
 const CN_PROGMEM char CN_pwm                      [] = "pwm";
+const CN_PROGMEM char CN_pwmbits                  [] = "pwmbits";
 const CN_PROGMEM char CN_r                        [] = "r";
+const CN_PROGMEM char CN_refreshrate              [] = "refreshrate";
 const CN_PROGMEM char CN_remote                   [] = "remote";
 const CN_PROGMEM char CN_rev                      [] = "rev";
 const CN_PROGMEM char CN_reverse                  [] = "reverse";
@@ -154,8 +170,10 @@ const CN_PROGMEM char CN_seconds_elapsed          [] = "seconds_elapsed";
 const CN_PROGMEM char CN_seconds_played           [] = "seconds_played";
 const CN_PROGMEM char CN_seconds_remaining        [] = "seconds_remaining";
 const CN_PROGMEM char CN_sequence_filename        [] = "sequence_filename";
+const CN_PROGMEM char CN_sixteenbitinput          [] = "sixteenbitinput";
 const CN_PROGMEM char CN_slashset                 [] = "/set";
 const CN_PROGMEM char CN_slashstatus              [] = "/status";
+const CN_PROGMEM char CN_smoothing                [] = "smoothing";
 const CN_PROGMEM char CN_speed                    [] = "speed";
 const CN_PROGMEM char CN_ssid                     [] = "ssid";
 const CN_PROGMEM char CN_sta_timeout              [] = "sta_timeout";
@@ -163,7 +181,9 @@ const CN_PROGMEM char CN_stars                    [] = "***";
 const CN_PROGMEM char CN_state                    [] = "state";
 const CN_PROGMEM char CN_status                   [] = "status";
 const CN_PROGMEM char CN_status_name              [] = "status_name";
+const CN_PROGMEM char CN_steprate                 [] = "steprate";
 const CN_PROGMEM char CN_subnet                   [] = "subnet";
+const CN_PROGMEM char CN_syncrmt                  [] = "syncrmt";
 const CN_PROGMEM char CN_SyncOffset               [] = "SyncOffset";
 const CN_PROGMEM char CN_system                   [] = "system";
 const CN_PROGMEM char CN_textSLASHplain           [] = "text/plain";
@@ -187,6 +207,7 @@ const CN_PROGMEM char CN_updateinterval           [] = "updateinterval";
 const CN_PROGMEM char CN_user                     [] = "user";
 const CN_PROGMEM char CN_version                  [] = "version";
 const CN_PROGMEM char CN_Version                  [] = "Version";
+const CN_PROGMEM char CN_vmax                     [] = "vmax";
 const CN_PROGMEM char CN_weus                     [] = "weus";
 const CN_PROGMEM char CN_wifi                     [] = "wifi";
 const CN_PROGMEM char CN_WiFiDrv                  [] = "WiFiDrv";
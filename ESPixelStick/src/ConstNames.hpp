@@ -44,11 +44,13 @@ extern const CN_PROGMEM char CN_b[];
 extern const CN_PROGMEM char CN_b16[];
 extern const CN_PROGMEM char CN_baudrate[];
 extern const CN_PROGMEM char CN_blanktime[];
+extern const CN_PROGMEM char CN_boards[];
 extern const CN_PROGMEM char CN_bridge[];
 extern const CN_PROGMEM char CN_brightness[];
 extern const CN_PROGMEM char CN_cfgver[];
 extern const CN_PROGMEM char CN_channels[];
 extern const CN_PROGMEM char CN_clean[];
+extern const CN_PROGMEM char CN_clock_khz[];
 extern const CN_PROGMEM char CN_clock_pin[];
 extern const CN_PROGMEM char CN_cmd[];
 extern const CN_PROGMEM char CN_color[];
@@ -64,8 +66,10 @@ extern const CN_PROGMEM char CN_current_sequence[];
 extern const CN_PROGMEM char CN_data_pin[];
 extern const CN_PROGMEM char CN_device [];
 extern const CN_PROGMEM char CN_dhcp[];
+extern const CN_PROGMEM char CN_dither[];
 extern const CN_PROGMEM char CN_Dotfseq[];
 extern const CN_PROGMEM char CN_Dotpl[];
+extern const CN_PROGMEM char CN_doublebuffer[];
 extern const CN_PROGMEM char CN_duration[];
 extern const CN_PROGMEM char CN_effect[];
 extern const CN_PROGMEM char CN_effect_list[];
@@ -86,6 +90,7 @@ extern const CN_PROGMEM char CN_ESP8266[];
 extern const CN_PROGMEM char CN_ESPixelStick [];
 extern const CN_PROGMEM char CN_eth[];
 extern const CN_PROGMEM char CN_EthDrv[];
+extern const CN_PROGMEM char CN_fadetime[];
 extern const CN_PROGMEM char CN_false [];
 extern const CN_PROGMEM char CN_File[];
 extern const CN_PROGMEM char CN_file[];
@@ -103,6 +108,8 @@ extern const CN_PROGMEM char CN_gid[];
 extern const CN_PROGMEM char CN_group_size[];
 extern const CN_PROGMEM char CN_hadisco[];
 extern const CN_PROGMEM char CN_haprefix[];
+extern const CN_PROGMEM char CN_hdr[];
+extern const CN_PROGMEM char CN_holdframe[];
 extern const CN_PROGMEM char CN_Heap_colon [];
 extern const CN_PROGMEM char CN_HostName [];
 extern const CN_PROGMEM char CN_hostname [];
@@ -115,9 +122,15 @@ extern const CN_PROGMEM char CN_inv[];
 extern const CN_PROGMEM char CN_ip[];
 extern const CN_PROGMEM char CN_input[];
 extern const CN_PROGMEM char CN_input_config[];
+extern const CN_PROGMEM char CN_keepalive[];
 extern const CN_PROGMEM char CN_last_clientIP[];
 extern const CN_PROGMEM char CN_lwt[];
 extern const CN_PROGMEM char CN_mac[];
+extern const CN_PROGMEM char CN_map_file[];
+extern const CN_PROGMEM char CN_map_mirror[];
+extern const CN_PROGMEM char CN_map_rotation[];
+extern const CN_PROGMEM char CN_map_serpentine[];
+extern const CN_PROGMEM char CN_map_width[];
 extern const CN_PROGMEM char CN_mdc_pin[];
 extern const CN_PROGMEM char CN_mdio_pin[];
 extern const CN_PROGMEM char CN_Max[];
@@ -151,9 +164,12 @@ extern const CN_PROGMEM char CN_playlist [];
 extern const CN_PROGMEM char CN_plussigns [];
 extern const CN_PROGMEM char CN_power_pin[];
 extern const CN_PROGMEM char CN_prependnullcount [];
+extern const CN_PROGMEM char CN_prepareframe[];
 extern const CN_PROGMEM char CN_pwm [];
+extern const CN_PROGMEM char CN_pwmbits[];
 extern const CN_PROGMEM char CN_remote[];
 extern const CN_PROGMEM char CN_r[];
+extern const CN_PROGMEM char CN_refreshrate[];
 extern const CN_PROGMEM char CN_rev[];
 extern const CN_PROGMEM char CN_reverse[];
 extern const CN_PROGMEM char CN_RMT[];
@@ -163,8 +179,10 @@ extern const CN_PROGMEM char CN_seconds_elapsed[];
 extern const CN_PROGMEM char CN_seconds_played[];
 extern const CN_PROGMEM char CN_seconds_remaining[];
 extern const CN_PROGMEM char CN_sequence_filename[];
+extern const CN_PROGMEM char CN_sixteenbitinput[];
 extern const CN_PROGMEM char CN_slashset[];
 extern const CN_PROGMEM char CN_slashstatus[];
+extern const CN_PROGMEM char CN_smoothing[];
 extern const CN_PROGMEM char CN_speed[];
 extern const CN_PROGMEM char CN_ssid [];
 extern const CN_PROGMEM char CN_sta_timeout [];
@@ -172,7 +190,9 @@ extern const CN_PROGMEM char CN_stars[];
 extern const CN_PROGMEM char CN_state[];
 extern const CN_PROGMEM char CN_status [];
 extern const CN_PROGMEM char CN_status_name[];
+extern const CN_PROGMEM char CN_steprate[];
 extern const CN_PROGMEM char CN_subnet[];
+extern const CN_PROGMEM char CN_syncrmt[];
 extern const CN_PROGMEM char CN_SyncOffset[];
 extern const CN_PROGMEM char CN_system[];
 extern const CN_PROGMEM char CN_textSLASHplain[];
@@ -196,6 +216,7 @@ extern const CN_PROGMEM char CN_updateinterval[];
 extern const CN_PROGMEM char CN_user[];
 extern const CN_PROGMEM char CN_version[];
 extern const CN_PROGMEM char CN_Version[];
+extern const CN_PROGMEM char CN_vmax[];
 extern const CN_PROGMEM char CN_weus[];
 extern const CN_PROGMEM char CN_wifi[];
 extern const CN_PROGMEM char CN_WiFiDrv[];
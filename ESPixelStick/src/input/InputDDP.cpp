@@ -270,6 +270,12 @@ void c_InputDDP::ProcessReceivedData (DDP_packet_t & Packet)
         // DEBUG_V (String ("   InputBufferOffset: ") + String (InputBufferOffset));
         OutputMgr.WriteChannelData(InputBufferOffset, AdjPacketDataLength, &Data[0]);
 
+        // the sender sets push on the last packet of a frame
+        if (header.flags1 & DDP_FLAGS1_PUSH)
+        {
+            OutputMgr.InputFrameComplete ();
+        }
+
         InputMgr.RestartBlankTimer (GetInputChannelId ());
 
     } while (false);
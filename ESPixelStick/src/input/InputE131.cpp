@@ -31,8 +31,6 @@ c_InputE131::c_InputE131 (c_InputMgr::e_InputChannelIds NewInputChannelId,
     // DEBUG_V ("BufferSize: " + String (BufferSize));
     e131 = new ESPAsyncE131 (0);
 
-    memset ((void*)UniverseArray, 0x00, sizeof (UniverseArray));
-
     // DEBUG_END;
 } // c_InputE131
 
@@ -41,6 +39,13 @@ c_InputE131::~c_InputE131()
 {
     // DEBUG_START;
 
+    if (nullptr != UniverseArray)
+    {
+        free (UniverseArray);
+        UniverseArray = nullptr;
+        UniverseArraySize = 0;
+    }
+
     // DEBUG_END;
 
 } // ~c_InputE131
@@ -104,8 +109,9 @@ void c_InputE131::GetStatus (JsonObject & jsonStatus)
 
     JsonArray e131UniverseStatus = e131Status.createNestedArray (CN_channels);
     uint32_t TotalErrors = e131->stats.packet_errors;
-    for (auto & CurrentUniverse : UniverseArray)
+    for (uint16_t UniverseIndex = 0; UniverseIndex < UniverseArraySize; ++UniverseIndex)
     {
+        Universe_t & CurrentUniverse = UniverseArray[UniverseIndex];
         JsonObject e131CurrentUniverseStatus = e131UniverseStatus.createNestedObject ();
 
         e131CurrentUniverseStatus[CN_errors] = CurrentUniverse.SequenceErrorCounter;
@@ -149,7 +155,8 @@ void c_InputE131::ProcessIncomingE131Data (e131_packet_t * packet)
         // DEBUG_V ("     CurrentUniverseId: " + String(CurrentUniverseId));
         // DEBUG_V ("packet.sequence_number: " + String(packet.sequence_number));
 
-        if ((startUniverse <= CurrentUniverseId) && (LastUniverse >= CurrentUniverseId))
+        if ((startUniverse <= CurrentUniverseId) && (LastUniverse >= CurrentUniverseId) &&
+            ((CurrentUniverseId - startUniverse) < UniverseArraySize))
         {
             // Universe offset and sequence tracking
             Universe_t& CurrentUniverse = UniverseArray[CurrentUniverseId - startUniverse];
@@ -206,7 +213,8 @@ void c_InputE131::SetBufferInfo (size_t BufferSize)
         Begin ();
     }
 
-    SetBufferTranslation ();
+    // the number of universes follows the buffer size
+    validateConfiguration ();
 
     // DEBUG_END;
 
@@ -217,6 +225,26 @@ void c_InputE131::SetBufferTranslation ()
 {
     // DEBUG_START;
 
+    // one table entry for each universe we listen to. The table is only
+    // reallocated when it has to grow.
+    uint16_t NumUniversesNeeded = (LastUniverse >= startUniverse) ? (LastUniverse - startUniverse + 1) : 0;
+    if (NumUniversesNeeded > UniverseArraySize)
+    {
+        Universe_t * NewUniverseArray = (Universe_t *)malloc (NumUniversesNeeded * sizeof (Universe_t));
+        if (nullptr == NewUniverseArray)
+        {
+            logcon (String (F ("ERROR: Could not allocate the table for ")) + String (NumUniversesNeeded) + String (F (" universes.")));
+        }
+        else
+        {
+            memset ((void*)NewUniverseArray, 0x00, NumUniversesNeeded * sizeof (Universe_t));
+            Universe_t * OldUniverseArray = UniverseArray;
+            UniverseArray     = NewUniverseArray;
+            UniverseArraySize = NumUniversesNeeded;
+            free (OldUniverseArray);
+        }
+    }
+
     // for each possible universe, set the start and size
 
     size_t InputOffset = FirstUniverseChannelOffset - 1;
@@ -228,8 +256,9 @@ void c_InputE131::SetBufferTranslation ()
     // DEBUG_V (String ("    ChannelsPerUniverse:   ") + String (uint32_t (ChannelsPerUniverse)));
     // DEBUG_V (String ("    InputDataBufferSize:   ") + String (uint32_t (InputDataBufferSize)));
 
-    for (auto& CurrentUniverse : UniverseArray)
+    for (uint16_t UniverseIndex = 0; UniverseIndex < UniverseArraySize; ++UniverseIndex)
     {
+        Universe_t & CurrentUniverse = UniverseArray[UniverseIndex];
         uint16_t BytesInThisUniverse = min (BytesInUniverse, BytesLeftToMap);
         // DEBUG_V (String ("BytesInThisUniverse: 0x") + String (BytesInThisUniverse, HEX));
         CurrentUniverse.DestinationOffset = DestinationOffset;
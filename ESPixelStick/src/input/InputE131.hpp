@@ -26,7 +26,6 @@ class c_InputE131 : public c_InputCommon
   private:
     static const uint16_t   UNIVERSE_MAX = 512;
     static const char       ConfigFileName[];
-    static const uint8_t    MAX_NUM_UNIVERSES = (OM_MAX_NUM_CHANNELS / UNIVERSE_MAX) + 1;
 
     ESPAsyncE131  * e131 = nullptr; ///< ESPAsyncE131
     // e131_packet_t packet;           ///< Packet buffer for parsing
@@ -51,7 +50,8 @@ class c_InputE131 : public c_InputCommon
       uint32_t SequenceErrorCounter;
 
     } Universe_t;
-    Universe_t UniverseArray[MAX_NUM_UNIVERSES];
+    Universe_t * UniverseArray     = nullptr; ///< One entry per universe from startUniverse to LastUniverse
+    uint16_t     UniverseArraySize = 0;       ///< Number of entries allocated in UniverseArray
 
     void validateConfiguration ();
     void NetworkStateChanged (bool IsConnected, bool RebootAllowed); // used by poorly designed rx functions
@@ -164,7 +164,9 @@ bool c_InputFPPRemote::SetConfig (JsonObject& jsonConfig)
 
     // DEBUG_V ("Config Processing");
     // Clear outbuffer on config change
+    OutputMgr.BeginDirectWrite ();
     memset (OutputMgr.GetBufferAddress (), 0x0, OutputMgr.GetBufferUsedSize ());
+    OutputMgr.EndDirectWrite ();
     StartPlaying (FileToPlay);
 
     // DEBUG_END;
@@ -95,6 +95,7 @@ c_InputFPPRemotePlayFile::~c_InputFPPRemotePlayFile ()
         Stop ();
         Poll ();
     }
+    FreeFrameBuffer ();
     // DEBUG_END;
 
 } // ~c_InputFPPRemotePlayFile
@@ -467,35 +468,55 @@ void c_InputFPPRemotePlayFile::ClearFileInfo()
 
 } // ClearFileInfo
 
-size_t c_InputFPPRemotePlayFile::ReadFile(size_t DestinationIntensityId, size_t NumBytesToRead, size_t FileOffset)
+size_t c_InputFPPRemotePlayFile::ReadFile(uint8_t * pDestination, size_t NumBytesToRead, size_t FileOffset)
 {
     // DEBUG_START;
-#define WRITE_DIRECT_TO_OUTPUT_BUFFER
-#ifdef WRITE_DIRECT_TO_OUTPUT_BUFFER
+
     size_t NumBytesRead = FileMgr.ReadSdFile(FileHandleForFileBeingPlayed,
-                                             OutputMgr.GetBufferAddress(),
-                                             min((NumBytesToRead), OutputMgr.GetBufferUsedSize()),
+                                             pDestination,
+                                             NumBytesToRead,
                                              FileOffset);
-#else
-    uint8_t LocalIntensityBuffer[200];
 
-    size_t NumBytesRead = 0;
+    // DEBUG_END;
+    return NumBytesRead;
+} // ReadFile
+
+//-----------------------------------------------------------------------------
+/*
+    Returns a buffer that holds at least NumBytes or nullptr when the memory
+    is not available.
+*/
+uint8_t * c_InputFPPRemotePlayFile::GetFrameBuffer (size_t NumBytes)
+{
+    // DEBUG_START;
 
-    while (NumBytesRead < NumBytesToRead)
+    if (NumBytes > FrameBufferSize)
     {
-        size_t NumBytesReadThisPass = FileMgr.ReadSdFile(FileHandleForFileBeingPlayed,
-                                                         LocalIntensityBuffer,
-                                                         min((NumBytesToRead - NumBytesRead), sizeof(LocalIntensityBuffer)),
-                                                         FileOffset);
+        FreeFrameBuffer ();
+        pFrameBuffer = (uint8_t*)malloc (NumBytes);
+        if (nullptr != pFrameBuffer)
+        {
+            FrameBufferSize = NumBytes;
+        }
+    }
+
+    // DEBUG_END;
+    return pFrameBuffer;
+
+} // GetFrameBuffer
 
-        OutputMgr.WriteChannelData(DestinationIntensityId, NumBytesReadThisPass, LocalIntensityBuffer);
+//-----------------------------------------------------------------------------
+void c_InputFPPRemotePlayFile::FreeFrameBuffer ()
+{
+    // DEBUG_START;
 
-        FileOffset += NumBytesReadThisPass;
-        NumBytesRead += NumBytesReadThisPass;
-        DestinationIntensityId += NumBytesReadThisPass;
+    if (nullptr != pFrameBuffer)
+    {
+        free (pFrameBuffer);
+        pFrameBuffer = nullptr;
     }
-#endif // !def WRITE_DIRECT_TO_OUTPUT_BUFFER
+    FrameBufferSize = 0;
 
     // DEBUG_END;
-    return NumBytesRead;
-} // ReadFile
+
+} // FreeFrameBuffer
@@ -104,7 +104,14 @@ private:
     void        UpdateElapsedPlayTimeMS ();
     uint32_t    CalculateFrameId (uint32_t ElapsedMS, int32_t SyncOffsetMS);
     bool        ParseFseqFile ();
-    size_t      ReadFile(size_t DestinationIntensityId, size_t NumBytesToRead, size_t FileOffset);
+    size_t      ReadFile(uint8_t * pDestination, size_t NumBytesToRead, size_t FileOffset);
+    uint8_t *   GetFrameBuffer (size_t NumBytes);
+    void        FreeFrameBuffer ();
+
+    // The sparse ranges of a frame are read here and then written to the
+    // outputs with one WriteChannelDataV call.
+    uint8_t *   pFrameBuffer    = nullptr;
+    size_t      FrameBufferSize = 0;
 
     String      LastFailedPlayStatusMsg;
 
@@ -248,6 +248,20 @@ IRAM_ATTR void fsm_PlayFile_state_PlayingFile::TimerPoll ()
 
         LastPlayedFrameId = CurrentFrame;
 
+        // Read every range of the frame first, then hand them to the outputs
+        // as one locked write. Without the memory for that the ranges are
+        // read straight into the output buffer.
+        uint8_t * pFrameData = p_Parent->GetFrameBuffer (MaxBytesToRead);
+        bool      ReadDirect = (nullptr == pFrameData);
+        if (ReadDirect)
+        {
+            OutputMgr.BeginDirectWrite ();
+            pFrameData = OutputMgr.GetBufferAddress ();
+        }
+
+        c_OutputMgr::ChannelDataSpan_t FrameSpans[MAX_NUM_SPARSE_RANGES];
+        size_t NumFrameSpans = 0;
+
         for (auto& CurrentSparseRange : p_Parent->SparseRanges)
         {
             size_t ActualBytesToRead = min (MaxBytesToRead, CurrentSparseRange.ChannelCount);
@@ -263,7 +277,8 @@ IRAM_ATTR void fsm_PlayFile_state_PlayingFile::TimerPoll ()
             /// DEBUG_V (String ("         AdjustedFilePosition: ") + String (uint32_t(AdjustedFilePosition), HEX));
             /// DEBUG_V (String ("           CurrentDestination: ") + String (uint32_t(CurrentDestination), HEX));
             /// DEBUG_V (String ("            ActualBytesToRead: ") + String (ActualBytesToRead));
-            size_t ActualBytesRead = p_Parent->ReadFile(CurrentDestination, ActualBytesToRead, AdjustedFilePosition);
+            size_t ActualBytesRead = p_Parent->ReadFile(&pFrameData[CurrentDestination], ActualBytesToRead, AdjustedFilePosition);
+            FrameSpans[NumFrameSpans++] = {CurrentDestination, ActualBytesRead, &pFrameData[CurrentDestination]};
 
             MaxBytesToRead -= ActualBytesRead;
             CurrentDestination += ActualBytesRead;
@@ -281,6 +296,16 @@ IRAM_ATTR void fsm_PlayFile_state_PlayingFile::TimerPoll ()
             }
         }
 
+        if (ReadDirect)
+        {
+            OutputMgr.EndDirectWrite ();
+        }
+        else
+        {
+            OutputMgr.WriteChannelDataV (FrameSpans, NumFrameSpans);
+            OutputMgr.InputFrameComplete ();
+        }
+
         // xDEBUG_V (String ("       DataOffset: ") + String (p_Parent->DataOffset));
         // xDEBUG_V (String ("       BufferSize: ") + String (p_Parent->BufferSize));
         // xDEBUG_V (String (" ChannelsPerFrame: ") + String (p_Parent->ChannelsPerFrame));
@@ -447,6 +472,7 @@ void fsm_PlayFile_state_Stopping::Poll ()
 
     FileMgr.CloseSdFile (p_Parent->FileHandleForFileBeingPlayed);
     p_Parent->FileHandleForFileBeingPlayed = 0;
+    p_Parent->FreeFrameBuffer ();
     p_Parent->fsm_PlayFile_state_Idle_imp.Init (p_Parent);
 
     if (FileName != "")
@@ -51,6 +51,8 @@ void c_OutputAPA102::GetConfig (ArduinoJson::JsonObject& jsonConfig)
 
     c_OutputPixel::GetConfig (jsonConfig);
 
+    jsonConfig[CN_hdr] = HdrEnabled;
+
     // DEBUG_END;
 } // GetConfig
 
@@ -70,7 +72,7 @@ void c_OutputAPA102::SetOutputBufferSize (uint16_t NumChannelsAvailable)
     c_OutputPixel::SetOutputBufferSize (NumChannelsAvailable);
 
     // Calculate our refresh time
-    SetFrameDurration ( ( (1.0 / float (APA102_BIT_RATE)) * MicroSecondsInASecond), BlockSize, BlockDelay);
+    SetFrameDurration ( ( (1.0 / float (BitRate)) * MicroSecondsInASecond), BlockSize, BlockDelay);
 
     // DEBUG_END;
 
@@ -81,10 +83,14 @@ bool c_OutputAPA102::SetConfig (ArduinoJson::JsonObject& jsonConfig)
 {
     // DEBUG_START;
 
+    // The pixel layer builds the gamma tables and the prepared frame during SetConfig
+    setFromJSON (HdrEnabled, jsonConfig, CN_hdr);
+    SetHdrBrightnessHeader (HdrEnabled);
+
     bool response = c_OutputPixel::SetConfig (jsonConfig);
 
     // Calculate our refresh time
-    SetFrameDurration ( ( (1.0 / float (APA102_BIT_RATE)) * MicroSecondsInASecond), BlockSize, BlockDelay);
+    SetFrameDurration ( ( (1.0 / float (BitRate)) * MicroSecondsInASecond), BlockSize, BlockDelay);
 
     // DEBUG_END;
     return response;
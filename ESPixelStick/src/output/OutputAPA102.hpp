@@ -49,11 +49,13 @@ protected:
 #define APA102_BITS_PER_INTENSITY       8
 #define APA102_MICRO_SEC_PER_INTENSITY  int ( ( (1.0/float (APA102_BIT_RATE)) * APA102_BITS_PER_INTENSITY))
 #define APA102_MIN_IDLE_TIME_US         500
+    uint32_t       BitRate = APA102_BIT_RATE;
     uint16_t       BlockSize = 1;
     float          BlockDelay = 0;
     const uint32_t FrameStartData = 0;
     const uint32_t FrameEndData = 0xFFFFFFFF;
     const uint8_t  PixelStartData = 0xFF;     // Max driving current
+    bool           HdrEnabled = false;        ///< Use the 5 bit driving current per pixel for extra dimming resolution
 
 }; // c_OutputAPA102
 
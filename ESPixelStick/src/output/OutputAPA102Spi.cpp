@@ -32,7 +32,7 @@ c_OutputAPA102Spi::c_OutputAPA102Spi (c_OutputMgr::e_OutputChannelIds OutputChan
     // DEBUG_START;
 
     // update frame calculation
-    BlockSize = SPI_NUM_INTENSITY_PER_TRANSACTION;
+    BlockSize = SPI_FRAME_SPLIT_SIZE;
     BlockDelay = 20.0; // measured between 16 and 21 us
 
     // DEBUG_END;
@@ -73,6 +73,7 @@ void c_OutputAPA102Spi::GetConfig (ArduinoJson::JsonObject& jsonConfig)
     c_OutputAPA102::GetConfig (jsonConfig);
 
     jsonConfig[CN_clock_pin] = DEFAULT_SPI_CLOCK_GPIO;
+    jsonConfig[CN_clock_khz] = BitRate / 1000;
 
     // DEBUG_END;
 } // GetConfig
@@ -82,6 +83,12 @@ bool c_OutputAPA102Spi::SetConfig (ArduinoJson::JsonObject& jsonConfig)
 {
     // DEBUG_START;
 
+    // the frame time depends on the clock so set it up first
+    uint32_t ClockRateKHz = BitRate / 1000;
+    setFromJSON (ClockRateKHz, jsonConfig, CN_clock_khz);
+    Spi.SetClockRate (ClockRateKHz * 1000);
+    BitRate = Spi.GetClockRate ();
+
     bool response = c_OutputAPA102::SetConfig (jsonConfig);
 
     // DEBUG_END;
@@ -89,12 +96,28 @@ bool c_OutputAPA102Spi::SetConfig (ArduinoJson::JsonObject& jsonConfig)
 
 } // GetStatus
 
+//----------------------------------------------------------------------------
+void c_OutputAPA102Spi::GetStatus (ArduinoJson::JsonObject& jsonStatus)
+{
+    c_OutputAPA102::GetStatus (jsonStatus);
+    Spi.GetStatus (jsonStatus);
+
+} // GetStatus
+
 //----------------------------------------------------------------------------
 void c_OutputAPA102Spi::Render ()
 {
     // DEBUG_START;
 
-    if (canRefresh ())
+    // check the wire first. Only count a skipped frame when one was due.
+    if (Spi.IsBusy ())
+    {
+        if (canRefresh ())
+        {
+            Spi.FrameSkippedBusy ();
+        }
+    }
+    else if (canRefresh ())
     {
         if (Spi.Render ())
         {
@@ -42,8 +42,9 @@ public:
     void    Begin ();
     void    GetConfig (ArduinoJson::JsonObject& jsonConfig);
     bool    SetConfig (ArduinoJson::JsonObject& jsonConfig);  ///< Set a new config in the driver
+    void    GetStatus (ArduinoJson::JsonObject& jsonStatus);
     void    Render ();                                        ///< Call from loop (),  renders output data
-    void    PauseOutput () {};
+    void    PauseOutput (bool State) override {c_OutputAPA102::PauseOutput (State); Spi.PauseOutput (State);}
 
 private:
 
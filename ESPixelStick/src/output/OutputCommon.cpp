@@ -37,6 +37,7 @@ c_OutputCommon::c_OutputCommon (c_OutputMgr::e_OutputChannelIds _OutputChannelId
 	UartId                   = uart;
     OutputType               = outputType;
     pOutputBuffer            = OutputMgr.GetBufferAddress ();
+    pBackBuffer              = pOutputBuffer;
     FrameStartTimeInMicroSec = 0;
 
 	// logcon (String ("UartId:          '") + UartId + "'");
@@ -59,7 +60,8 @@ void c_OutputCommon::ClearBuffer ()
 {
     // DEBUG_START;
 
-    memset(GetBufferAddress(), 0x00, GetBufferUsedSize());
+    memset(pBackBuffer, 0x00, GetBufferUsedSize());
+    MarkAllDataChanged ();
 
     // DEBUG_END;
 } // ClearBuffer
@@ -72,6 +74,21 @@ void c_OutputCommon::GetStatus (JsonObject & jsonStatus)
     jsonStatus[CN_id] = OutputChannelId;
     jsonStatus["framerefreshrate"] = (0 == FrameRefreshTimeInMicroSec) ? 0 : int(MicroSecondsInASecond / FrameRefreshTimeInMicroSec);
     jsonStatus["FrameCount"] = FrameCount;
+    if (pBackBuffer != pOutputBuffer)
+    {
+        jsonStatus[F("FramesSwapped")] = FramesSwapped;
+        jsonStatus[F("FramesDropped")] = FramesDropped;
+    }
+    if (RefreshesSkipped)
+    {
+        jsonStatus[F("RefreshesSkipped")] = RefreshesSkipped;
+    }
+    jsonStatus[F("MaxRefreshRate")]      = (0 == FrameMinDurationInMicroSec) ? 0 : uint32_t (MicroSecondsInASecond / FrameMinDurationInMicroSec);
+    jsonStatus[F("AchievedRefreshRate")] = PacingStats.AchievedRefreshRate;
+    jsonStatus[F("MissedDeadlines")]     = PacingStats.MissedDeadlines;
+    jsonStatus[F("JitterUs")]            = PacingStats.LastFrameStartJitterInMicroSec;
+    jsonStatus[F("AvgJitterUs")]         = PacingStats.AverageFrameStartJitterInMicroSec;
+    jsonStatus[F("MaxJitterUs")]         = PacingStats.MaxFrameStartJitterInMicroSec;
 
     // DEBUG_END;
 } // GetStatus
@@ -85,12 +102,236 @@ void c_OutputCommon::ReportNewFrame ()
     FrameRefreshTimeInMicroSec = Now - FrameStartTimeInMicroSec;
     FrameStartTimeInMicroSec = Now;
 
+    // frames that hold mode skipped are not late
+    bool CheckDeadline = FrameCount && (RefreshesSkipped == RefreshesSkippedAtLastFrame);
+    PacingStats.FrameStarted (Now, FrameRefreshTimeInMicroSec, GetFrameDurationInMicroSec (), CheckDeadline);
+    RefreshesSkippedAtLastFrame = RefreshesSkipped;
+
     FrameCount++;
 
     // DEBUG_END;
 
 } // ReportNewFrame
 
+//----------------------------------------------------------------------------
+/*
+    Called in task context by the driver just before it starts to send a new
+    frame. Copies the data the inputs have written into the back buffer into
+    the front buffer that the ISR / transmit path reads from. Nothing is done
+    if double buffering is not active or the data has not changed.
+*/
+void c_OutputCommon::LatchFrame ()
+{
+    // DEBUG_START;
+
+    if ((pBackBuffer != pOutputBuffer) && (LatchedGeneration != DataGeneration))
+    {
+        // the inputs must not write while the copy is made
+        OutputMgr.LockBackBuffer ();
+
+        LatchedGeneration = DataGeneration;
+        memcpy (pOutputBuffer, pBackBuffer, OutputBufferSize);
+
+        OutputMgr.UnlockBackBuffer ();
+
+        if (NumPendingFrames)
+        {
+            FramesSwapped++;
+            FramesDropped += NumPendingFrames - 1;
+            NumPendingFrames = 0;
+        }
+    }
+
+    // DEBUG_END;
+
+} // LatchFrame
+
+//----------------------------------------------------------------------------
+void c_OutputCommon::MarkDataChanged (size_t StartChannelId, size_t ChannelCount)
+{
+    // DEBUG_START;
+
+    size_t EndChannelId = StartChannelId + ChannelCount;
+
+    EnterDirtyLock ();
+
+    if (DirtyStartChannelId >= DirtyEndChannelId)
+    {
+        DirtyStartChannelId = StartChannelId;
+        DirtyEndChannelId   = EndChannelId;
+    }
+    else
+    {
+        DirtyStartChannelId = min (DirtyStartChannelId, StartChannelId);
+        DirtyEndChannelId   = max (DirtyEndChannelId,   EndChannelId);
+    }
+
+    ++DataGeneration;
+
+    ExitDirtyLock ();
+
+    // DEBUG_END;
+
+} // MarkDataChanged
+
+//----------------------------------------------------------------------------
+void c_OutputCommon::MarkAllDataChanged ()
+{
+    // DEBUG_START;
+
+    EnterDirtyLock ();
+
+    DirtyStartChannelId = 0;
+    DirtyEndChannelId   = size_t (-1);
+    ++DataGeneration;
+
+    ExitDirtyLock ();
+
+    // DEBUG_END;
+
+} // MarkAllDataChanged
+
+//----------------------------------------------------------------------------
+/*
+    Time until this output can start its next frame. Used to schedule the
+    output task. Hold mode is not checked here.
+*/
+uint32_t c_OutputCommon::GetTimeToNextFrameInMicroSec ()
+{
+    uint32_t TimeSinceFrameStart    = micros () - FrameStartTimeInMicroSec;
+    uint32_t FrameDurationInMicroSec = GetFrameDurationInMicroSec ();
+
+    return (TimeSinceFrameStart >= FrameDurationInMicroSec) ? 0 : (FrameDurationInMicroSec - TimeSinceFrameStart);
+
+} // GetTimeToNextFrameInMicroSec
+
+//----------------------------------------------------------------------------
+/*
+    Only checks the change tracking. The driver calls RefreshStarted once
+    the frame is actually going out and RefreshSkipped when it is not.
+*/
+bool c_OutputCommon::FrameIsUnchanged ()
+{
+    return SkipUnchangedFrames && !RefreshPending ();
+
+} // FrameIsUnchanged
+
+//----------------------------------------------------------------------------
+/*
+    The drivers poll much faster than the frame rate. Only the first skip
+    in each frame period is counted.
+*/
+void c_OutputCommon::RefreshSkipped ()
+{
+    uint32_t Now = micros ();
+
+    if ((Now - LastRefreshSkippedTimeInMicroSec) >= GetFrameDurationInMicroSec ())
+    {
+        LastRefreshSkippedTimeInMicroSec = Now;
+        ++RefreshesSkipped;
+    }
+
+} // RefreshSkipped
+
+//----------------------------------------------------------------------------
+/*
+    True when data changed since the last refresh or the keep alive is due.
+    Nothing is consumed.
+*/
+bool c_OutputCommon::RefreshPending ()
+{
+    EnterDirtyLock ();
+    bool response = (DataGeneration != RefreshedGeneration);
+    ExitDirtyLock ();
+
+    if (!response && KeepAliveIntervalMs)
+    {
+        response = ((millis () - LastRefreshTimeMs) >= KeepAliveIntervalMs);
+    }
+
+    return response;
+
+} // RefreshPending
+
+//----------------------------------------------------------------------------
+/*
+    Called when a whole frame starts to go out. Everything marked so far is
+    in this frame and the keep alive restarts.
+*/
+void c_OutputCommon::RefreshStarted ()
+{
+    // DEBUG_START;
+
+    EnterDirtyLock ();
+
+    RefreshedGeneration = DataGeneration;
+    DirtyStartChannelId = 0;
+    DirtyEndChannelId   = 0;
+
+    ExitDirtyLock ();
+
+    LastRefreshTimeMs = millis ();
+
+    // DEBUG_END;
+
+} // RefreshStarted
+
+//----------------------------------------------------------------------------
+/*
+    Called by drivers that only send when something changed. Returns the
+    range of channels changed since the last refresh. When nothing changed
+    the whole buffer is returned once every KeepAliveIntervalMs.
+*/
+bool c_OutputCommon::RefreshNeeded (size_t & StartChannelId, size_t & EndChannelId)
+{
+    // DEBUG_START;
+
+    bool response = false;
+    uint32_t Now = millis ();
+
+    do // once
+    {
+        EnterDirtyLock ();
+        uint32_t CurrentGeneration = DataGeneration;
+        if (CurrentGeneration != RefreshedGeneration)
+        {
+            RefreshedGeneration = CurrentGeneration;
+            StartChannelId      = DirtyStartChannelId;
+            EndChannelId        = min (DirtyEndChannelId, OutputBufferSize);
+            DirtyStartChannelId = 0;
+            DirtyEndChannelId   = 0;
+            response = true;
+        }
+        ExitDirtyLock ();
+
+        if (response)
+        {
+            break;
+        }
+
+        if (KeepAliveIntervalMs && ((Now - LastRefreshTimeMs) >= KeepAliveIntervalMs))
+        {
+            StartChannelId = 0;
+            EndChannelId   = OutputBufferSize;
+            response = true;
+            break;
+        }
+
+        RefreshSkipped ();
+
+    } while (false);
+
+    if (response)
+    {
+        LastRefreshTimeMs = Now;
+    }
+
+    // DEBUG_END;
+
+    return response;
+
+} // RefreshNeeded
+
 //----------------------------------------------------------------------------
 bool c_OutputCommon::SetConfig (JsonObject & jsonConfig)
 {
@@ -122,16 +363,24 @@ void c_OutputCommon::GetConfig (JsonObject & jsonConfig)
 } // GetConfig
 
 //----------------------------------------------------------------------------
-void c_OutputCommon::WriteChannelData (size_t StartChannelId, size_t ChannelCount, byte * pSourceData)
+bool c_OutputCommon::WriteChannelData (size_t StartChannelId, size_t ChannelCount, byte * pSourceData)
 {
     // DEBUG_START;
 
     // DEBUG_V(String("               StartChannelId: 0x") + String(StartChannelId, HEX));
     // DEBUG_V(String("&OutputBuffer[StartChannelId]: 0x") + String(uint(&OutputBuffer[StartChannelId]), HEX));
-    memcpy(&pOutputBuffer[StartChannelId], pSourceData, ChannelCount);
+    // only touch the buffer when the data actually changed
+    bool response = (0 != memcmp(&pBackBuffer[StartChannelId], pSourceData, ChannelCount));
+    if (response)
+    {
+        memcpy(&pBackBuffer[StartChannelId], pSourceData, ChannelCount);
+        MarkDataChanged (StartChannelId, ChannelCount);
+    }
 
     // DEBUG_END;
 
+    return response;
+
 } // WriteChannelData
 
 //----------------------------------------------------------------------------
@@ -141,7 +390,7 @@ void c_OutputCommon::ReadChannelData(size_t StartChannelId, size_t ChannelCount,
 
     // DEBUG_V(String("               StartChannelId: 0x") + String(StartChannelId, HEX));
     // DEBUG_V(String("&OutputBuffer[StartChannelId]: 0x") + String(uint(&OutputBuffer[StartChannelId]), HEX));
-    memcpy(pTargetData, &pOutputBuffer[StartChannelId], ChannelCount);
+    memcpy(pTargetData, &pBackBuffer[StartChannelId], ChannelCount);
 
     // DEBUG_END;
 
@@ -22,6 +22,7 @@
 
 #include "../ESPixelStick.h"
 #include "OutputMgr.hpp"
+#include "OutputFramePacing.hpp"
 
 #ifdef ARDUINO_ARCH_ESP32
 #   include <driver/uart.h>
@@ -50,12 +51,19 @@ public:
             size_t       GetBufferUsedSize ()  { return OutputBufferSize;}     ///< Get the address of the buffer into which the E1.31 handler will stuff data
             OTYPE_t      GetOutputType ()      { return OutputType; }          ///< Have the instance report its type.
     virtual void         GetStatus (ArduinoJson::JsonObject & jsonStatus);
-            void         SetOutputBufferAddress (uint8_t* pNewOutputBuffer) { pOutputBuffer = pNewOutputBuffer; }
-    virtual void         SetOutputBufferSize (size_t NewOutputBufferSize)  { OutputBufferSize = NewOutputBufferSize; };
+            void         SetOutputBufferAddress (uint8_t* pNewOutputBuffer) { pOutputBuffer = pNewOutputBuffer; pBackBuffer = pNewOutputBuffer; MarkAllDataChanged (); }
+            void         SetBackBufferAddress (uint8_t* pNewBackBuffer)     { pBackBuffer = pNewBackBuffer; MarkAllDataChanged (); }  ///< Buffer written by the inputs when double buffering is active
+            void         NewFrameAvailable ()  { ++NumPendingFrames; }       ///< Input data for this output changed since the last manager render pass
+            void         MarkDataChanged (size_t StartChannelId, size_t ChannelCount); ///< Record the range of channels the inputs changed
+            void         MarkAllDataChanged ();
+    virtual bool         FrameIsUnchanged ();                                  ///< Hold mode is on and there is nothing new to send. Does not consume the change.
+            void         RefreshSkipped ();                                    ///< A frame was due and the driver did not send it. Counted once per frame period.
+    virtual void         SetOutputBufferSize (size_t NewOutputBufferSize)  { OutputBufferSize = NewOutputBufferSize; MarkAllDataChanged (); };
     virtual size_t       GetNumChannelsNeeded () = 0;
+            uint32_t     GetTimeToNextFrameInMicroSec ();                        ///< 0 when a new frame is due now
     virtual void         PauseOutput (bool State) {}
     virtual void         ClearBuffer ();
-    virtual void         WriteChannelData (size_t StartChannelId, size_t ChannelCount, byte *pSourceData);
+    virtual bool         WriteChannelData (size_t StartChannelId, size_t ChannelCount, byte *pSourceData); ///< Returns true when the data changed
     virtual void         ReadChannelData (size_t StartChannelId, size_t ChannelCount, byte *pTargetData);
 
 protected:
@@ -65,20 +73,63 @@ protected:
     OTYPE_t     OutputType                 = OTYPE_t::OutputType_Disabled;
     OID_t       OutputChannelId            = OID_t::OutputChannelId_End;
     bool        HasBeenInitialized         = false;
-    uint32_t    FrameMinDurationInMicroSec = 25000;
+    uint32_t    FrameMinDurationInMicroSec = 25000;     ///< Time needed to put one frame on the wire
+    uint32_t    TargetRefreshRate          = OM_DEFAULT_REFRESH_RATE; ///< Frames per second. 0 = as fast as the wire allows
     uint8_t   * pOutputBuffer              = nullptr;
     size_t      OutputBufferSize           = 0;
     uint32_t    FrameCount                 = 0;
+    uint8_t   * pBackBuffer                = nullptr;
+    bool        SkipUnchangedFrames        = false;
+    uint32_t    KeepAliveIntervalMs        = 1000;      ///< Resend unchanged data this often. 0 = never
 
     void ReportNewFrame ();
+    void LatchFrame ();
+    bool RefreshPending ();
+    void RefreshStarted ();
+    bool RefreshNeeded (size_t & StartChannelId, size_t & EndChannelId);
+
+    inline uint32_t GetFrameDurationInMicroSec ()
+    {
+        return FramePacingDurationInMicroSec (FrameMinDurationInMicroSec, TargetRefreshRate);
+    }
 
     inline bool canRefresh ()
     {
-        return (micros () - FrameStartTimeInMicroSec) >= FrameMinDurationInMicroSec;
+        bool response = ((micros () - FrameStartTimeInMicroSec) >= GetFrameDurationInMicroSec ());
+        if (response && FrameIsUnchanged ())
+        {
+            RefreshSkipped ();
+            response = false;
+        }
+        return response;
     }
 
 private:
     uint32_t    FrameRefreshTimeInMicroSec = 0;
     uint32_t    FrameStartTimeInMicroSec   = 0;
+    uint32_t    NumPendingFrames           = 0;
+    uint32_t    FramesSwapped              = 0;
+    uint32_t    FramesDropped              = 0;
+    uint32_t    DataGeneration             = 0;
+    uint32_t    LatchedGeneration          = uint32_t (-1);
+    uint32_t    RefreshedGeneration        = uint32_t (-1);
+    size_t      DirtyStartChannelId        = 0;
+    size_t      DirtyEndChannelId          = 0;
+    uint32_t    LastRefreshTimeMs          = 0;
+    uint32_t    RefreshesSkipped           = 0;
+    uint32_t    RefreshesSkippedAtLastFrame = 0;
+    uint32_t    LastRefreshSkippedTimeInMicroSec = 0;
+    c_FramePacingStats PacingStats;
+
+    // The inputs mark changes while the output task consumes them
+#ifdef ARDUINO_ARCH_ESP32
+    portMUX_TYPE DirtyLock                 = portMUX_INITIALIZER_UNLOCKED;
+    inline void EnterDirtyLock () { portENTER_CRITICAL_SAFE (&DirtyLock); }
+    inline void ExitDirtyLock ()  { portEXIT_CRITICAL_SAFE (&DirtyLock); }
+#else
+    // the ESP8266 inputs and outputs all run in the loop context
+    inline void EnterDirtyLock () {}
+    inline void ExitDirtyLock ()  {}
+#endif // def ARDUINO_ARCH_ESP32
 
 }; // c_OutputCommon
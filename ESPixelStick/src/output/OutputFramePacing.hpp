@@ -0,0 +1,116 @@
+#pragma once
+/*
+* OutputFramePacing.hpp - Frame timing and refresh rate statistics
+*
+* Project: ESPixelStick - An ESP8266 / ESP32 and E1.31 based pixel driver
+* Copyright (c) 2021, 2022 Shelby Merrick
+* http://www.forkineye.com
+*
+*  This program is provided free for you to use in any way that you wish,
+*  subject to the laws and regulations where you are using it.  Due diligence
+*  is strongly suggested before using this code.  Please give credit where due.
+*
+*  The Author makes no warranty of any kind, express or implied, with regard
+*  to this program or the documentation contained in this document.  The
+*  Author shall not be liable in any event for incidental or consequential
+*  damages in connection with, or arising out of, the furnishing, performance
+*  or use of these programs.
+*
+*   An output may not start a frame until the previous one is off the wire
+*   (the wire time) and the configured refresh rate allows it. The
+*   statistics report how close the output gets to that schedule.
+*
+*/
+
+#include <stdint.h>
+
+#define FRAME_PACING_US_PER_SECOND      uint32_t (1000000)
+
+//----------------------------------------------------------------------------
+/*
+    Time needed to clock one frame out: every bit, the reset / inter frame
+    gap and the pauses some protocols need after each block of data.
+*/
+inline uint32_t FramePacingWireTimeInMicroSec (float    TotalBytesOfIntensityData,
+                                               float    BitsPerIntensity,
+                                               float    IntensityBitTimeInUs,
+                                               uint32_t InterFrameGapInMicroSec,
+                                               uint16_t BlockSize,
+                                               float    BlockDelayUs)
+{
+    if (0 == BlockSize) { BlockSize = 1; }
+
+    float    TotalBits         = TotalBytesOfIntensityData * BitsPerIntensity;
+    uint16_t NumBlocks         = uint16_t (TotalBytesOfIntensityData / float (BlockSize));
+    int      TotalBlockDelayUs = int (float (NumBlocks) * BlockDelayUs);
+
+    return uint32_t ((IntensityBitTimeInUs * TotalBits) + InterFrameGapInMicroSec + TotalBlockDelayUs);
+
+} // FramePacingWireTimeInMicroSec
+
+//----------------------------------------------------------------------------
+/*
+    The refresh rate can only slow the output down from the wire time.
+    A rate of 0 sends as fast as the wire allows.
+*/
+inline uint32_t FramePacingDurationInMicroSec (uint32_t FrameMinDurationInMicroSec, uint32_t TargetRefreshRate)
+{
+    if (0 == TargetRefreshRate)
+    {
+        return FrameMinDurationInMicroSec;
+    }
+
+    uint32_t TargetDurationInMicroSec = FRAME_PACING_US_PER_SECOND / TargetRefreshRate;
+    return (FrameMinDurationInMicroSec > TargetDurationInMicroSec) ? FrameMinDurationInMicroSec : TargetDurationInMicroSec;
+
+} // FramePacingDurationInMicroSec
+
+//----------------------------------------------------------------------------
+class c_FramePacingStats
+{
+public:
+    uint32_t AchievedRefreshRate               = 0;
+    uint32_t MissedDeadlines                   = 0;
+    uint32_t LastFrameStartJitterInMicroSec    = 0;
+    uint32_t MaxFrameStartJitterInMicroSec     = 0;
+    uint32_t AverageFrameStartJitterInMicroSec = 0;
+
+    /*
+        Called as each frame starts. FrameRefreshTimeInMicroSec is the time
+        since the previous frame started. Frames that something held back
+        on purpose (hold mode) are not checked against the deadline.
+    */
+    void FrameStarted (uint32_t NowInMicroSec, uint32_t FrameRefreshTimeInMicroSec, uint32_t FrameDurationInMicroSec, bool CheckDeadline)
+    {
+        if (CheckDeadline)
+        {
+            // started more than half a frame period after it was due
+            if (FrameRefreshTimeInMicroSec > (FrameDurationInMicroSec + (FrameDurationInMicroSec >> 1)))
+            {
+                MissedDeadlines++;
+            }
+            else
+            {
+                // how late this frame started compared to when it was scheduled
+                LastFrameStartJitterInMicroSec    = (FrameRefreshTimeInMicroSec > FrameDurationInMicroSec) ? (FrameRefreshTimeInMicroSec - FrameDurationInMicroSec) : 0;
+                MaxFrameStartJitterInMicroSec     = (MaxFrameStartJitterInMicroSec > LastFrameStartJitterInMicroSec) ? MaxFrameStartJitterInMicroSec : LastFrameStartJitterInMicroSec;
+                AverageFrameStartJitterInMicroSec = ((AverageFrameStartJitterInMicroSec * 15) + LastFrameStartJitterInMicroSec) / 16;
+            }
+        }
+
+        // average over about one second
+        ++RateWindowFrameCount;
+        uint32_t RateWindowTimeInMicroSec = NowInMicroSec - RateWindowStartTimeInMicroSec;
+        if (RateWindowTimeInMicroSec >= FRAME_PACING_US_PER_SECOND)
+        {
+            AchievedRefreshRate = (RateWindowFrameCount * (FRAME_PACING_US_PER_SECOND / 1000)) / (RateWindowTimeInMicroSec / 1000);
+            RateWindowStartTimeInMicroSec = NowInMicroSec;
+            RateWindowFrameCount = 0;
+        }
+    }
+
+private:
+    uint32_t RateWindowStartTimeInMicroSec     = 0;
+    uint32_t RateWindowFrameCount              = 0;
+
+}; // c_FramePacingStats
@@ -102,7 +102,7 @@ bool c_OutputGECERmt::SetConfig (ArduinoJson::JsonObject& jsonConfig)
     bool response = c_OutputGECE::SetConfig (jsonConfig);
 
     Rmt.set_pin (DataPin);
-    Rmt.SetMinFrameDurationInUs (FrameMinDurationInMicroSec);
+    Rmt.SetMinFrameDurationInUs (GetFrameDurationInMicroSec ());
 
     // DEBUG_END;
     return response;
@@ -115,7 +115,7 @@ void c_OutputGECERmt::SetOutputBufferSize (uint16_t NumChannelsAvailable)
     // DEBUG_START;
 
     c_OutputGECE::SetOutputBufferSize (NumChannelsAvailable);
-    Rmt.SetMinFrameDurationInUs (FrameMinDurationInMicroSec);
+    Rmt.SetMinFrameDurationInUs (GetFrameDurationInMicroSec ());
 
     // DEBUG_END;
 
@@ -111,7 +111,7 @@ bool c_OutputGS8208Rmt::SetConfig (ArduinoJson::JsonObject& jsonConfig)
     Rmt.SetIntensity2Rmt (BitValue, c_OutputRmt::RmtDataBitIdType_t::RMT_INTERFRAME_GAP_ID);
 
     Rmt.set_pin (DataPin);
-    Rmt.SetMinFrameDurationInUs (FrameMinDurationInMicroSec);
+    Rmt.SetMinFrameDurationInUs (GetFrameDurationInMicroSec ());
 
     // DEBUG_END;
     return response;
@@ -124,7 +124,7 @@ void c_OutputGS8208Rmt::SetOutputBufferSize (uint16_t NumChannelsAvailable)
     // DEBUG_START;
 
     c_OutputGS8208::SetOutputBufferSize (NumChannelsAvailable);
-    Rmt.SetMinFrameDurationInUs (FrameMinDurationInMicroSec);
+    Rmt.SetMinFrameDurationInUs (GetFrameDurationInMicroSec ());
 
     // DEBUG_END;
 
@@ -0,0 +1,598 @@
+/*
+* OutputI2s.cpp - I2S parallel driver code for ESPixelStick
+*
+* Project: ESPixelStick - An ESP8266 / ESP32 and E1.31 based pixel driver
+* Copyright (c) 2015, 2022 Shelby Merrick
+* http://www.forkineye.com
+*
+*  This program is provided free for you to use in any way that you wish,
+*  subject to the laws and regulations where you are using it.  Due diligence
+*  is strongly suggested before using this code.  Please give credit where due.
+*
+*  The Author makes no warranty of any kind, express or implied, with regard
+*  to this program or the documentation contained in this document.  The
+*  Author shall not be liable in any event for incidental or consequential
+*  damages in connection with, or arising out of, the furnishing, performance
+*  or use of these programs.
+*
+*/
+#include "../ESPixelStick.h"
+#ifdef SUPPORT_I2S_OUTPUT
+
+#include "OutputI2s.hpp"
+#include <driver/periph_ctrl.h>
+#include <esp_heap_caps.h>
+#include <soc/gpio_sig_map.h>
+#include <soc/i2s_reg.h>
+
+//----------------------------------------------------------------------------
+/* shell function to set the 'this' pointer of the real ISR
+   This allows me to use non static variables in the ISR.
+ */
+static void IRAM_ATTR i2s_intr_handler (void* param)
+{
+    if (param)
+    {
+        reinterpret_cast<c_OutputI2s *>(param)->ISR_Handler ();
+    }
+
+} // i2s_intr_handler
+
+//----------------------------------------------------------------------------
+c_OutputI2s::c_OutputI2s ()
+{
+    // DEBUG_START;
+
+    memset ((void*)DmaBufferIsIdle, 0x00, sizeof (DmaBufferIsIdle));
+
+    // DEBUG_END;
+} // c_OutputI2s
+
+//----------------------------------------------------------------------------
+c_OutputI2s::~c_OutputI2s ()
+{
+    // DEBUG_START;
+
+    Terminate ();
+
+    // DEBUG_END;
+} // ~c_OutputI2s
+
+//----------------------------------------------------------------------------
+/*
+    Called when the first lane is added. Allocates the DMA ring and sets up
+    the I2S peripheral for 16 bit parallel (LCD) output.
+*/
+bool c_OutputI2s::Initialize ()
+{
+    // DEBUG_START;
+
+    do // once
+    {
+        if (HasBeenInitialized)
+        {
+            break;
+        }
+
+        pDmaBuffers     = (uint16_t *)heap_caps_malloc (I2S_NUM_DMA_BUFFERS * I2S_DMA_BUFFER_SIZE, MALLOC_CAP_DMA | MALLOC_CAP_8BIT);
+        pDmaDescriptors = (lldesc_t *)heap_caps_malloc (I2S_NUM_DMA_BUFFERS * sizeof (lldesc_t), MALLOC_CAP_DMA | MALLOC_CAP_8BIT);
+        if ((nullptr == pDmaBuffers) || (nullptr == pDmaDescriptors))
+        {
+            logcon (F ("ERROR: Could not allocate the I2S DMA buffers"));
+            Terminate ();
+            break;
+        }
+        memset ((void*)pDmaBuffers, 0x00, I2S_NUM_DMA_BUFFERS * I2S_DMA_BUFFER_SIZE);
+
+        // link the buffers into a ring. Every buffer raises an EOF interrupt when it has been sent.
+        for (uint32_t BufferIndex = 0; BufferIndex < I2S_NUM_DMA_BUFFERS; ++BufferIndex)
+        {
+            lldesc_t * pDescriptor  = &pDmaDescriptors[BufferIndex];
+            pDescriptor->size       = I2S_DMA_BUFFER_SIZE;
+            pDescriptor->length     = I2S_DMA_BUFFER_SIZE;
+            pDescriptor->offset     = 0;
+            pDescriptor->sosf       = 0;
+            pDescriptor->eof        = 1;
+            pDescriptor->owner      = 1;
+            pDescriptor->buf        = (uint8_t *)&pDmaBuffers[BufferIndex * I2S_DMA_BUFFER_WORDS];
+            pDescriptor->qe.stqe_next = &pDmaDescriptors[(BufferIndex + 1) % I2S_NUM_DMA_BUFFERS];
+            DmaBufferIsIdle[BufferIndex] = true;
+        }
+
+        periph_module_enable (I2S_PARALLEL_PERIPH_MODULE);
+
+        I2S_PARALLEL_DEVICE.conf.tx_reset           = 1;
+        I2S_PARALLEL_DEVICE.conf.tx_reset           = 0;
+        I2S_PARALLEL_DEVICE.conf.tx_fifo_reset      = 1;
+        I2S_PARALLEL_DEVICE.conf.tx_fifo_reset      = 0;
+        I2S_PARALLEL_DEVICE.lc_conf.out_rst         = 1;
+        I2S_PARALLEL_DEVICE.lc_conf.out_rst         = 0;
+        I2S_PARALLEL_DEVICE.lc_conf.ahbm_rst        = 1;
+        I2S_PARALLEL_DEVICE.lc_conf.ahbm_rst        = 0;
+        I2S_PARALLEL_DEVICE.lc_conf.ahbm_fifo_rst   = 1;
+        I2S_PARALLEL_DEVICE.lc_conf.ahbm_fifo_rst   = 0;
+
+        // parallel output, 16 bits per slot
+        I2S_PARALLEL_DEVICE.conf2.val               = 0;
+        I2S_PARALLEL_DEVICE.conf2.lcd_en            = 1;
+        I2S_PARALLEL_DEVICE.conf2.lcd_tx_wrx2_en    = 0;
+        I2S_PARALLEL_DEVICE.conf2.lcd_tx_sdx2_en    = 0;
+
+        I2S_PARALLEL_DEVICE.sample_rate_conf.val            = 0;
+        I2S_PARALLEL_DEVICE.sample_rate_conf.tx_bits_mod    = 16;
+        I2S_PARALLEL_DEVICE.sample_rate_conf.tx_bck_div_num = 1;
+
+        // slot rate = base / (num + b/a)
+        float    Divider  = I2S_BASE_CLOCK_HZ / I2S_SLOT_RATE_HZ;
+        uint32_t DivNum   = uint32_t (Divider);
+        uint32_t DivA     = 63;
+        uint32_t DivB     = uint32_t (((Divider - float (DivNum)) * float (DivA)) + 0.5);
+        I2S_PARALLEL_DEVICE.clkm_conf.val           = 0;
+        I2S_PARALLEL_DEVICE.clkm_conf.clka_en       = 0;
+        I2S_PARALLEL_DEVICE.clkm_conf.clkm_div_num  = DivNum;
+        I2S_PARALLEL_DEVICE.clkm_conf.clkm_div_a    = DivA;
+        I2S_PARALLEL_DEVICE.clkm_conf.clkm_div_b    = DivB;
+
+        I2S_PARALLEL_DEVICE.fifo_conf.val                   = 0;
+        I2S_PARALLEL_DEVICE.fifo_conf.tx_fifo_mod_force_en  = 1;
+        I2S_PARALLEL_DEVICE.fifo_conf.tx_fifo_mod           = 1;    // 16 bit single channel
+        I2S_PARALLEL_DEVICE.fifo_conf.tx_data_num           = 32;
+        I2S_PARALLEL_DEVICE.fifo_conf.dscr_en               = 1;
+
+        I2S_PARALLEL_DEVICE.conf1.val               = 0;
+        I2S_PARALLEL_DEVICE.conf1.tx_stop_en        = 0;
+        I2S_PARALLEL_DEVICE.conf1.tx_pcm_bypass     = 1;
+
+        I2S_PARALLEL_DEVICE.conf_chan.val           = 0;
+        I2S_PARALLEL_DEVICE.conf_chan.tx_chan_mod   = 1;
+
+        I2S_PARALLEL_DEVICE.timing.val              = 0;
+
+        I2S_PARALLEL_DEVICE.int_ena.val             = 0;
+        I2S_PARALLEL_DEVICE.int_clr.val             = UINT32_MAX;
+
+        if (ESP_OK != esp_intr_alloc (I2S_PARALLEL_INTR_SOURCE, ESP_INTR_FLAG_IRAM | ESP_INTR_FLAG_LEVEL1, i2s_intr_handler, this, &IsrHandle))
+        {
+            logcon (F ("ERROR: Could not allocate the I2S interrupt"));
+            Terminate ();
+            break;
+        }
+
+        HasBeenInitialized = true;
+
+    } while (false);
+
+    // DEBUG_END;
+
+    return HasBeenInitialized;
+
+} // Initialize
+
+//----------------------------------------------------------------------------
+void c_OutputI2s::Terminate ()
+{
+    // DEBUG_START;
+
+    if (HasBeenInitialized)
+    {
+        StopDma ();
+        I2S_PARALLEL_DEVICE.int_ena.val = 0;
+        I2S_PARALLEL_DEVICE.int_clr.val = UINT32_MAX;
+        periph_module_disable (I2S_PARALLEL_PERIPH_MODULE);
+        HasBeenInitialized = false;
+    }
+
+    if (NULL != IsrHandle)
+    {
+        esp_intr_free (IsrHandle);
+        IsrHandle = NULL;
+    }
+
+    if (pDmaBuffers)
+    {
+        free (pDmaBuffers);
+        pDmaBuffers = nullptr;
+    }
+
+    if (pDmaDescriptors)
+    {
+        free (pDmaDescriptors);
+        pDmaDescriptors = nullptr;
+    }
+
+    // DEBUG_END;
+} // Terminate
+
+//----------------------------------------------------------------------------
+void c_OutputI2s::AddLane (uint32_t LaneId, gpio_num_t DataPin, c_OutputPixel * pPixelDataSource)
+{
+    // DEBUG_START;
+
+    do // once
+    {
+        if ((LaneId >= I2S_MAX_LANES) || (nullptr == pPixelDataSource))
+        {
+            logcon (String (F ("ERROR: Invalid I2S lane: ")) + String (LaneId));
+            break;
+        }
+
+        if (!Initialize ())
+        {
+            break;
+        }
+
+        portENTER_CRITICAL (&IsrLock);
+        Lanes[LaneId].pPixelDataSource = pPixelDataSource;
+        LaneMask |= uint16_t (1 << LaneId);
+        portEXIT_CRITICAL (&IsrLock);
+
+        SetLanePin (LaneId, DataPin);
+
+    } while (false);
+
+    // DEBUG_END;
+} // AddLane
+
+//----------------------------------------------------------------------------
+void c_OutputI2s::RemoveLane (uint32_t LaneId)
+{
+    // DEBUG_START;
+
+    do // once
+    {
+        if ((LaneId >= I2S_MAX_LANES) || (nullptr == Lanes[LaneId].pPixelDataSource))
+        {
+            break;
+        }
+
+        // the ISR must not pull data from a lane that is going away
+        StopDma ();
+
+        portENTER_CRITICAL (&IsrLock);
+        LaneMask &= ~uint16_t (1 << LaneId);
+        Lanes[LaneId].pPixelDataSource = nullptr;
+        portEXIT_CRITICAL (&IsrLock);
+
+        if (gpio_num_t (-1) != Lanes[LaneId].DataPin)
+        {
+            gpio_matrix_out (Lanes[LaneId].DataPin, SIG_GPIO_OUT_IDX, false, false);
+            digitalWrite (Lanes[LaneId].DataPin, LOW);
+        }
+        Lanes[LaneId] = Lane_t ();
+        UpdateTiming ();
+
+        if (0 == LaneMask)
+        {
+            Terminate ();
+        }
+
+    } while (false);
+
+    // DEBUG_END;
+} // RemoveLane
+
+//----------------------------------------------------------------------------
+void c_OutputI2s::SetLanePin (uint32_t LaneId, gpio_num_t DataPin)
+{
+    // DEBUG_START;
+
+    do // once
+    {
+        if ((LaneId >= I2S_MAX_LANES) || (DataPin == Lanes[LaneId].DataPin))
+        {
+            break;
+        }
+
+        if (gpio_num_t (-1) != Lanes[LaneId].DataPin)
+        {
+            gpio_matrix_out (Lanes[LaneId].DataPin, SIG_GPIO_OUT_IDX, false, false);
+        }
+
+        Lanes[LaneId].DataPin = DataPin;
+        if (gpio_num_t (-1) != DataPin)
+        {
+            pinMode (DataPin, OUTPUT);
+            gpio_matrix_out (DataPin, I2S_PARALLEL_DATA_OUT_IDX + LaneId, false, false);
+        }
+
+    } while (false);
+
+    // DEBUG_END;
+} // SetLanePin
+
+//----------------------------------------------------------------------------
+void c_OutputI2s::SetLaneTiming (uint32_t LaneId, uint32_t _FrameDurationInMicroSec, uint32_t IdleTimeInMicroSec)
+{
+    // DEBUG_START;
+
+    if (LaneId < I2S_MAX_LANES)
+    {
+        Lanes[LaneId].FrameDurationInMicroSec = _FrameDurationInMicroSec;
+        Lanes[LaneId].IdleTimeInMicroSec      = IdleTimeInMicroSec;
+        UpdateTiming ();
+    }
+
+    // DEBUG_END;
+} // SetLaneTiming
+
+//----------------------------------------------------------------------------
+/*
+    All lanes share one frame so the frame runs at the rate of the slowest
+    lane and idles long enough for the lane with the longest reset time.
+*/
+void c_OutputI2s::UpdateTiming ()
+{
+    // DEBUG_START;
+
+    uint32_t IdleTimeInMicroSec = 0;
+    FrameDurationInMicroSec = 0;
+    for (Lane_t & CurrentLane : Lanes)
+    {
+        FrameDurationInMicroSec = max (FrameDurationInMicroSec, CurrentLane.FrameDurationInMicroSec);
+        IdleTimeInMicroSec      = max (IdleTimeInMicroSec, CurrentLane.IdleTimeInMicroSec);
+    }
+
+    NumIdleBuffers = max (uint32_t (1), (IdleTimeInMicroSec + I2S_DMA_BUFFER_DURATION_US - 1) / I2S_DMA_BUFFER_DURATION_US);
+
+    // DEBUG_V (String ("FrameDurationInMicroSec: ") + String (FrameDurationInMicroSec));
+    // DEBUG_V (String ("         NumIdleBuffers: ") + String (NumIdleBuffers));
+
+    // DEBUG_END;
+} // UpdateTiming
+
+//----------------------------------------------------------------------------
+/*
+    Pull one buffer worth of intensities from every lane and transpose them
+    into the DMA buffer. Once every lane is out of data the rest of the
+    buffer (and every buffer after it) is left at the idle level.
+
+    returns true if the frame data ran out in this buffer.
+*/
+bool IRAM_ATTR c_OutputI2s::FillDmaBuffer (uint32_t BufferIndex)
+{
+    uint32_t   StartCycle            = xthal_get_ccount ();
+    bool       DataEndedInThisBuffer = false;
+    uint16_t * pWords                = &pDmaBuffers[BufferIndex * I2S_DMA_BUFFER_WORDS];
+    uint32_t   IntensityIndex        = 0;
+
+    if (!FrameDataIsDone)
+    {
+        uint8_t LaneIntensities[I2S_MAX_LANES];
+        memset ((void*)LaneIntensities, 0x00, sizeof (LaneIntensities));
+
+        for (; IntensityIndex < I2S_INTENSITIES_PER_DMA_BUFFER; ++IntensityIndex)
+        {
+            uint16_t ActiveLanes = 0;
+            uint16_t Mask        = LaneMask;
+            for (uint32_t LaneId = 0; 0 != Mask; ++LaneId, Mask >>= 1)
+            {
+                LaneIntensities[LaneId] = 0;
+                if ((Mask & 1) && Lanes[LaneId].pPixelDataSource->ISR_MoreDataToSend ())
+                {
+                    LaneIntensities[LaneId] = uint8_t (Lanes[LaneId].pPixelDataSource->ISR_GetNextIntensityToSend ());
+                    ActiveLanes |= uint16_t (1 << LaneId);
+                }
+            }
+
+            if (0 == ActiveLanes)
+            {
+                FrameDataIsDone       = true;
+                DataEndedInThisBuffer = true;
+                break;
+            }
+
+            uint16_t * pIntensityWords = &pWords[IntensityIndex * I2S_WORDS_PER_INTENSITY];
+            I2sEncodeIntensity (LaneIntensities, ActiveLanes, pIntensityWords);
+
+#ifdef USE_I2S_DEBUG_COUNTERS
+            if (0 == (IntensityIndex & 0x0F))
+            {
+                uint16_t ReferenceWords[I2S_WORDS_PER_INTENSITY];
+                I2sEncodeIntensityReference (LaneIntensities, ActiveLanes, ReferenceWords);
+                ++TransposeChecks;
+                if (0 != memcmp (ReferenceWords, pIntensityWords, sizeof (ReferenceWords)))
+                {
+                    ++TransposeMismatches;
+                }
+            }
+#endif // def USE_I2S_DEBUG_COUNTERS
+        }
+    }
+
+    if ((0 != IntensityIndex) || !DmaBufferIsIdle[BufferIndex])
+    {
+        // the rest of the buffer holds the lines low
+        memset ((void*)&pWords[IntensityIndex * I2S_WORDS_PER_INTENSITY], 0x00,
+                (I2S_INTENSITIES_PER_DMA_BUFFER - IntensityIndex) * I2S_WORDS_PER_INTENSITY * sizeof (uint16_t));
+    }
+    DmaBufferIsIdle[BufferIndex] = (0 == IntensityIndex);
+
+    FillCycles = xthal_get_ccount () - StartCycle;
+
+    return DataEndedInThisBuffer;
+
+} // FillDmaBuffer
+
+//----------------------------------------------------------------------------
+bool c_OutputI2s::Render ()
+{
+    // //DEBUG_START;
+    bool Response = false;
+
+    do // once
+    {
+        if (!HasBeenInitialized || OutputIsPaused || (0 == LaneMask) || FrameInProgress)
+        {
+            break;
+        }
+
+        if ((micros () - FrameStartTime) < FrameDurationInMicroSec)
+        {
+            break;
+        }
+
+        // every lane goes out in the same frame. Only skip when all of them are holding.
+        bool AllLanesUnchanged = true;
+        for (Lane_t & CurrentLane : Lanes)
+        {
+            if (CurrentLane.pPixelDataSource && !CurrentLane.pPixelDataSource->FrameIsUnchanged ())
+            {
+                AllLanesUnchanged = false;
+            }
+        }
+        if (AllLanesUnchanged)
+        {
+            for (Lane_t & CurrentLane : Lanes)
+            {
+                if (CurrentLane.pPixelDataSource)
+                {
+                    CurrentLane.pPixelDataSource->RefreshSkipped ();
+                }
+            }
+            break;
+        }
+
+        for (Lane_t & CurrentLane : Lanes)
+        {
+            if (CurrentLane.pPixelDataSource)
+            {
+                CurrentLane.pPixelDataSource->StartNewFrame ();
+            }
+        }
+
+        // prime the whole ring before starting the DMA
+        FrameDataIsDone = false;
+        EofsUntilStop   = 0;
+        for (uint32_t BufferIndex = 0; BufferIndex < I2S_NUM_DMA_BUFFERS; ++BufferIndex)
+        {
+            if (FillDmaBuffer (BufferIndex))
+            {
+                EofsUntilStop = (BufferIndex + 1) + NumIdleBuffers;
+            }
+        }
+
+        InterruptsPerFrame  = InterruptsThisFrame;
+        InterruptsThisFrame = 0;
+        FrameInProgress     = true;
+
+        I2S_PARALLEL_DEVICE.conf.tx_reset       = 1;
+        I2S_PARALLEL_DEVICE.conf.tx_reset       = 0;
+        I2S_PARALLEL_DEVICE.conf.tx_fifo_reset  = 1;
+        I2S_PARALLEL_DEVICE.conf.tx_fifo_reset  = 0;
+        I2S_PARALLEL_DEVICE.lc_conf.out_rst     = 1;
+        I2S_PARALLEL_DEVICE.lc_conf.out_rst     = 0;
+        I2S_PARALLEL_DEVICE.int_clr.val         = UINT32_MAX;
+        I2S_PARALLEL_DEVICE.int_ena.out_eof     = 1;
+        I2S_PARALLEL_DEVICE.out_link.addr       = uint32_t (pDmaDescriptors) & 0xFFFFF;
+        I2S_PARALLEL_DEVICE.out_link.start      = 1;
+        I2S_PARALLEL_DEVICE.conf.tx_start       = 1;
+
+        FrameStartTime = micros ();
+        ++FrameCount;
+        Response = true;
+
+    } while (false);
+
+    // //DEBUG_END;
+
+    return Response;
+
+} // Render
+
+//----------------------------------------------------------------------------
+void IRAM_ATTR c_OutputI2s::StopDma ()
+{
+    I2S_PARALLEL_DEVICE.int_ena.out_eof = 0;
+    I2S_PARALLEL_DEVICE.conf.tx_start   = 0;
+    I2S_PARALLEL_DEVICE.out_link.stop   = 1;
+    FrameInProgress = false;
+
+} // StopDma
+
+//----------------------------------------------------------------------------
+/*
+    One EOF interrupt per DMA buffer. Refill the buffer that just finished.
+    After the data runs out, keep going until the last data buffer and the
+    reset time have gone out on the wire, then stop.
+*/
+void IRAM_ATTR c_OutputI2s::ISR_Handler ()
+{
+    uint32_t int_st = I2S_PARALLEL_DEVICE.int_st.val;
+    I2S_PARALLEL_DEVICE.int_clr.val = int_st;
+
+    portENTER_CRITICAL_ISR (&IsrLock);
+
+    do // once
+    {
+        if (!(int_st & I2S_OUT_EOF_INT_ST) || !FrameInProgress)
+        {
+            break;
+        }
+        ++InterruptsThisFrame;
+
+        if (FrameDataIsDone && (0 == --EofsUntilStop))
+        {
+            StopDma ();
+            break;
+        }
+
+        uint32_t BufferIndex = (lldesc_t *)(I2S_PARALLEL_DEVICE.out_eof_des_addr) - pDmaDescriptors;
+        if (BufferIndex >= I2S_NUM_DMA_BUFFERS)
+        {
+            break;
+        }
+
+        if (FillDmaBuffer (BufferIndex))
+        {
+            // this buffer goes out after the others already in the ring
+            EofsUntilStop = I2S_NUM_DMA_BUFFERS + NumIdleBuffers;
+        }
+
+    } while (false);
+
+    portEXIT_CRITICAL_ISR (&IsrLock);
+
+} // ISR_Handler
+
+//----------------------------------------------------------------------------
+void c_OutputI2s::PauseOutput (bool State)
+{
+    // DEBUG_START;
+
+    if (State && !OutputIsPaused)
+    {
+        StopDma ();
+
+        // wait for an ISR that is already running on the other core
+        portENTER_CRITICAL (&IsrLock);
+        portEXIT_CRITICAL (&IsrLock);
+    }
+    OutputIsPaused = State;
+
+    // DEBUG_END;
+} // PauseOutput
+
+//----------------------------------------------------------------------------
+void c_OutputI2s::GetStatus (ArduinoJson::JsonObject & jsonStatus)
+{
+    // DEBUG_START;
+
+    uint32_t CyclesPerMicroSec = getCpuFrequencyMhz ();
+
+    JsonObject I2sStatus = jsonStatus.createNestedObject (F ("I2S"));
+    I2sStatus[F ("Lanes")]              = __builtin_popcount (LaneMask);
+    I2sStatus[F ("Frames")]             = FrameCount;
+    I2sStatus[F ("InterruptsPerFrame")] = InterruptsPerFrame;
+    I2sStatus[F ("DmaBufferSize")]      = (HasBeenInitialized) ? (I2S_NUM_DMA_BUFFERS * I2S_DMA_BUFFER_SIZE) : 0;
+    I2sStatus[F ("FillTimeUs")]         = FillCycles / CyclesPerMicroSec;
+#ifdef USE_I2S_DEBUG_COUNTERS
+    I2sStatus[F ("TransposeChecks")]     = TransposeChecks;
+    I2sStatus[F ("TransposeMismatches")] = TransposeMismatches;
+#endif // def USE_I2S_DEBUG_COUNTERS
+
+    // DEBUG_END;
+} // GetStatus
+
+c_OutputI2s OutputI2s;
+
+#endif // def SUPPORT_I2S_OUTPUT
@@ -0,0 +1,110 @@
+#pragma once
+/*
+* OutputI2s.hpp - I2S parallel driver code for ESPixelStick
+*
+* Project: ESPixelStick - An ESP8266 / ESP32 and E1.31 based pixel driver
+* Copyright (c) 2015, 2022 Shelby Merrick
+* http://www.forkineye.com
+*
+*  This program is provided free for you to use in any way that you wish,
+*  subject to the laws and regulations where you are using it.  Due diligence
+*  is strongly suggested before using this code.  Please give credit where due.
+*
+*  The Author makes no warranty of any kind, express or implied, with regard
+*  to this program or the documentation contained in this document.  The
+*  Author shall not be liable in any event for incidental or consequential
+*  damages in connection with, or arising out of, the furnishing, performance
+*  or use of these programs.
+*
+*   One I2S peripheral in 16 bit LCD mode drives up to 16 pixel strings
+*   (lanes) at the same time. Every lane driver registers with the shared
+*   engine. The engine pulls intensities from each lane, transposes them into
+*   a ring of DMA buffers and refills each buffer as the DMA finishes it.
+*
+*/
+
+#include "../ESPixelStick.h"
+#ifdef SUPPORT_I2S_OUTPUT
+
+#include <soc/lldesc.h>
+#include <soc/i2s_struct.h>
+#include <esp_intr_alloc.h>
+#include "OutputPixel.hpp"
+#include "OutputI2sTranspose.hpp"
+
+class c_OutputI2s
+{
+public:
+    c_OutputI2s ();
+    virtual ~c_OutputI2s ();
+
+    void AddLane                (uint32_t LaneId, gpio_num_t DataPin, c_OutputPixel * pPixelDataSource);
+    void RemoveLane             (uint32_t LaneId);
+    void SetLanePin             (uint32_t LaneId, gpio_num_t DataPin);
+    void SetLaneTiming          (uint32_t LaneId, uint32_t FrameDurationInMicroSec, uint32_t IdleTimeInMicroSec);
+    bool Render                 ();
+    void PauseOutput            (bool State);
+    void GetStatus              (ArduinoJson::JsonObject & jsonStatus);
+    void IRAM_ATTR ISR_Handler  ();
+
+private:
+#define I2S_PARALLEL_DEVICE             I2S1
+#define I2S_PARALLEL_PERIPH_MODULE      PERIPH_I2S1_MODULE
+#define I2S_PARALLEL_INTR_SOURCE        ETS_I2S1_INTR_SOURCE
+#define I2S_PARALLEL_DATA_OUT_IDX       I2S1O_DATA_OUT8_IDX     ///< 16 bit LCD mode uses data lines 8 - 23
+#define I2S_BASE_CLOCK_HZ               80000000.0
+#define I2S_SLOT_RATE_HZ                (800000.0 * I2S_SLOTS_PER_BIT)
+#define I2S_INTENSITIES_PER_DMA_BUFFER  32
+#define I2S_NUM_DMA_BUFFERS             4
+#define I2S_DMA_BUFFER_WORDS            (I2S_INTENSITIES_PER_DMA_BUFFER * I2S_WORDS_PER_INTENSITY)
+#define I2S_DMA_BUFFER_SIZE             (I2S_DMA_BUFFER_WORDS * sizeof (uint16_t))
+#define I2S_DMA_BUFFER_DURATION_US      uint32_t ((I2S_DMA_BUFFER_WORDS * 1000000.0) / I2S_SLOT_RATE_HZ)
+
+    struct Lane_t
+    {
+        c_OutputPixel * pPixelDataSource        = nullptr;
+        gpio_num_t      DataPin                 = gpio_num_t (-1);
+        uint32_t        FrameDurationInMicroSec = 0;
+        uint32_t        IdleTimeInMicroSec      = 0;
+    };
+
+    Lane_t              Lanes[I2S_MAX_LANES];
+    volatile uint16_t   LaneMask                    = 0;
+
+    bool                HasBeenInitialized          = false;
+    bool                OutputIsPaused              = false;
+    volatile bool       FrameInProgress             = false;
+    volatile bool       FrameDataIsDone             = false;
+    volatile uint32_t   EofsUntilStop               = 0;
+    uint32_t            NumIdleBuffers              = 1;
+    uint32_t            FrameDurationInMicroSec     = 0;
+    uint32_t            FrameStartTime              = 0;        ///< micros
+
+    uint16_t          * pDmaBuffers                 = nullptr;
+    lldesc_t          * pDmaDescriptors             = nullptr;
+    bool                DmaBufferIsIdle[I2S_NUM_DMA_BUFFERS];
+    intr_handle_t       IsrHandle                   = NULL;
+    portMUX_TYPE        IsrLock                     = portMUX_INITIALIZER_UNLOCKED;
+
+    uint32_t            FrameCount                  = 0;
+    volatile uint32_t   InterruptsThisFrame         = 0;
+    uint32_t            InterruptsPerFrame          = 0;
+    uint32_t            FillCycles                  = 0;        ///< cycles to fill the last DMA buffer
+
+    bool    Initialize          ();
+    void    Terminate           ();
+    void    StopDma             ();
+    void    UpdateTiming        ();
+    bool    IRAM_ATTR FillDmaBuffer (uint32_t BufferIndex);
+
+// #define USE_I2S_DEBUG_COUNTERS
+#ifdef USE_I2S_DEBUG_COUNTERS
+    uint32_t TransposeMismatches = 0;
+    uint32_t TransposeChecks     = 0;
+#endif // def USE_I2S_DEBUG_COUNTERS
+
+}; // c_OutputI2s
+
+extern c_OutputI2s OutputI2s;
+
+#endif // def SUPPORT_I2S_OUTPUT
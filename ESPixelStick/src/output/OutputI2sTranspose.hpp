@@ -0,0 +1,124 @@
+#pragma once
+/*
+* OutputI2sTranspose.hpp - Bit transpose kernel for the I2S parallel output
+*
+* Project: ESPixelStick - An ESP8266 / ESP32 and E1.31 based pixel driver
+* Copyright (c) 2015, 2022 Shelby Merrick
+* http://www.forkineye.com
+*
+*  This program is provided free for you to use in any way that you wish,
+*  subject to the laws and regulations where you are using it.  Due diligence
+*  is strongly suggested before using this code.  Please give credit where due.
+*
+*  The Author makes no warranty of any kind, express or implied, with regard
+*  to this program or the documentation contained in this document.  The
+*  Author shall not be liable in any event for incidental or consequential
+*  damages in connection with, or arising out of, the furnishing, performance
+*  or use of these programs.
+*
+*   The I2S peripheral clocks out one 16 bit word per slot. Bit N of each
+*   word drives lane N. Every WS2811 data bit is sent as four slots of
+*   312.5ns (3.2MHz):
+*
+*       slot 0:    high
+*       slot 1:    the data bit
+*       slot 2, 3: low
+*
+*   A zero is 312ns high and a one is 625ns high.
+*
+*/
+
+#include <stdint.h>
+
+#define I2S_MAX_LANES               16
+#define I2S_BITS_PER_INTENSITY      8
+#define I2S_SLOTS_PER_BIT           4
+#define I2S_WORDS_PER_INTENSITY     (I2S_BITS_PER_INTENSITY * I2S_SLOTS_PER_BIT)
+
+// The I2S FIFO in 16 bit mode sends the two halves of each 32 bit DMA word
+// in swapped order.
+#define I2S_DMA_WORD_INDEX(n)       ((n) ^ 1)
+
+//----------------------------------------------------------------------------
+/*
+    Transpose an 8x8 bit matrix. Row i is Rows[i]. Result[k] holds bit
+    (7 - k) of every row with row i in bit i.
+    Hacker's Delight, transpose8rS32.
+*/
+inline __attribute__((always_inline)) void I2sTranspose8x8 (const uint8_t * Rows, uint8_t * Result)
+{
+    // Row 7 goes to the MSB of x so that row i lands in bit i of the result
+    uint32_t x = (uint32_t (Rows[7]) << 24) | (uint32_t (Rows[6]) << 16) | (uint32_t (Rows[5]) << 8) | uint32_t (Rows[4]);
+    uint32_t y = (uint32_t (Rows[3]) << 24) | (uint32_t (Rows[2]) << 16) | (uint32_t (Rows[1]) << 8) | uint32_t (Rows[0]);
+    uint32_t t;
+
+    t = (x ^ (x >> 7))  & 0x00AA00AA; x = x ^ t ^ (t << 7);
+    t = (y ^ (y >> 7))  & 0x00AA00AA; y = y ^ t ^ (t << 7);
+    t = (x ^ (x >> 14)) & 0x0000CCCC; x = x ^ t ^ (t << 14);
+    t = (y ^ (y >> 14)) & 0x0000CCCC; y = y ^ t ^ (t << 14);
+    t = (x & 0xF0F0F0F0) | ((y >> 4) & 0x0F0F0F0F);
+    y = ((x << 4) & 0xF0F0F0F0) | (y & 0x0F0F0F0F);
+    x = t;
+
+    Result[0] = uint8_t (x >> 24);
+    Result[1] = uint8_t (x >> 16);
+    Result[2] = uint8_t (x >> 8);
+    Result[3] = uint8_t (x);
+    Result[4] = uint8_t (y >> 24);
+    Result[5] = uint8_t (y >> 16);
+    Result[6] = uint8_t (y >> 8);
+    Result[7] = uint8_t (y);
+
+} // I2sTranspose8x8
+
+//----------------------------------------------------------------------------
+/*
+    Encode one intensity value for every lane into I2S_WORDS_PER_INTENSITY
+    DMA words. ActiveLanes has a bit set for each lane that is still sending
+    data. Lanes that are done stay low.
+*/
+inline __attribute__((always_inline)) void I2sEncodeIntensity (const uint8_t * LaneIntensities, uint16_t ActiveLanes, uint16_t * pDmaWords)
+{
+    uint8_t LowLanes[I2S_BITS_PER_INTENSITY];
+    uint8_t HighLanes[I2S_BITS_PER_INTENSITY];
+
+    I2sTranspose8x8 (&LaneIntensities[0], LowLanes);
+    I2sTranspose8x8 (&LaneIntensities[8], HighLanes);
+
+    uint32_t SlotIndex = 0;
+    for (uint32_t BitIndex = 0; BitIndex < I2S_BITS_PER_INTENSITY; ++BitIndex)
+    {
+        uint16_t DataBits = (uint16_t (HighLanes[BitIndex]) << 8) | uint16_t (LowLanes[BitIndex]);
+        pDmaWords[I2S_DMA_WORD_INDEX (SlotIndex++)] = ActiveLanes;
+        pDmaWords[I2S_DMA_WORD_INDEX (SlotIndex++)] = DataBits & ActiveLanes;
+        pDmaWords[I2S_DMA_WORD_INDEX (SlotIndex++)] = 0;
+        pDmaWords[I2S_DMA_WORD_INDEX (SlotIndex++)] = 0;
+    }
+
+} // I2sEncodeIntensity
+
+//----------------------------------------------------------------------------
+/*
+    Bit by bit version of I2sEncodeIntensity. Slow. Used to check the
+    transpose kernel.
+*/
+inline void I2sEncodeIntensityReference (const uint8_t * LaneIntensities, uint16_t ActiveLanes, uint16_t * pDmaWords)
+{
+    uint32_t SlotIndex = 0;
+    for (uint32_t bitmask = 0x80; 0 != bitmask; bitmask >>= 1)
+    {
+        uint16_t DataBits = 0;
+        for (uint32_t Lane = 0; Lane < I2S_MAX_LANES; ++Lane)
+        {
+            if (LaneIntensities[Lane] & bitmask)
+            {
+                DataBits |= uint16_t (1 << Lane);
+            }
+        }
+        pDmaWords[I2S_DMA_WORD_INDEX (SlotIndex++)] = ActiveLanes;
+        pDmaWords[I2S_DMA_WORD_INDEX (SlotIndex++)] = DataBits & ActiveLanes;
+        pDmaWords[I2S_DMA_WORD_INDEX (SlotIndex++)] = 0;
+        pDmaWords[I2S_DMA_WORD_INDEX (SlotIndex++)] = 0;
+    }
+
+} // I2sEncodeIntensityReference
@@ -40,16 +40,52 @@
 #include "OutputUCS1903Uart.hpp"
 #include "OutputWS2801Spi.hpp"
 #include "OutputWS2811Rmt.hpp"
+#include "OutputWS2811I2s.hpp"
 #include "OutputWS2811Uart.hpp"
 #include "OutputGS8208Uart.hpp"
 #include "OutputGS8208Rmt.hpp"
 #include "OutputUCS8903Uart.hpp"
 #include "OutputUCS8903Rmt.hpp"
+#include "OutputRmt.hpp"
+#include "OutputI2s.hpp"
+#include "OutputRoutingTable.hpp"
 // needs to be last
 #include "OutputMgr.hpp"
 
 #include "../input/InputMgr.hpp"
 
+#ifdef ARDUINO_ARCH_ESP32
+#   include <esp_heap_caps.h>
+#endif // def ARDUINO_ARCH_ESP32
+
+#ifdef ARDUINO_ARCH_ESP32
+//-----------------------------------------------------------------------------
+static void OutputTimerHandler (void * p)
+{
+    TaskHandle_t Handle = reinterpret_cast <TaskHandle_t> (p);
+    if (Handle)
+    {
+        xTaskNotifyGive (Handle);
+    }
+
+} // OutputTimerHandler
+
+//----------------------------------------------------------------------------
+static void OutputTask (void* pvParameters)
+{
+    c_OutputMgr * pOutputMgr = reinterpret_cast <c_OutputMgr*> (pvParameters);
+
+    do
+    {
+        // wait for the timer or an input to wake us up
+        ulTaskNotifyTake (pdTRUE, portMAX_DELAY);
+        pOutputMgr->RenderOutputs ();
+
+    } while (true);
+
+} // OutputTask
+#endif // def ARDUINO_ARCH_ESP32
+
 //-----------------------------------------------------------------------------
 // Local Data definitions
 //-----------------------------------------------------------------------------
@@ -174,6 +210,71 @@ static const OutputChannelIdToGpioAndPortEntry_t OutputChannelIdToGpioAndPort[]
         {DEFAULT_RELAY_GPIO, uart_port_t(-1)},
 #endif // def DEFAULT_RELAY_GPIO
 
+    // I2S parallel lanes. After the older channels, same order as e_OutputChannelIds
+#ifdef DEFAULT_I2S_0_GPIO
+        {DEFAULT_I2S_0_GPIO, uart_port_t(0)},
+#endif // def DEFAULT_I2S_0_GPIO
+
+#ifdef DEFAULT_I2S_1_GPIO
+        {DEFAULT_I2S_1_GPIO, uart_port_t(1)},
+#endif // def DEFAULT_I2S_1_GPIO
+
+#ifdef DEFAULT_I2S_2_GPIO
+        {DEFAULT_I2S_2_GPIO, uart_port_t(2)},
+#endif // def DEFAULT_I2S_2_GPIO
+
+#ifdef DEFAULT_I2S_3_GPIO
+        {DEFAULT_I2S_3_GPIO, uart_port_t(3)},
+#endif // def DEFAULT_I2S_3_GPIO
+
+#ifdef DEFAULT_I2S_4_GPIO
+        {DEFAULT_I2S_4_GPIO, uart_port_t(4)},
+#endif // def DEFAULT_I2S_4_GPIO
+
+#ifdef DEFAULT_I2S_5_GPIO
+        {DEFAULT_I2S_5_GPIO, uart_port_t(5)},
+#endif // def DEFAULT_I2S_5_GPIO
+
+#ifdef DEFAULT_I2S_6_GPIO
+        {DEFAULT_I2S_6_GPIO, uart_port_t(6)},
+#endif // def DEFAULT_I2S_6_GPIO
+
+#ifdef DEFAULT_I2S_7_GPIO
+        {DEFAULT_I2S_7_GPIO, uart_port_t(7)},
+#endif // def DEFAULT_I2S_7_GPIO
+
+#ifdef DEFAULT_I2S_8_GPIO
+        {DEFAULT_I2S_8_GPIO, uart_port_t(8)},
+#endif // def DEFAULT_I2S_8_GPIO
+
+#ifdef DEFAULT_I2S_9_GPIO
+        {DEFAULT_I2S_9_GPIO, uart_port_t(9)},
+#endif // def DEFAULT_I2S_9_GPIO
+
+#ifdef DEFAULT_I2S_10_GPIO
+        {DEFAULT_I2S_10_GPIO, uart_port_t(10)},
+#endif // def DEFAULT_I2S_10_GPIO
+
+#ifdef DEFAULT_I2S_11_GPIO
+        {DEFAULT_I2S_11_GPIO, uart_port_t(11)},
+#endif // def DEFAULT_I2S_11_GPIO
+
+#ifdef DEFAULT_I2S_12_GPIO
+        {DEFAULT_I2S_12_GPIO, uart_port_t(12)},
+#endif // def DEFAULT_I2S_12_GPIO
+
+#ifdef DEFAULT_I2S_13_GPIO
+        {DEFAULT_I2S_13_GPIO, uart_port_t(13)},
+#endif // def DEFAULT_I2S_13_GPIO
+
+#ifdef DEFAULT_I2S_14_GPIO
+        {DEFAULT_I2S_14_GPIO, uart_port_t(14)},
+#endif // def DEFAULT_I2S_14_GPIO
+
+#ifdef DEFAULT_I2S_15_GPIO
+        {DEFAULT_I2S_15_GPIO, uart_port_t(15)},
+#endif // def DEFAULT_I2S_15_GPIO
+
 };
 
 //-----------------------------------------------------------------------------
@@ -184,9 +285,6 @@ c_OutputMgr::c_OutputMgr ()
 {
     ConfigFileName = String (F ("/")) + String (CN_output_config) + F (".json");
 
-    // clear the input data buffer
-    memset ((char*)&OutputBuffer[0], 0, sizeof (OutputBuffer));
-
 } // c_OutputMgr
 
 //-----------------------------------------------------------------------------
@@ -201,6 +299,9 @@ c_OutputMgr::~c_OutputMgr()
         // the drivers will put the hardware in a safe state
         delete CurrentOutput.pOutputChannelDriver;
     }
+
+    FreeFrameBuffers ();
+
     // DEBUG_END;
 
 } // ~c_OutputMgr
@@ -250,6 +351,8 @@ void c_OutputMgr::Begin ()
         // DEBUG_V();
         LoadConfig();
 
+        StartOutputTask ();
+
         // CreateNewConfig ();
     } while (false);
 
@@ -267,7 +370,9 @@ void c_OutputMgr::CreateJsonConfig (JsonObject& jsonConfig)
 
     // add OM config parameters
     // DEBUG_V ();
-    
+    jsonConfig[CN_doublebuffer] = DoubleBufferEnabled;
+    jsonConfig[CN_syncrmt]      = SyncRmtStartEnabled;
+
     // add the channels header
     JsonObject OutputMgrChannelsData;
     if (true == jsonConfig.containsKey (CN_channels))
@@ -374,7 +479,7 @@ void c_OutputMgr::CreateNewConfig ()
     // DEBUG_V ();
 
     JsonConfig[CN_cfgver] = CurrentConfigVersion;
-    JsonConfig[F ("MaxChannels")] = sizeof(OutputBuffer);
+    JsonConfig[F ("MaxChannels")] = GetMaxChannelsAvailable ();
 
     // DEBUG_V ("for each output type");
     for (auto CurrentOutputType : OutputTypeXlateMap)
@@ -462,6 +567,33 @@ void c_OutputMgr::GetStatus (JsonObject & jsonStatus)
         // DEBUG_V ();
     }
 
+    JsonObject BufferStatus = jsonStatus.createNestedObject (F ("OutputBuffer"));
+    BufferStatus[F ("AllocatedSize")]   = BufferSize;
+    BufferStatus[F ("UsedSize")]        = UsedBufferSize;
+    BufferStatus[F ("MaxChannels")]     = GetMaxChannelsAvailable ();
+    BufferStatus[F ("FreeHeap")]        = ESP.getFreeHeap ();
+    BufferStatus[F ("LargestFreeBlock")] = GetLargestFreeBlock ();
+    BufferStatus[F ("DoubleBuffered")]  = (nullptr != pSecondaryBuffer);
+    BufferStatus[F ("BackBufferInPsram")] = SecondaryBufferIsInPsram;
+
+    JsonObject TaskStatus = jsonStatus.createNestedObject (F ("OutputTask"));
+    TaskStatus[F ("Running")]     = OutputTaskIsRunning;
+    TaskStatus[F ("RenderPasses")] = RenderPassCount;
+    TaskStatus[F ("InputFrames")] = InputFrameCount;
+
+#ifdef SUPPORT_RMT_OUTPUT
+    c_OutputRmt::GetSharedStatus (jsonStatus);
+#endif // def SUPPORT_RMT_OUTPUT
+
+#ifdef USE_OUTPUTMGR_DEBUG_COUNTERS
+    JsonObject debugStatus = jsonStatus.createNestedObject("OutputMgr Debug");
+    debugStatus["RoutingTableSize"]               = RoutingTableSize;
+    debugStatus["WriteChannelDataCounter"]        = WriteChannelDataCounter;
+    debugStatus["WriteChannelDataCyclesPerCall"]  = (0 == WriteChannelDataCounter) ? 0 : (WriteChannelDataCycles / WriteChannelDataCounter);
+    debugStatus["RoutingTableCacheHitCounter"]    = RoutingTableCacheHitCounter;
+    debugStatus["RoutingTableSearchCounter"]      = RoutingTableSearchCounter;
+#endif // def USE_OUTPUTMGR_DEBUG_COUNTERS
+
     // DEBUG_END;
 } // GetStatus
 
@@ -724,6 +856,17 @@ void c_OutputMgr::InstantiateNewOutputChannel(DriverInfo_t & CurrentOutputChanne
                 }
 #endif // def SUPPORT_RMT_OUTPUT
 
+#ifdef SUPPORT_I2S_OUTPUT
+                // DEBUG_V ("I2S");
+                if (OM_IS_I2S)
+                {
+                    // logcon (CN_stars + String (F (" Starting WS2811 I2S for channel '")) + CurrentOutputChannelDriver.DriverId + "'. " + CN_stars);
+                    CurrentOutputChannelDriver.pOutputChannelDriver = new c_OutputWS2811I2s(CurrentOutputChannelDriver.DriverId, dataPin, UartId, OutputType_WS2811);
+                    // DEBUG_V ();
+                    break;
+                }
+#endif // def SUPPORT_I2S_OUTPUT
+
 #ifdef SUPPORT_UART_OUTPUT
                 // DEBUG_V ("UART");
                 if (OM_IS_UART)
@@ -965,7 +1108,9 @@ void c_OutputMgr::InstantiateNewOutputChannel(DriverInfo_t & CurrentOutputChanne
 void c_OutputMgr::LoadConfig ()
 {
     // DEBUG_START;
-    
+
+    LockOutputs ();
+
     // try to load and process the config file
     if (!FileMgr.LoadConfigFile(ConfigFileName, [this](DynamicJsonDocument &JsonConfigDoc)
         {
@@ -992,6 +1137,8 @@ void c_OutputMgr::LoadConfig ()
         CreateNewConfig ();
     }
 
+    UnlockOutputs ();
+
     // DEBUG_END;
 
 } // LoadConfig
@@ -1040,6 +1187,12 @@ bool c_OutputMgr::ProcessJsonConfig (JsonObject& jsonConfig)
             // break;
         }
 
+        setFromJSON (DoubleBufferEnabled, OutputChannelMgrData, CN_doublebuffer);
+        setFromJSON (SyncRmtStartEnabled, OutputChannelMgrData, CN_syncrmt);
+#ifdef SUPPORT_RMT_OUTPUT
+        c_OutputRmt::SetSyncStart (SyncRmtStartEnabled);
+#endif // def SUPPORT_RMT_OUTPUT
+
         // do we have a channel configuration array?
         if (false == OutputChannelMgrData.containsKey (CN_channels))
         {
@@ -1187,7 +1340,7 @@ void c_OutputMgr::SetConfig(ArduinoJson::JsonDocument & ConfigData)
 } // SaveConfig
 
 //-----------------------------------------------------------------------------
-///< Called from loop(), renders output data
+///< Called from loop(). Loads new configs. Renders output data when there is no output task.
 void c_OutputMgr::Render()
 {
     // DEBUG_START;
@@ -1204,34 +1357,467 @@ void c_OutputMgr::Render()
         LoadConfig ();
     } // done need to save the current config
 
-    if (false == IsOutputPaused)
+    if (false == OutputTaskIsRunning)
+    {
+        RenderOutputs ();
+    }
+
+    // DEBUG_END;
+} // render
+
+//-----------------------------------------------------------------------------
+/*
+    Give every driver a chance to start a new frame. This runs in the output
+    task on the ESP32 so a slow web request or config save in loop() does not
+    hold up the outputs. On the ESP8266 the timer schedules it to run from the
+    loop context between passes of loop(). The drivers do blocking I2C
+    writes, analogWrite and logging, none of which may run in the timer (SYS)
+    context.
+
+    Only the drivers are locked for the pass. The inputs keep writing into the
+    back buffer while the frames are sent. Each driver takes the back buffer
+    lock for as long as LatchFrame copies its data.
+*/
+void c_OutputMgr::RenderOutputs ()
+{
+    // DEBUG_START;
+
+#ifdef ARDUINO_ARCH_ESP32
+    if (OutputLock)
     {
-        // DEBUG_START;
+        xSemaphoreTakeRecursive (OutputLock, portMAX_DELAY);
+    }
+#else
+    // Skip this pass if loop() is in the middle of changing the config.
+    if (0 == OutputLockCount)
+#endif // def ARDUINO_ARCH_ESP32
+    {
+        if (false == IsOutputPaused)
+        {
+            for (DriverInfo_t & OutputChannel : OutputChannelDrivers)
+            {
+                // let the driver know there is new data waiting to be latched
+                if (OutputChannel.BackBufferUpdated)
+                {
+                    OutputChannel.BackBufferUpdated = false;
+                    OutputChannel.pOutputChannelDriver->NewFrameAvailable ();
+                }
+                OutputChannel.pOutputChannelDriver->Render ();
+            }
+#ifdef SUPPORT_RMT_OUTPUT
+            c_OutputRmt::StartSynchronizedChannels ();
+#endif // def SUPPORT_RMT_OUTPUT
+        }
+        ++RenderPassCount;
+
+        ScheduleNextRenderPass ();
+    }
+#ifdef ARDUINO_ARCH_ESP32
+    if (OutputLock)
+    {
+        xSemaphoreGiveRecursive (OutputLock);
+    }
+#else
+    else
+    {
+        // the drivers may be half built. Try again later.
+        ScheduleRenderPassInMs (OM_OUTPUT_TASK_MAX_SLEEP_US / 1000);
+    }
+#endif // def ARDUINO_ARCH_ESP32
+
+    // DEBUG_END;
+} // RenderOutputs
+
+//-----------------------------------------------------------------------------
+/*
+    Arm the timer for the output that is due next. The sleep is clamped so an
+    output that is due (or still sending) does not make us spin and so new
+    input data for an output in hold mode is picked up quickly.
+*/
+void c_OutputMgr::ScheduleNextRenderPass ()
+{
+    // DEBUG_START;
+
+    do // once
+    {
+        if (false == OutputTaskIsRunning)
+        {
+            break;
+        }
+
+        uint32_t SleepTimeInMicroSec = OM_OUTPUT_TASK_MAX_SLEEP_US;
         for (DriverInfo_t & OutputChannel : OutputChannelDrivers)
         {
-            OutputChannel.pOutputChannelDriver->Render ();
+            if (OutputChannel.ChannelCount)
+            {
+                SleepTimeInMicroSec = min (SleepTimeInMicroSec, OutputChannel.pOutputChannelDriver->GetTimeToNextFrameInMicroSec ());
+            }
+        }
+        SleepTimeInMicroSec = max (SleepTimeInMicroSec, uint32_t (OM_OUTPUT_TASK_MIN_SLEEP_US));
+
+#ifdef ARDUINO_ARCH_ESP32
+        esp_timer_stop (OutputTimerHandle);
+        esp_timer_start_once (OutputTimerHandle, SleepTimeInMicroSec);
+#else
+        ScheduleRenderPassInMs ((SleepTimeInMicroSec + 999) / 1000);
+#endif // def ARDUINO_ARCH_ESP32
+
+    } while (false);
+
+    // DEBUG_END;
+} // ScheduleNextRenderPass
+
+//-----------------------------------------------------------------------------
+void c_OutputMgr::StartOutputTask ()
+{
+    // DEBUG_START;
+
+    do // once
+    {
+#ifdef ARDUINO_ARCH_ESP32
+        OutputLock     = xSemaphoreCreateRecursiveMutex ();
+        BackBufferLock = xSemaphoreCreateRecursiveMutex ();
+        if ((NULL == OutputLock) || (NULL == BackBufferLock))
+        {
+            logcon (F ("ERROR: Could not create the output lock. Rendering from loop()"));
+            break;
         }
+
+        if (pdPASS != xTaskCreatePinnedToCore (OutputTask, "OutputTask", OM_OUTPUT_TASK_STACK_SIZE, this, OM_OUTPUT_TASK_PRIORITY, &OutputTaskHandle, OM_OUTPUT_TASK_CORE))
+        {
+            logcon (F ("ERROR: Could not create the output task. Rendering from loop()"));
+            OutputTaskHandle = NULL;
+            break;
+        }
+
+        esp_timer_create_args_t TimerArgs;
+        memset ((void*)&TimerArgs, 0x00, sizeof (TimerArgs));
+        TimerArgs.callback        = &OutputTimerHandler;
+        TimerArgs.arg             = (void*)OutputTaskHandle;
+        TimerArgs.dispatch_method = ESP_TIMER_TASK;
+        TimerArgs.name            = "OutputTimer";
+        if (ESP_OK != esp_timer_create (&TimerArgs, &OutputTimerHandle))
+        {
+            logcon (F ("ERROR: Could not create the output timer. Rendering from loop()"));
+            vTaskDelete (OutputTaskHandle);
+            OutputTaskHandle = NULL;
+            break;
+        }
+
+        OutputTaskIsRunning = true;
+        xTaskNotifyGive (OutputTaskHandle);
+#else
+        OutputTaskIsRunning = true;
+        ScheduleRenderPassInMs (1);
+#endif // def ARDUINO_ARCH_ESP32
+
+    } while (false);
+
+    // DEBUG_END;
+} // StartOutputTask
+
+//-----------------------------------------------------------------------------
+/*
+    Keep the output task away from the drivers while loop() changes them.
+    The buffers may move so the inputs are kept out as well. The drivers are
+    always locked before the back buffer.
+*/
+void c_OutputMgr::LockOutputs ()
+{
+#ifdef ARDUINO_ARCH_ESP32
+    if (OutputLock)
+    {
+        xSemaphoreTakeRecursive (OutputLock, portMAX_DELAY);
+    }
+#endif // def ARDUINO_ARCH_ESP32
+    ++OutputLockCount;
+    LockBackBuffer ();
+
+} // LockOutputs
+
+//-----------------------------------------------------------------------------
+void c_OutputMgr::UnlockOutputs ()
+{
+    UnlockBackBuffer ();
+    --OutputLockCount;
+#ifdef ARDUINO_ARCH_ESP32
+    if (OutputLock)
+    {
+        xSemaphoreGiveRecursive (OutputLock);
+    }
+#endif // def ARDUINO_ARCH_ESP32
+
+} // UnlockOutputs
+
+//-----------------------------------------------------------------------------
+void c_OutputMgr::LockBackBuffer ()
+{
+#ifdef ARDUINO_ARCH_ESP32
+    if (BackBufferLock)
+    {
+        xSemaphoreTakeRecursive (BackBufferLock, portMAX_DELAY);
+    }
+#endif // def ARDUINO_ARCH_ESP32
+
+} // LockBackBuffer
+
+//-----------------------------------------------------------------------------
+void c_OutputMgr::UnlockBackBuffer ()
+{
+#ifdef ARDUINO_ARCH_ESP32
+    if (BackBufferLock)
+    {
+        xSemaphoreGiveRecursive (BackBufferLock);
     }
+#endif // def ARDUINO_ARCH_ESP32
+
+} // UnlockBackBuffer
+
+//-----------------------------------------------------------------------------
+/*
+    Called by an input when the last of the data for a frame is in the
+    buffer. Starts a render pass now instead of at the next timer tick.
+*/
+void c_OutputMgr::InputFrameComplete ()
+{
+    // DEBUG_START;
+
+    ++InputFrameCount;
+
+#ifdef ARDUINO_ARCH_ESP32
+    if (OutputTaskHandle)
+    {
+        xTaskNotifyGive (OutputTaskHandle);
+    }
+#else
+    if (OutputTaskIsRunning)
+    {
+        ScheduleRenderPassInMs (1);
+    }
+#endif // def ARDUINO_ARCH_ESP32
+
     // DEBUG_END;
-} // render
+} // InputFrameComplete
+
+//-----------------------------------------------------------------------------
+/*
+    Size the frame buffers to fit the channels the drivers need and decide
+    which buffers the inputs and the drivers use. The primary buffer is the
+    front buffer. The ISRs read from it so it must be in internal RAM. With
+    double buffering the second buffer is the back buffer. It comes from
+    internal RAM while there is room and overflows into PSRAM (when present).
+
+    Returns true if the buffers moved. The drivers are paused when that
+    happens and must be given their new buffer addresses before they restart.
+*/
+bool c_OutputMgr::SetUpFrameBuffers (size_t ChannelsNeeded)
+{
+    // DEBUG_START;
+
+    bool BuffersMoved = false;
+
+    size_t NewBufferSize = ((ChannelsNeeded + OM_BUFFER_ALLOCATION_SIZE - 1) / OM_BUFFER_ALLOCATION_SIZE) * OM_BUFFER_ALLOCATION_SIZE;
+
+    // DEBUG_V (String ("ChannelsNeeded: ") + String (ChannelsNeeded));
+    // DEBUG_V (String (" NewBufferSize: ") + String (NewBufferSize));
+
+    do // once
+    {
+        bool NeedSecondaryBuffer = DoubleBufferEnabled && (0 != NewBufferSize);
+        if ((NewBufferSize == BufferSize) && (NeedSecondaryBuffer == (nullptr != pSecondaryBuffer)))
+        {
+            // DEBUG_V ("No change in the frame buffers");
+            break;
+        }
+
+        // the drivers hold pointers into the buffers we are about to change.
+        // PauseOutput returns once the driver no longer reads them.
+        for (auto & OutputChannel : OutputChannelDrivers)
+        {
+            OutputChannel.pOutputChannelDriver->PauseOutput (true);
+        }
+        BuffersMoved = true;
+
+        if (NewBufferSize != BufferSize)
+        {
+            FreeFrameBuffers ();
+
+            if (0 == NewBufferSize)
+            {
+                break;
+            }
+
+#ifdef ARDUINO_ARCH_ESP32
+            pPrimaryBuffer = (uint8_t *)heap_caps_malloc (NewBufferSize, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+#else
+            pPrimaryBuffer = (uint8_t *)malloc (NewBufferSize);
+#endif // def ARDUINO_ARCH_ESP32
+            if (nullptr == pPrimaryBuffer)
+            {
+                // use what the heap can spare
+                size_t LargestFreeBlock = GetLargestFreeBlock ();
+                size_t RequestedSize    = NewBufferSize;
+                NewBufferSize = (LargestFreeBlock > OM_MIN_FREE_HEAP) ? (LargestFreeBlock - OM_MIN_FREE_HEAP) : 0;
+                NewBufferSize = min (RequestedSize, (NewBufferSize / OM_BUFFER_ALLOCATION_SIZE) * OM_BUFFER_ALLOCATION_SIZE);
+
+                logcon (String (F ("--- OutputMgr: ERROR: Could not allocate ")) + String (RequestedSize) + String (F (" bytes for the output buffer. Using ")) + String (NewBufferSize));
+
+                if (0 == NewBufferSize)
+                {
+                    break;
+                }
+#ifdef ARDUINO_ARCH_ESP32
+                pPrimaryBuffer = (uint8_t *)heap_caps_malloc (NewBufferSize, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+#else
+                pPrimaryBuffer = (uint8_t *)malloc (NewBufferSize);
+#endif // def ARDUINO_ARCH_ESP32
+                if (nullptr == pPrimaryBuffer)
+                {
+                    break;
+                }
+            }
+
+            memset (pPrimaryBuffer, 0x00, NewBufferSize);
+            BufferSize = NewBufferSize;
+        }
+
+        if (false == NeedSecondaryBuffer)
+        {
+            if (nullptr != pSecondaryBuffer)
+            {
+                free (pSecondaryBuffer);
+                pSecondaryBuffer = nullptr;
+                SecondaryBufferIsInPsram = false;
+            }
+            break;
+        }
+
+        if (nullptr != pSecondaryBuffer)
+        {
+            break;
+        }
+
+        // keep the hot buffers in internal RAM as long as there is room for them
+        if (GetLargestFreeBlock () >= (BufferSize + OM_MIN_FREE_HEAP))
+        {
+#ifdef ARDUINO_ARCH_ESP32
+            pSecondaryBuffer = (uint8_t *)heap_caps_malloc (BufferSize, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+#else
+            pSecondaryBuffer = (uint8_t *)malloc (BufferSize);
+#endif // def ARDUINO_ARCH_ESP32
+        }
+#ifdef BOARD_HAS_PSRAM
+        if (nullptr == pSecondaryBuffer)
+        {
+            pSecondaryBuffer = (uint8_t *)ps_malloc (BufferSize);
+            SecondaryBufferIsInPsram = (nullptr != pSecondaryBuffer);
+        }
+#endif // def BOARD_HAS_PSRAM
+        if (nullptr == pSecondaryBuffer)
+        {
+            logcon (String (F ("--- OutputMgr: ERROR: Could not allocate the frame buffer. Double buffering is disabled.")));
+            DoubleBufferEnabled = false;
+            break;
+        }
+
+        // keep whatever the inputs have already written
+        memcpy (pSecondaryBuffer, pPrimaryBuffer, BufferSize);
+
+    } while (false);
+
+    pFrontBuffer = pPrimaryBuffer;
+    pBackBuffer  = (nullptr != pSecondaryBuffer) ? pSecondaryBuffer : pPrimaryBuffer;
+
+    // DEBUG_V (String ("BufferSize: ") + String (BufferSize));
+
+    // DEBUG_END;
+
+    return BuffersMoved;
+
+} // SetUpFrameBuffers
+
+//-----------------------------------------------------------------------------
+void c_OutputMgr::FreeFrameBuffers ()
+{
+    // DEBUG_START;
+
+    if (nullptr != pSecondaryBuffer)
+    {
+        free (pSecondaryBuffer);
+        pSecondaryBuffer = nullptr;
+    }
+    SecondaryBufferIsInPsram = false;
+
+    if (nullptr != pPrimaryBuffer)
+    {
+        free (pPrimaryBuffer);
+        pPrimaryBuffer = nullptr;
+    }
+    BufferSize = 0;
+
+    pFrontBuffer = nullptr;
+    pBackBuffer  = nullptr;
+
+    // DEBUG_END;
+
+} // FreeFrameBuffers
+
+//-----------------------------------------------------------------------------
+size_t c_OutputMgr::GetLargestFreeBlock ()
+{
+#ifdef ARDUINO_ARCH_ESP32
+    return heap_caps_get_largest_free_block (MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+#else
+    return ESP.getMaxFreeBlockSize ();
+#endif // def ARDUINO_ARCH_ESP32
+
+} // GetLargestFreeBlock
+
+//-----------------------------------------------------------------------------
+/*
+    The largest number of channels the outputs could be given right now:
+    the current buffer plus whatever the heap can spare.
+*/
+size_t c_OutputMgr::GetMaxChannelsAvailable ()
+{
+    size_t LargestFreeBlock = GetLargestFreeBlock ();
+    size_t Response = BufferSize;
+
+    if (LargestFreeBlock > OM_MIN_FREE_HEAP)
+    {
+        Response += LargestFreeBlock - OM_MIN_FREE_HEAP;
+    }
+
+    return Response;
+
+} // GetMaxChannelsAvailable
 
 //-----------------------------------------------------------------------------
 void c_OutputMgr::UpdateDisplayBufferReferences (void)
 {
     // DEBUG_START;
 
+    size_t TotalChannelsNeeded = 0;
+    for (auto & OutputChannel : OutputChannelDrivers)
+    {
+        TotalChannelsNeeded += OutputChannel.pOutputChannelDriver->GetNumChannelsNeeded ();
+    }
+
+    bool BuffersMoved = SetUpFrameBuffers (TotalChannelsNeeded);
+
     size_t OutputBufferOffset = 0;
 
-    // DEBUG_V (String ("        BufferSize: ") + String (sizeof(OutputBuffer)));
+    // DEBUG_V (String ("        BufferSize: ") + String (BufferSize));
     // DEBUG_V (String ("OutputBufferOffset: ") + String (OutputBufferOffset));
 
     for (auto & OutputChannel : OutputChannelDrivers)
     {
         OutputChannel.StartingChannelId = OutputBufferOffset;
-        OutputChannel.pOutputChannelDriver->SetOutputBufferAddress(&OutputBuffer[OutputBufferOffset]);
+        OutputChannel.pOutputChannelDriver->SetOutputBufferAddress(&pFrontBuffer[OutputBufferOffset]);
+        OutputChannel.pOutputChannelDriver->SetBackBufferAddress(&pBackBuffer[OutputBufferOffset]);
 
         size_t ChannelsNeeded     = OutputChannel.pOutputChannelDriver->GetNumChannelsNeeded ();
-        size_t AvailableChannels  = sizeof(OutputBuffer) - OutputBufferOffset;
+        size_t AvailableChannels  = BufferSize - OutputBufferOffset;
         size_t ChannelsToAllocate = min (ChannelsNeeded, AvailableChannels);
 
         // DEBUG_V (String ("    ChannelsNeeded: ") + String (ChannelsNeeded));
@@ -1257,10 +1843,20 @@ void c_OutputMgr::UpdateDisplayBufferReferences (void)
 
     // DEBUG_V (String ("   TotalBufferSize: ") + String (OutputBufferOffset));
     UsedBufferSize = OutputBufferOffset;
-    // DEBUG_V (String ("       OutputBuffer: 0x") + String (uint32_t (OutputBuffer), HEX));
+    UpdateRoutingTable ();
+    // DEBUG_V (String ("     pPrimaryBuffer: 0x") + String (uint32_t (pPrimaryBuffer), HEX));
     // DEBUG_V (String ("     UsedBufferSize: ") + String (uint32_t (UsedBufferSize)));
     InputMgr.SetBufferInfo (OutputBufferOffset);
 
+    if (BuffersMoved)
+    {
+        // the drivers have their new buffer addresses. Let them run again.
+        for (auto & OutputChannel : OutputChannelDrivers)
+        {
+            OutputChannel.pOutputChannelDriver->PauseOutput (IsOutputPaused);
+        }
+    }
+
     // DEBUG_END;
 
 } // UpdateDisplayBufferReferences
@@ -1269,21 +1865,117 @@ void c_OutputMgr::UpdateDisplayBufferReferences (void)
 void c_OutputMgr::PauseOutputs(bool PauseTheOutput)
 {
     // DEBUG_START;
+    LockOutputs ();
     IsOutputPaused = PauseTheOutput;
 
     for (auto & CurrentOutput : OutputChannelDrivers)
     {
         CurrentOutput.pOutputChannelDriver->PauseOutput(PauseTheOutput);
     }
+    UnlockOutputs ();
 
     // DEBUG_END;
 } // PauseOutputs
 
+//-----------------------------------------------------------------------------
+/*
+    Rebuild the list of drivers that own channels. The drivers are laid out
+    in the buffer in the same order as OutputChannelDrivers so the list is
+    already sorted by starting channel.
+*/
+void c_OutputMgr::UpdateRoutingTable ()
+{
+    // DEBUG_START;
+
+    RoutingTableSize      = 0;
+    LastRoutingTableIndex = 0;
+
+    for (auto & OutputChannel : OutputChannelDrivers)
+    {
+        if (0 != OutputChannel.ChannelCount)
+        {
+            RoutingTable[RoutingTableSize++] = &OutputChannel;
+        }
+    }
+
+    // DEBUG_V (String ("RoutingTableSize: ") + String (RoutingTableSize));
+
+    // DEBUG_END;
+
+} // UpdateRoutingTable
+
+//-----------------------------------------------------------------------------
+/*
+    Find the routing table entry for the driver that owns ChannelId. Writes
+    usually continue in the driver used by the previous write, so that one is
+    checked before doing a binary search. Caller must make sure ChannelId is
+    less than UsedBufferSize.
+*/
+size_t c_OutputMgr::FindRoutingTableIndex (size_t ChannelId)
+{
+    size_t Index = LastRoutingTableIndex;
+
+#ifdef USE_OUTPUTMGR_DEBUG_COUNTERS
+    if (RoutingTableFind (RoutingTable, RoutingTableSize, ChannelId, Index))
+    {
+        RoutingTableCacheHitCounter++;
+    }
+    else
+    {
+        RoutingTableSearchCounter++;
+    }
+#else
+    RoutingTableFind (RoutingTable, RoutingTableSize, ChannelId, Index);
+#endif // def USE_OUTPUTMGR_DEBUG_COUNTERS
+
+    LastRoutingTableIndex = Index;
+    return Index;
+
+} // FindRoutingTableIndex
+
+//-----------------------------------------------------------------------------
+/*
+    Hand the data to the drivers that own the channels. The data may span
+    more than one driver. Caller must have checked the range and hold the
+    back buffer lock when double buffering is active.
+*/
+void c_OutputMgr::RouteChannelData (size_t StartChannelId, size_t ChannelCount, byte * pSourceData)
+{
+    size_t EndChannelId = StartChannelId + ChannelCount;
+    size_t RoutingTableIndex = FindRoutingTableIndex (StartChannelId);
+
+    while ((StartChannelId < EndChannelId) && (RoutingTableIndex < RoutingTableSize))
+    {
+        DriverInfo_t & currentOutputChannelDriver = *RoutingTable[RoutingTableIndex];
+
+        size_t lastChannelToSet = min(EndChannelId, currentOutputChannelDriver.EndChannelId);
+        size_t ChannelsToSet = lastChannelToSet - StartChannelId;
+        size_t RelativeStartChannelId = StartChannelId - currentOutputChannelDriver.StartingChannelId;
+        // DEBUG_V (String("               StartChannelId: 0x") + String(StartChannelId, HEX));
+        // DEBUG_V (String("                 EndChannelId: 0x") + String(EndChannelId, HEX));
+        // DEBUG_V (String("             lastChannelToSet: 0x") + String(lastChannelToSet, HEX));
+        // DEBUG_V (String("                ChannelsToSet: 0x") + String(ChannelsToSet, HEX));
+        if (currentOutputChannelDriver.pOutputChannelDriver->WriteChannelData(RelativeStartChannelId, ChannelsToSet, pSourceData))
+        {
+            currentOutputChannelDriver.BackBufferUpdated = true;
+        }
+
+        StartChannelId += ChannelsToSet;
+        pSourceData += ChannelsToSet;
+        ++RoutingTableIndex;
+    }
+
+} // RouteChannelData
+
 //-----------------------------------------------------------------------------
 void c_OutputMgr::WriteChannelData(size_t StartChannelId, size_t ChannelCount, byte *pSourceData)
 {
     // DEBUG_START;
 
+#ifdef USE_OUTPUTMGR_DEBUG_COUNTERS
+    uint32_t StartCycles = ESP.getCycleCount ();
+#endif // def USE_OUTPUTMGR_DEBUG_COUNTERS
+
     do // once
     {
         if (((StartChannelId + ChannelCount) > UsedBufferSize) || (0 == ChannelCount))
@@ -1295,49 +1987,77 @@ void c_OutputMgr::WriteChannelData(size_t StartChannelId, size_t ChannelCount, b
             break;
         }
 
-        // DEBUG_V (String("&OutputBuffer[StartChannelId]: 0x") + String(uint(&OutputBuffer[StartChannelId]), HEX));
-        size_t EndChannelId = StartChannelId + ChannelCount;
-        // Serial.print('1');
-        for (auto & currentOutputChannelDriver : OutputChannelDrivers)
+        // the output task latches the back buffer into the front buffer
+        bool LockNeeded = (pBackBuffer != pFrontBuffer);
+        if (LockNeeded)
         {
-            // Serial.print('2');
-            // does this output handle this block of data?
-            if (StartChannelId < currentOutputChannelDriver.StartingChannelId)
-            {
-                // we have gone beyond where we can put this data.
-                // Serial.print('3');
-                break;
-            }
+            LockBackBuffer ();
+        }
 
-            if (StartChannelId > currentOutputChannelDriver.EndChannelId)
-            {
-                // move to the next driver
-                // Serial.print('4');
-                continue;
-            }
-            // Serial.print('5');
+        RouteChannelData (StartChannelId, ChannelCount, pSourceData);
 
-            size_t lastChannelToSet = min(EndChannelId, currentOutputChannelDriver.EndChannelId);
-            size_t ChannelsToSet = lastChannelToSet - StartChannelId;
-            size_t RelativeStartChannelId = StartChannelId - currentOutputChannelDriver.StartingChannelId;
-            // DEBUG_V (String("               StartChannelId: 0x") + String(StartChannelId, HEX));
-            // DEBUG_V (String("                 EndChannelId: 0x") + String(EndChannelId, HEX));
-            // DEBUG_V (String("             lastChannelToSet: 0x") + String(lastChannelToSet, HEX));
-            // DEBUG_V (String("                ChannelsToSet: 0x") + String(ChannelsToSet, HEX));
-            if (ChannelsToSet)
-            {
-                currentOutputChannelDriver.pOutputChannelDriver->WriteChannelData(RelativeStartChannelId, ChannelsToSet, pSourceData);
-            }
-            StartChannelId += ChannelsToSet;
-            pSourceData += ChannelsToSet;
-            // memcpy(&OutputBuffer[StartChannelId], pSourceData, ChannelCount);
+        if (LockNeeded)
+        {
+            UnlockBackBuffer ();
         }
 
     } while (false);
+
+#ifdef USE_OUTPUTMGR_DEBUG_COUNTERS
+    WriteChannelDataCycles += ESP.getCycleCount () - StartCycles;
+    WriteChannelDataCounter++;
+#endif // def USE_OUTPUTMGR_DEBUG_COUNTERS
+
     // DEBUG_END;
 
 } // WriteChannelData
 
+//-----------------------------------------------------------------------------
+/*
+    Used by inputs that deliver one frame as several ranges (FSEQ sparse
+    ranges). The lock is taken once for the whole list so the output task
+    never latches a frame that only has some of the ranges.
+*/
+void c_OutputMgr::WriteChannelDataV (const ChannelDataSpan_t * pSpans, size_t NumSpans)
+{
+    // DEBUG_START;
+
+#ifdef USE_OUTPUTMGR_DEBUG_COUNTERS
+    uint32_t StartCycles = ESP.getCycleCount ();
+#endif // def USE_OUTPUTMGR_DEBUG_COUNTERS
+
+    bool LockNeeded = (pBackBuffer != pFrontBuffer);
+    if (LockNeeded)
+    {
+        LockBackBuffer ();
+    }
+
+    for (size_t SpanIndex = 0; SpanIndex < NumSpans; ++SpanIndex)
+    {
+        const ChannelDataSpan_t & CurrentSpan = pSpans[SpanIndex];
+        if (((CurrentSpan.StartChannelId + CurrentSpan.ChannelCount) > UsedBufferSize) || (0 == CurrentSpan.ChannelCount))
+        {
+            // DEBUG_V (String("ERROR: Invalid span"));
+            continue;
+        }
+
+        RouteChannelData (CurrentSpan.StartChannelId, CurrentSpan.ChannelCount, CurrentSpan.pData);
+    }
+
+    if (LockNeeded)
+    {
+        UnlockBackBuffer ();
+    }
+
+#ifdef USE_OUTPUTMGR_DEBUG_COUNTERS
+    WriteChannelDataCycles += ESP.getCycleCount () - StartCycles;
+    WriteChannelDataCounter++;
+#endif // def USE_OUTPUTMGR_DEBUG_COUNTERS
+
+    // DEBUG_END;
+
+} // WriteChannelDataV
+
 //-----------------------------------------------------------------------------
 void c_OutputMgr::ReadChannelData(size_t StartChannelId, size_t ChannelCount, byte *pTargetData)
 {
@@ -1345,7 +2065,7 @@ void c_OutputMgr::ReadChannelData(size_t StartChannelId, size_t ChannelCount, by
 
     do // once
     {
-        if ((StartChannelId + ChannelCount) > UsedBufferSize)
+        if (((StartChannelId + ChannelCount) > UsedBufferSize) || (0 == ChannelCount))
         {
             // DEBUG_V (String("ERROR: Invalid parameters"));
             // DEBUG_V (String("StartChannelId: ") + String(StartChannelId, HEX));
@@ -1353,39 +2073,22 @@ void c_OutputMgr::ReadChannelData(size_t StartChannelId, size_t ChannelCount, by
             // DEBUG_V (String("UsedBufferSize: ") + String(UsedBufferSize));
             break;
         }
-        // DEBUG_V (String("&OutputBuffer[StartChannelId]: 0x") + String(uint(&OutputBuffer[StartChannelId]), HEX));
+
         size_t EndChannelId = StartChannelId + ChannelCount;
-        // Serial.print('1');
-        for (auto & currentOutputChannelDriver : OutputChannelDrivers)
-        {
-            // Serial.print('2');
-            // does this output handle this block of data?
-            if (StartChannelId < currentOutputChannelDriver.StartingChannelId)
-            {
-                // we have gone beyond where we can put this data.
-                // Serial.print('3');
-                break;
-            }
+        size_t RoutingTableIndex = FindRoutingTableIndex (StartChannelId);
 
-            if (StartChannelId > currentOutputChannelDriver.EndChannelId)
-            {
-                // move to the next driver
-                // Serial.print('4');
-                continue;
-            }
-            // Serial.print('5');
+        while ((StartChannelId < EndChannelId) && (RoutingTableIndex < RoutingTableSize))
+        {
+            DriverInfo_t & currentOutputChannelDriver = *RoutingTable[RoutingTableIndex];
 
             size_t lastChannelToSet = min(EndChannelId, currentOutputChannelDriver.EndChannelId);
             size_t ChannelsToSet = lastChannelToSet - StartChannelId;
             size_t RelativeStartChannelId = StartChannelId - currentOutputChannelDriver.StartingChannelId;
-            // DEBUG_V (String("               StartChannelId: 0x") + String(StartChannelId, HEX));
-            // DEBUG_V (String("                 EndChannelId: 0x") + String(EndChannelId, HEX));
-            // DEBUG_V (String("             lastChannelToSet: 0x") + String(lastChannelToSet, HEX));
-            // DEBUG_V (String("                ChannelsToSet: 0x") + String(ChannelsToSet, HEX));
             currentOutputChannelDriver.pOutputChannelDriver->ReadChannelData(RelativeStartChannelId, ChannelsToSet, pTargetData);
+
             StartChannelId += ChannelsToSet;
             pTargetData += ChannelsToSet;
-            // memcpy(&OutputBuffer[StartChannelId], pTargetData, ChannelCount);
+            ++RoutingTableIndex;
         }
 
     } while (false);
@@ -1410,5 +2113,56 @@ void c_OutputMgr::ClearBuffer()
 
 } // ClearBuffer
 
+//-----------------------------------------------------------------------------
+/*
+    Used by inputs that write straight into the buffer returned by
+    GetBufferAddress instead of calling WriteChannelData. The output task
+    cannot latch a half written frame until EndDirectWrite is called.
+*/
+void c_OutputMgr::BeginDirectWrite ()
+{
+    // DEBUG_START;
+
+    LockBackBuffer ();
+
+    // DEBUG_END;
+
+} // BeginDirectWrite
+
+//-----------------------------------------------------------------------------
+void c_OutputMgr::EndDirectWrite ()
+{
+    // DEBUG_START;
+
+    MarkBufferChanged ();
+    UnlockBackBuffer ();
+
+    // DEBUG_END;
+
+} // EndDirectWrite
+
+//-----------------------------------------------------------------------------
+/*
+    Every output treats its whole buffer as changed.
+*/
+void c_OutputMgr::MarkBufferChanged ()
+{
+    // DEBUG_START;
+
+    for (auto & currentOutputChannelDriver : OutputChannelDrivers)
+    {
+        if (nullptr != currentOutputChannelDriver.pOutputChannelDriver)
+        {
+            currentOutputChannelDriver.pOutputChannelDriver->MarkAllDataChanged ();
+            currentOutputChannelDriver.BackBufferUpdated = true;
+        }
+    }
+
+    InputFrameComplete ();
+
+    // DEBUG_END;
+
+} // MarkBufferChanged
+
 // create a global instance of the output channel factory
 c_OutputMgr OutputMgr;
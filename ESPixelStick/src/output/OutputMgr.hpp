@@ -27,6 +27,10 @@
 #include "../memdebug.h"
 #include "../FileMgr.hpp"
 
+#ifdef ARDUINO_ARCH_ESP32
+#   include <esp_timer.h>
+#endif // def ARDUINO_ARCH_ESP32
+
 class c_OutputCommon; ///< forward declaration to the pure virtual output class that will be defined later.
 
 #ifdef UART_LAST
@@ -50,15 +54,28 @@ public:
     void      SetConfig         (ArduinoJson::JsonDocument & NewConfig);  ///< Save the current configuration data to nvram
     void      GetStatus         (JsonObject & jsonStatus);
     void      GetPortCounts     (uint16_t& PixelCount, uint16_t& SerialCount) {PixelCount = uint16_t(OutputChannelId_End); SerialCount = uint16_t(NUM_UARTS); }
-    uint8_t*  GetBufferAddress  () { return OutputBuffer; } ///< Get the address of the buffer into which the E1.31 handler will stuff data
+    uint8_t*  GetBufferAddress  () { return pBackBuffer; } ///< Get the address of the buffer into which the E1.31 handler will stuff data
     size_t    GetBufferUsedSize () { return UsedBufferSize; } ///< Get the size (in intensities) of the buffer into which the E1.31 handler will stuff data
-    size_t    GetBufferSize     () { return sizeof(OutputBuffer); } ///< Get the size (in intensities) of the buffer into which the E1.31 handler will stuff data
+    size_t    GetBufferSize     () { return BufferSize; } ///< Get the size (in intensities) of the buffer into which the E1.31 handler will stuff data
     void      DeleteConfig      () { FileMgr.DeleteConfigFile (ConfigFileName); }
     void      PauseOutputs      (bool NewState);
     void      GetDriverName     (String & Name) { Name = "OutputMgr"; }
     void      WriteChannelData  (size_t StartChannelId, size_t ChannelCount, byte * pData);
+    struct ChannelDataSpan_t
+    {
+        size_t  StartChannelId;
+        size_t  ChannelCount;
+        byte  * pData;
+    };
+    void      WriteChannelDataV (const ChannelDataSpan_t * pSpans, size_t NumSpans); ///< Write a list of channel ranges under one lock. The outputs never latch part of the list.
     void      ReadChannelData   (size_t StartChannelId, size_t ChannelCount, byte *pTargetData);
     void      ClearBuffer       ();
+    void      BeginDirectWrite  ();                        ///< Call before writing directly into the buffer returned by GetBufferAddress
+    void      EndDirectWrite    ();                        ///< Call when done. Every output treats its whole buffer as changed.
+    void      LockBackBuffer    ();                        ///< Held while the back buffer is written or latched into the front buffer
+    void      UnlockBackBuffer  ();
+    void      InputFrameComplete ();                       ///< Call when a complete frame has been written. Wakes the output task.
+    void      RenderOutputs     ();                        ///< One render pass over the drivers. Run by the output task / timer.
 
     // handles to determine which output channel we are dealing with
     enum e_OutputChannelIds
@@ -99,6 +116,55 @@ public:
 #if defined(SUPPORT_OutputType_Relay) || defined(SUPPORT_OutputType_Servo_PCA9685)
         OutputChannelId_Relay,
 #endif // def SUPPORT_RELAY_OUTPUT
+    // I2S lanes come after the older channels so saved configs keep their channel ids
+#ifdef DEFAULT_I2S_0_GPIO
+        OutputChannelId_I2S_1,
+#endif // def DEFAULT_I2S_0_GPIO
+#ifdef DEFAULT_I2S_1_GPIO
+        OutputChannelId_I2S_2,
+#endif // def DEFAULT_I2S_1_GPIO
+#ifdef DEFAULT_I2S_2_GPIO
+        OutputChannelId_I2S_3,
+#endif // def DEFAULT_I2S_2_GPIO
+#ifdef DEFAULT_I2S_3_GPIO
+        OutputChannelId_I2S_4,
+#endif // def DEFAULT_I2S_3_GPIO
+#ifdef DEFAULT_I2S_4_GPIO
+        OutputChannelId_I2S_5,
+#endif // def DEFAULT_I2S_4_GPIO
+#ifdef DEFAULT_I2S_5_GPIO
+        OutputChannelId_I2S_6,
+#endif // def DEFAULT_I2S_5_GPIO
+#ifdef DEFAULT_I2S_6_GPIO
+        OutputChannelId_I2S_7,
+#endif // def DEFAULT_I2S_6_GPIO
+#ifdef DEFAULT_I2S_7_GPIO
+        OutputChannelId_I2S_8,
+#endif // def DEFAULT_I2S_7_GPIO
+#ifdef DEFAULT_I2S_8_GPIO
+        OutputChannelId_I2S_9,
+#endif // def DEFAULT_I2S_8_GPIO
+#ifdef DEFAULT_I2S_9_GPIO
+        OutputChannelId_I2S_10,
+#endif // def DEFAULT_I2S_9_GPIO
+#ifdef DEFAULT_I2S_10_GPIO
+        OutputChannelId_I2S_11,
+#endif // def DEFAULT_I2S_10_GPIO
+#ifdef DEFAULT_I2S_11_GPIO
+        OutputChannelId_I2S_12,
+#endif // def DEFAULT_I2S_11_GPIO
+#ifdef DEFAULT_I2S_12_GPIO
+        OutputChannelId_I2S_13,
+#endif // def DEFAULT_I2S_12_GPIO
+#ifdef DEFAULT_I2S_13_GPIO
+        OutputChannelId_I2S_14,
+#endif // def DEFAULT_I2S_13_GPIO
+#ifdef DEFAULT_I2S_14_GPIO
+        OutputChannelId_I2S_15,
+#endif // def DEFAULT_I2S_14_GPIO
+#ifdef DEFAULT_I2S_15_GPIO
+        OutputChannelId_I2S_16,
+#endif // def DEFAULT_I2S_15_GPIO
 
         OutputChannelId_End, // must be last in the list
         OutputChannelId_Start = 0,
@@ -112,6 +178,11 @@ public:
         OutputChannelId_RMT_FIRST = OutputChannelId_RMT_1,
         OutputChannelId_RMT_LAST = RMT_LAST,
 #endif // def SUPPORT_RMT_OUTPUT
+
+#ifdef SUPPORT_I2S_OUTPUT
+        OutputChannelId_I2S_FIRST = OutputChannelId_I2S_1,
+        OutputChannelId_I2S_LAST = I2S_LAST,
+#endif // def SUPPORT_I2S_OUTPUT
     };
 
     // do NOT insert into the middle of this list. Always add new types to the end of the list
@@ -166,18 +237,36 @@ public:
     };
 
 #ifdef ARDUINO_ARCH_ESP8266
-#   define OM_MAX_NUM_CHANNELS      (1200 * 3)
 #   define OM_MAX_CONFIG_SIZE       ((size_t)(3 * 1024))
 #else // ARDUINO_ARCH_ESP32
 #   ifdef BOARD_HAS_PSRAM
-#       define OM_MAX_NUM_CHANNELS  (7000 * 3)
 #       define OM_MAX_CONFIG_SIZE   ((size_t)(20 * 1024))
 #   else
-#       define OM_MAX_NUM_CHANNELS  (3000 * 3)
 #       define OM_MAX_CONFIG_SIZE   ((size_t)(11 * 1024))
 #   endif // !def BOARD_HAS_PSRAM
 #endif // !def ARDUINO_ARCH_ESP32
 
+// Frames per second an output sends unless it is configured otherwise
+#define OM_DEFAULT_REFRESH_RATE     40
+#define OM_MAX_REFRESH_RATE         1000
+
+// The output buffer is allocated from the heap in blocks of this size
+#define OM_BUFFER_ALLOCATION_SIZE   64
+// Heap that must be left free for the rest of the system after the output buffer is allocated
+#ifdef ARDUINO_ARCH_ESP8266
+#   define OM_MIN_FREE_HEAP         ((size_t)(10 * 1024))
+#else
+#   define OM_MIN_FREE_HEAP         ((size_t)(32 * 1024))
+#endif // def ARDUINO_ARCH_ESP8266
+
+// The outputs are rendered by a task (ESP32) or a scheduled timer callback (ESP8266)
+// that wakes up when the next output frame is due.
+#define OM_OUTPUT_TASK_STACK_SIZE   4096
+#define OM_OUTPUT_TASK_PRIORITY     (ESP_TASK_PRIO_MIN + 5)
+#define OM_OUTPUT_TASK_CORE         ARDUINO_RUNNING_CORE    // same core as loop(). The RMT start skew is measured with the per core cycle counter.
+#define OM_OUTPUT_TASK_MIN_SLEEP_US 500
+#define OM_OUTPUT_TASK_MAX_SLEEP_US 5000
+
 private:
         // pointer(s) to the current active output drivers
         struct DriverInfo_t
@@ -187,6 +276,7 @@ private:
                 size_t StartingChannelId = 0;
                 size_t ChannelCount = 0;
                 size_t EndChannelId = 0;
+                bool   BackBufferUpdated = false;
     };
 
     DriverInfo_t OutputChannelDrivers[OutputChannelId_End];
@@ -197,17 +287,69 @@ private:
     bool ConfigLoadNeeded   = false;
     bool IsOutputPaused     = false;
     bool BuildingNewConfig  = false;
+    bool DoubleBufferEnabled = false;
+    bool SyncRmtStartEnabled = false;
 
     bool ProcessJsonConfig (JsonObject & jsonConfig);
     void CreateJsonConfig  (JsonObject & jsonConfig);
     void UpdateDisplayBufferReferences (void);
     void InstantiateNewOutputChannel(DriverInfo_t &ChannelIndex, e_OutputType NewChannelType, bool StartDriver = true);
     void CreateNewConfig();
+    bool SetUpFrameBuffers (size_t ChannelsNeeded);
+    void FreeFrameBuffers ();
+    size_t GetLargestFreeBlock ();
+    size_t GetMaxChannelsAvailable ();
+    void UpdateRoutingTable ();
+    size_t FindRoutingTableIndex (size_t ChannelId);
+    void RouteChannelData (size_t StartChannelId, size_t ChannelCount, byte * pSourceData);
+    void StartOutputTask ();
+    void ScheduleNextRenderPass ();
+    void LockOutputs ();
+    void UnlockOutputs ();
+    void MarkBufferChanged ();
+
+#ifdef ARDUINO_ARCH_ESP32
+    TaskHandle_t       OutputTaskHandle  = NULL;
+    esp_timer_handle_t OutputTimerHandle = NULL;
+    SemaphoreHandle_t  OutputLock        = NULL;  ///< The drivers. Held by the render pass and by config changes.
+    SemaphoreHandle_t  BackBufferLock    = NULL;  ///< The back buffer and its change tracking. Never held while a frame is sent.
+#else
+    Ticker             OutputTimer;
+    void ScheduleRenderPassInMs (uint32_t DelayMs) { OutputTimer.once_ms_scheduled (DelayMs, [this] () { RenderOutputs (); }); }
+#endif // def ARDUINO_ARCH_ESP32
+    bool               OutputTaskIsRunning = false;
+    volatile uint32_t  OutputLockCount     = 0;
+    uint32_t           RenderPassCount     = 0;
+    uint32_t           InputFrameCount     = 0;
 
     String ConfigFileName;
 
-    uint8_t OutputBuffer[OM_MAX_NUM_CHANNELS];
-    size_t  UsedBufferSize = 0;
+    // The buffers are sized from the channel counts of the configured drivers.
+    // The primary buffer is read by the ISRs so it is always in internal RAM.
+    uint8_t * pPrimaryBuffer   = nullptr;
+    size_t    BufferSize       = 0;
+    size_t    UsedBufferSize   = 0;
+
+    // When double buffering is active the inputs write into the back buffer
+    // and the drivers latch it into the front buffer at the start of each frame.
+    uint8_t * pSecondaryBuffer = nullptr;
+    bool      SecondaryBufferIsInPsram = false;
+    uint8_t * pBackBuffer      = nullptr;
+    uint8_t * pFrontBuffer     = nullptr;
+
+    // Drivers that own at least one channel, sorted by starting channel.
+    // Used to find the driver for a channel without scanning every driver.
+    DriverInfo_t * RoutingTable[OutputChannelId_End];
+    size_t         RoutingTableSize      = 0;
+    size_t         LastRoutingTableIndex = 0;
+
+// #define USE_OUTPUTMGR_DEBUG_COUNTERS
+#ifdef USE_OUTPUTMGR_DEBUG_COUNTERS
+    uint32_t WriteChannelDataCounter     = 0;
+    uint32_t WriteChannelDataCycles      = 0;
+    uint32_t RoutingTableCacheHitCounter = 0;
+    uint32_t RoutingTableSearchCounter   = 0;
+#endif // def USE_OUTPUTMGR_DEBUG_COUNTERS
 
 #ifdef SUPPORT_UART_OUTPUT
 #       define OM_IS_UART ((CurrentOutputChannelDriver.DriverId >= OutputChannelId_UART_FIRST) && (CurrentOutputChannelDriver.DriverId <= OutputChannelId_UART_LAST))
@@ -219,6 +361,11 @@ private:
 #else
 #   define OM_IS_RMT false
 #endif // def SUPPORT_RMT_OUTPUT
+#ifdef SUPPORT_I2S_OUTPUT
+#       define OM_IS_I2S ((CurrentOutputChannelDriver.DriverId >= OutputChannelId_I2S_FIRST) && (CurrentOutputChannelDriver.DriverId <= OutputChannelId_I2S_LAST))
+#else
+#   define OM_IS_I2S false
+#endif // def SUPPORT_I2S_OUTPUT
 
 }; // c_OutputMgr
 
@@ -20,8 +20,11 @@
 #include "../ESPixelStick.h"
 #include "OutputPixel.hpp"
 #include "OutputGECEFrame.hpp"
+#include "../FileMgr.hpp"
 
-#define ADJUST_INTENSITY_AT_ISR
+#ifdef ARDUINO_ARCH_ESP32
+#   include <esp_heap_caps.h>
+#endif // def ARDUINO_ARCH_ESP32
 
 //----------------------------------------------------------------------------
 c_OutputPixel::c_OutputPixel (c_OutputMgr::e_OutputChannelIds OutputChannelId,
@@ -32,6 +35,10 @@ c_OutputPixel::c_OutputPixel (c_OutputMgr::e_OutputChannelIds OutputChannelId,
 {
     // DEBUG_START;
 
+#ifdef SUPPORT_OutputType_GECE
+    SendGECEWords = (OutputType == OTYPE_t::OutputType_GECE);
+#endif // def SUPPORT_OutputType_GECE
+
     updateGammaTable ();
     updateColorOrderOffsets ();
 
@@ -43,6 +50,38 @@ c_OutputPixel::~c_OutputPixel ()
 {
     // DEBUG_START;
 
+    PreparedFrameLength = 0;
+    if (nullptr != pPreparedFrame)
+    {
+        free (pPreparedFrame);
+        pPreparedFrame = nullptr;
+    }
+
+    if (nullptr != pPixelMap)
+    {
+        free (pPixelMap);
+        pPixelMap = nullptr;
+    }
+
+    DitherBufferSize = 0;
+    if (nullptr != pDitherBuffer)
+    {
+        free (pDitherBuffer);
+        pDitherBuffer = nullptr;
+    }
+
+    if (nullptr != pWideGammaTable)
+    {
+        free (pWideGammaTable);
+        pWideGammaTable = nullptr;
+    }
+
+    if (nullptr != pHdrGammaTable)
+    {
+        free (pHdrGammaTable);
+        pHdrGammaTable = nullptr;
+    }
+
     // DEBUG_END;
 } // ~c_OutputPixel
 
@@ -60,6 +99,17 @@ void c_OutputPixel::GetConfig (ArduinoJson::JsonObject& jsonConfig)
     jsonConfig[CN_interframetime] = InterFrameGapInMicroSec;
     jsonConfig[CN_prependnullcount] = PrependNullPixelCount;
     jsonConfig[CN_appendnullcount] = AppendNullPixelCount;
+    jsonConfig[CN_prepareframe] = PrepareFrameEnabled;
+    jsonConfig[CN_dither] = DitherEnabled;
+    jsonConfig[CN_sixteenbitinput] = SixteenBitInput;
+    jsonConfig[CN_holdframe] = SkipUnchangedFrames;
+    jsonConfig[CN_keepalive] = KeepAliveIntervalMs;
+    jsonConfig[CN_refreshrate] = TargetRefreshRate;
+    jsonConfig[CN_map_width] = PixelMapWidth;
+    jsonConfig[CN_map_rotation] = PixelMapRotation;
+    jsonConfig[CN_map_mirror] = PixelMapMirror;
+    jsonConfig[CN_map_serpentine] = PixelMapSerpentine;
+    jsonConfig[CN_map_file] = PixelMapFileName;
 
     c_OutputCommon::GetConfig (jsonConfig);
 
@@ -73,6 +123,23 @@ void c_OutputPixel::GetStatus (ArduinoJson::JsonObject& jsonStatus)
 
     c_OutputCommon::GetStatus (jsonStatus);
 
+    if (PreparedFrameBufferSize)
+    {
+        jsonStatus["PrepareFrameTimeUs"]    = PrepareFrameTimeUs;
+        jsonStatus["PrepareFrameMaxTimeUs"] = PrepareFrameMaxTimeUs;
+    }
+
+    if (DitherBufferSize)
+    {
+        jsonStatus["DitherMemory"] = DitherBufferSize;
+    }
+
+    if (HdrBrightnessHeader)
+    {
+        // HDR needs the prepared frame
+        jsonStatus["HdrActive"] = (nullptr != pHdrGammaTable) && (0 != PreparedFrameBufferSize);
+    }
+
 #ifdef USE_PIXEL_DEBUG_COUNTERS
     JsonObject debugStatus = jsonStatus.createNestedObject("Pixel Debug");
     debugStatus["NumIntensityBytesPerPixel"]        = NumIntensityBytesPerPixel;
@@ -96,6 +163,9 @@ void c_OutputPixel::GetStatus (ArduinoJson::JsonObject& jsonStatus)
     debugStatus["NumGECEdataSent"]                  = NumGECEdataSent;
     debugStatus["GECEBrightness"]                   = GECEBrightness;
     debugStatus["AdjustedBrightness"]               = AdjustedBrightness;
+    debugStatus["IntensityIterator"]                = (PreparedFrameBufferSize) ? F("Prepared") : (nullptr == pIntensityIterator) ? F("Generic") : F("Fast");
+    debugStatus["IsrCyclesPerIntensity"]            = (0 == IsrIntensityCount) ? 0 : (IsrCycles / IsrIntensityCount);
+    debugStatus["IsrIntensityCount"]                = IsrIntensityCount;
 #endif // def USE_PIXEL_DEBUG_COUNTERS
 
     // DEBUG_END;
@@ -181,6 +251,17 @@ bool c_OutputPixel::SetConfig (ArduinoJson::JsonObject& jsonConfig)
     setFromJSON (InterFrameGapInMicroSec, jsonConfig, CN_interframetime);
     setFromJSON (PrependNullPixelCount, jsonConfig, CN_prependnullcount);
     setFromJSON (AppendNullPixelCount, jsonConfig, CN_appendnullcount);
+    setFromJSON (PrepareFrameEnabled, jsonConfig, CN_prepareframe);
+    setFromJSON (DitherEnabled, jsonConfig, CN_dither);
+    setFromJSON (SixteenBitInput, jsonConfig, CN_sixteenbitinput);
+    setFromJSON (SkipUnchangedFrames, jsonConfig, CN_holdframe);
+    setFromJSON (KeepAliveIntervalMs, jsonConfig, CN_keepalive);
+    setFromJSON (TargetRefreshRate, jsonConfig, CN_refreshrate);
+    setFromJSON (PixelMapWidth, jsonConfig, CN_map_width);
+    setFromJSON (PixelMapRotation, jsonConfig, CN_map_rotation);
+    setFromJSON (PixelMapMirror, jsonConfig, CN_map_mirror);
+    setFromJSON (PixelMapSerpentine, jsonConfig, CN_map_serpentine);
+    setFromJSON (PixelMapFileName, jsonConfig, CN_map_file);
 
     // DEBUG_V (String ("PrependNullPixelCount: ") + String (PrependNullPixelCount));
     // DEBUG_V (String (" AppendNullPixelCount: ") + String (AppendNullPixelCount));
@@ -206,6 +287,10 @@ bool c_OutputPixel::SetConfig (ArduinoJson::JsonObject& jsonConfig)
     PixelGroupSize = (2 > PixelGroupSize) ? 1 : PixelGroupSize;
 
     SetFrameDurration(IntensityBitTimeInUs, BlockSize, BlockDelayUs);
+    UpdatePixelMap ();
+    UpdatePreparedFrameBuffer ();
+    UpdateDitherBuffer ();
+    SelectIntensityIterator ();
 
     // DEBUG_V (String ("ZigPixelCount: ") + String (ZigPixelCount));
     // DEBUG_V (String ("ZagPixelCount: ") + String (ZagPixelCount));
@@ -231,6 +316,63 @@ void c_OutputPixel::updateGammaTable ()
         // DEBUG_V (String ("gamma_table[i]: ") + String (gamma_table[i]));
     }
 
+    if ((1 != IntensityMultiplier) && (IntensityMultiplier <= 256) && (nullptr == pWideGammaTable))
+    {
+        // The ISR reads this table so it must be in internal RAM
+#ifdef ARDUINO_ARCH_ESP32
+        pWideGammaTable = (uint16_t *)heap_caps_malloc (257 * sizeof (uint16_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+#else
+        pWideGammaTable = (uint16_t *)malloc (257 * sizeof (uint16_t));
+#endif // def ARDUINO_ARCH_ESP32
+        if (nullptr == pWideGammaTable)
+        {
+            logcon (String (F ("Could not allocate the wide gamma table. Sending 8 bit intensities.")));
+        }
+    }
+
+    if (nullptr != pWideGammaTable)
+    {
+        // full resolution curve for outputs with more than 8 bits per intensity. Brightness is included.
+        double IntensityMaxValue = double (IntensityMultiplier * 256) - 1.0;
+        for (unsigned int i = 0; i < 256; ++i)
+        {
+            pWideGammaTable[i] = (uint16_t)min ((IntensityMaxValue * pow (i * tempBrightness / 255, gamma) * AdjustedBrightness / 256.0 + 0.5), IntensityMaxValue);
+        }
+        pWideGammaTable[256] = pWideGammaTable[255];
+    }
+
+    if (HdrBrightnessHeader && (nullptr == pHdrGammaTable))
+    {
+        pHdrGammaTable = (uint16_t *)malloc (256 * sizeof (uint16_t));
+        if (nullptr == pHdrGammaTable)
+        {
+            logcon (String (F ("Could not allocate the HDR gamma table. HDR is disabled.")));
+        }
+    }
+    else if (!HdrBrightnessHeader && (nullptr != pHdrGammaTable))
+    {
+        free (pHdrGammaTable);
+        pHdrGammaTable = nullptr;
+    }
+
+    if (nullptr != pHdrGammaTable)
+    {
+        // 0 - 65280. Same scale as the dither table.
+        for (unsigned int i = 0; i < 256; ++i)
+        {
+            pHdrGammaTable[i] = (uint16_t)min ((255.0 * pow (i * tempBrightness / 255, gamma) * AdjustedBrightness + 0.5), 65280.0);
+        }
+    }
+
+    if (nullptr != pDitherTable)
+    {
+        // same curve as gamma_table * AdjustedBrightness with 8 fractional bits kept
+        for (unsigned int i = 0; i < 256; ++i)
+        {
+            pDitherTable[i] = (uint16_t)min ((255.0 * pow (i * tempBrightness / 255, gamma) * AdjustedBrightness + 0.5), 65280.0);
+        }
+    }
+
     // DEBUG_END;
 } // updateGammaTable
 
@@ -287,6 +429,19 @@ bool c_OutputPixel::validate ()
         zig_size = 1;
     }
 
+    if ((0 != PixelMapRotation) && (90 != PixelMapRotation) && (180 != PixelMapRotation) && (270 != PixelMapRotation))
+    {
+        logcon (CN_stars + String (F (" Requested map rotation is not supported. Setting to 0 ")) + CN_stars);
+        PixelMapRotation = 0;
+        response = false;
+    }
+
+    if (PixelMapWidth > pixel_count)
+    {
+        PixelMapWidth = pixel_count;
+        response = false;
+    }
+
     // Default gamma value
     if (gamma <= 0)
     {
@@ -294,6 +449,13 @@ bool c_OutputPixel::validate ()
         response = false;
     }
 
+    // Max refresh rate value
+    if (TargetRefreshRate > OM_MAX_REFRESH_RATE)
+    {
+        TargetRefreshRate = OM_MAX_REFRESH_RATE;
+        response = false;
+    }
+
     // Max brightness value
     if (brightness > 100)
     {
@@ -311,17 +473,13 @@ bool c_OutputPixel::validate ()
 void c_OutputPixel::SetFrameDurration (float IntensityBitTimeInUs, uint16_t BlockSize, float BlockDelayUs)
 {
     // DEBUG_START;
-    if (0 == BlockSize) { BlockSize = 1; }
-
-    float TotalIntensityBytes       = OutputBufferSize * PixelGroupSize;
+    float TotalIntensityBytes       = (OutputBufferSize / IntensityInputBytes) * PixelGroupSize;
     float TotalNullBytes            = (PrependNullPixelCount + AppendNullPixelCount) * NumIntensityBytesPerPixel;
     float TotalBytesOfIntensityData = (TotalIntensityBytes + TotalNullBytes + FramePrependDataSize);
-    float TotalBits                 = TotalBytesOfIntensityData * 8.0;
-    uint16_t NumBlocks              = uint16_t (TotalBytesOfIntensityData / float (BlockSize));
-    int TotalBlockDelayUs           = int (float (NumBlocks) * BlockDelayUs);
+    float BitsPerIntensity          = float (8 + __builtin_ctz (IntensityMultiplier));
 
-    uint32_t _FrameMinDurationInMicroSec = (IntensityBitTimeInUs * TotalBits) + InterFrameGapInMicroSec + TotalBlockDelayUs;
-    FrameMinDurationInMicroSec = max(uint32_t(25000), _FrameMinDurationInMicroSec);
+    // This is the wire time. The configured refresh rate can only slow the output down from here.
+    FrameMinDurationInMicroSec = FramePacingWireTimeInMicroSec (TotalBytesOfIntensityData, BitsPerIntensity, IntensityBitTimeInUs, InterFrameGapInMicroSec, BlockSize, BlockDelayUs);
 
     // DEBUG_V (String ("           OutputBufferSize: ") + String (OutputBufferSize));
     // DEBUG_V (String ("             PixelGroupSize: ") + String (PixelGroupSize));
@@ -332,14 +490,10 @@ void c_OutputPixel::SetFrameDurration (float IntensityBitTimeInUs, uint16_t Bloc
     // DEBUG_V (String ("             TotalNullBytes: ") + String (TotalNullBytes));
     // DEBUG_V (String ("       FramePrependDataSize: ") + String (FramePrependDataSize));
     // DEBUG_V (String ("  TotalBytesOfIntensityData: ") + String (TotalBytesOfIntensityData));
-    // DEBUG_V (String ("                  TotalBits: ") + String (TotalBits));
     // DEBUG_V (String ("                  BlockSize: ") + String (BlockSize));
-    // DEBUG_V (String ("                  NumBlocks: ") + String (NumBlocks));
     // DEBUG_V (String ("               BlockDelayUs: ") + String (BlockDelayUs));
-    // DEBUG_V (String ("          TotalBlockDelayUs: ") + String (TotalBlockDelayUs));
     // DEBUG_V (String ("       IntensityBitTimeInUs: ") + String (IntensityBitTimeInUs));
     // DEBUG_V (String ("    InterFrameGapInMicroSec: ") + String (InterFrameGapInMicroSec));
-    // DEBUG_V (String ("_FrameMinDurationInMicroSec: ") + String (_FrameMinDurationInMicroSec));
     // DEBUG_V (String (" FrameMinDurationInMicroSec: ") + String (FrameMinDurationInMicroSec));
 
     // DEBUG_END;
@@ -359,27 +513,18 @@ void IRAM_ATTR c_OutputPixel::StartNewFrame ()
     FrameStartCounter++;
 #endif // def USE_PIXEL_DEBUG_COUNTERS
 
-    NextPixelToSend = GetBufferAddress();
-    FramePrependDataCurrentIndex    = 0;
-    FrameAppendDataCurrentIndex     = 0;
-    ZigPixelCurrentCount            = 1;
-    ZagPixelCurrentCount            = 0;
-    SentPixelsCount                 = 0;
-    PixelIntensityCurrentIndex      = 0;
-    PixelGroupSizeCurrentCount      = 0;
-    PrependNullPixelCurrentCount    = 0;
-    AppendNullPixelCurrentCount     = 0;
-    PixelPrependDataCurrentIndex    = 0;
-    GECEPixelId                     = 0;
-    
-    FrameState     = (FramePrependDataSize)  ? FrameState_t::FramePrependData : FrameState_t::FrameSendPixels;
-    PixelSendState = (PrependNullPixelCount) ? PixelSendState_t::PixelPrependNulls : PixelSendState_t::PixelSendIntensity;
+    // this frame carries every change marked so far
+    RefreshStarted ();
+    LatchFrame();
 
-#ifdef USE_PIXEL_DEBUG_COUNTERS
-    SentPixels         = SentPixelsCount;
-    PixelsToSend       = pixel_count;
-    IntensityBytesSent = 0;
-#endif // def USE_PIXEL_DEBUG_COUNTERS
+    PreparedFrameLength       = 0;
+    PreparedFrameCurrentIndex = 0;
+    if (PreparedFrameBufferSize)
+    {
+        PrepareFrame ();
+    }
+
+    StartIterator (GetBufferAddress (), GetBufferUsedSize ());
 
     // NumIntensityBytesPerPixel = 1;
     ReportNewFrame();
@@ -392,348 +537,764 @@ void c_OutputPixel::SetIntensityDataWidth(uint32_t DataWidth)
 {
     uint32_t IntensityMaxValue = (1 << DataWidth);
     IntensityMultiplier = IntensityMaxValue / 256;
+    updateGammaTable ();
+    UpdatePreparedFrameBuffer ();
+    UpdateDitherBuffer ();
+    SelectIntensityIterator ();
 
 } // SetIntensityDataWidth
 
 //----------------------------------------------------------------------------
-uint32_t IRAM_ATTR c_OutputPixel::ISR_GetNextIntensityToSend ()
+void c_OutputPixel::SetPixelCount (size_t value)
 {
-    uint32_t response = 0x00;
+    // DEBUG_START;
 
-#ifdef USE_PIXEL_DEBUG_COUNTERS
-    GetNextIntensityToSendCounter++;
-#endif // def USE_PIXEL_DEBUG_COUNTERS
+    if (value != pixel_count)
+    {
+        pixel_count = value;
+        UpdatePixelMap ();
+        UpdatePreparedFrameBuffer ();
+        UpdateDitherBuffer ();
+        SelectIntensityIterator ();
+    }
 
-    switch (FrameState)
+    // DEBUG_END;
+
+} // SetPixelCount
+
+//----------------------------------------------------------------------------
+size_t c_OutputPixel::GetPreparedFrameSizeNeeded ()
+{
+    // DEBUG_START;
+
+#ifdef SUPPORT_OutputType_GECE
+    if (OutputType == OTYPE_t::OutputType_GECE)
+    {
+        // one complete GECE word per pixel
+        return pixel_count * PixelGroupSize;
+    }
+#endif // def SUPPORT_OutputType_GECE
+
+    size_t BytesPerPixel   = PixelPrependDataSize + NumIntensityBytesPerPixel;
+    size_t NumPixelsToSend = PrependNullPixelCount + (pixel_count * PixelGroupSize) + AppendNullPixelCount;
+
+    // DEBUG_END;
+    return FramePrependDataSize + (NumPixelsToSend * BytesPerPixel) + FrameAppendDataSize;
+
+} // GetPreparedFrameSizeNeeded
+
+//----------------------------------------------------------------------------
+/*
+    The prepared frame holds one byte per transmitted intensity value. Outputs
+    that send more than 8 bits per intensity use one 16 bit word per value.
+    GECE always uses a prepared frame of one 32 bit word per pixel so that
+    the ISR does not have to assemble the words. Null pixels are not sent
+    as GECE words and still use the ISR state machine. 16 bit input is only
+    read while the frame is prepared so it turns the prepared frame on.
+*/
+void c_OutputPixel::UpdatePreparedFrameBuffer ()
+{
+    // DEBUG_START;
+
+    size_t NewBufferSize        = 0;
+    size_t NewBytesPerIntensity = (nullptr == pWideGammaTable) ? 1 : 2;
+    bool   UseSixteenBitInput   = SixteenBitInput && (nullptr != pWideGammaTable);
+
+#ifdef ADJUST_INTENSITY_AT_ISR
+#ifdef SUPPORT_OutputType_GECE
+    if (OutputType == OTYPE_t::OutputType_GECE)
     {
-        case FrameState_t::FramePrependData:
+        NewBytesPerIntensity = sizeof (uint32_t);
+        UseSixteenBitInput   = false;
+        if ((0 == PrependNullPixelCount) && (0 == AppendNullPixelCount))
         {
-#ifdef USE_PIXEL_DEBUG_COUNTERS
-            FramePrependDataCounter++;
-#endif // def USE_PIXEL_DEBUG_COUNTERS
+            NewBufferSize = GetPreparedFrameSizeNeeded () * NewBytesPerIntensity;
+        }
+    }
+    else
+#endif // def SUPPORT_OutputType_GECE
+    if ((PrepareFrameEnabled || DitherEnabled || UseSixteenBitInput || HdrBrightnessHeader) &&
+        ((1 == IntensityMultiplier) || (nullptr != pWideGammaTable)))
+    {
+        NewBufferSize = GetPreparedFrameSizeNeeded () * NewBytesPerIntensity;
+    }
+#endif // def ADJUST_INTENSITY_AT_ISR
 
-            response = pFramePrependData[FramePrependDataCurrentIndex];
-            if (++FramePrependDataCurrentIndex < FramePrependDataSize)
-            {
-                break;
-            }
+    do // once
+    {
+        if ((NewBufferSize == PreparedFrameBufferSize) && (NewBytesPerIntensity == PreparedFrameBytesPerIntensity))
+        {
+            // DEBUG_V ("No change in the prepared frame buffer");
+            break;
+        }
 
-            // FramePrependDataCurrentIndex = 0;
-            FrameState = FrameState_t::FrameSendPixels;
-            // PixelIntensityCurrentIndex = 0;
-            // PixelPrependDataCurrentIndex = 0;
+        // stop the ISR from using the old buffer
+        bool WasPaused = OutputIsPaused;
+        if (nullptr != pPreparedFrame)
+        {
+            PauseOutput (true);
+        }
+
+        PreparedFrameLength     = 0;
+        PreparedFrameBufferSize = 0;
+        PreparedFrameBytesPerIntensity = NewBytesPerIntensity;
+
+        if (nullptr != pPreparedFrame)
+        {
+            free (pPreparedFrame);
+            pPreparedFrame = nullptr;
+            PauseOutput (WasPaused);
+        }
+
+        if (0 == NewBufferSize)
+        {
             break;
-        } // case FrameState_t::FramePrependData
+        }
 
-        case FrameState_t::FrameSendPixels:
+        // The ISR reads this buffer so it must be in internal RAM
+#ifdef ARDUINO_ARCH_ESP32
+        pPreparedFrame = (uint8_t *)heap_caps_malloc (NewBufferSize, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+#else
+        pPreparedFrame = (uint8_t *)malloc (NewBufferSize);
+#endif // def ARDUINO_ARCH_ESP32
+        if (nullptr == pPreparedFrame)
         {
-#ifdef USE_PIXEL_DEBUG_COUNTERS
-            FrameSendPixelsCounter++;
-#endif // def USE_PIXEL_DEBUG_COUNTERS
+            logcon (String (F ("Could not allocate ")) + String (NewBufferSize) + String (F (" bytes for the prepared frame. Using the ISR to format the data.")));
+            break;
+        }
 
-            switch (PixelSendState)
-            {
-                default:
-                {
-#ifdef USE_PIXEL_DEBUG_COUNTERS
-                    PixelUnkownState++;
-                    break;
-#endif // def USE_PIXEL_DEBUG_COUNTERS
-                }
-                
-                case PixelSendState_t::PixelPrependNulls:
-                {
-#ifdef USE_PIXEL_DEBUG_COUNTERS
-                    PixelPrependNullsCounter++;
-#endif // def USE_PIXEL_DEBUG_COUNTERS
-                    if (PixelPrependDataCurrentIndex < PixelPrependDataSize)
-                    {
-                        response = PixelPrependData[PixelPrependDataCurrentIndex++] * IntensityMultiplier;
-                        break;
-                    }
-
-                    // response = 0x00;
-
-                    // has the pixel completed?
-                    if (++PixelIntensityCurrentIndex < NumIntensityBytesPerPixel)
-                    {
-                        break;
-                    }
-
-                    // pixel is complete. Move to the next one
-                    PixelIntensityCurrentIndex = 0;
-                    PixelPrependDataCurrentIndex = 0;
-
-                    if (++PrependNullPixelCurrentCount < PrependNullPixelCount)
-                    {
-                        break;
-                    }
-
-                    // no more null pixels to send
-                    // PrependNullPixelCurrentCount = 0;
-                    PixelSendState = PixelSendState_t::PixelSendIntensity;
-                    break;
-                } // case PixelSendState_t::PixelPrependNulls:
+        PreparedFrameBufferSize = NewBufferSize;
+        PrepareFrameMaxTimeUs   = 0;
 
-                case PixelSendState_t::PixelSendIntensity:
-                {
-#ifdef USE_PIXEL_DEBUG_COUNTERS
-                    PixelSendIntensityCounter++;
-                    IntensityBytesSent++;
-#endif // def USE_PIXEL_DEBUG_COUNTERS
+    } while (false);
 
-                    // pixel prepend goes here
-                    if (PixelPrependDataCurrentIndex < PixelPrependDataSize)
-                    {
-                        response = PixelPrependData[PixelPrependDataCurrentIndex++];
-                        break;
-                    }
-#ifdef SUPPORT_OutputType_GECE
-                    if (OutputType == OTYPE_t::OutputType_GECE)
-                    {
-                        // build a GECE intensity frame
-                        response = GECEBrightness;
-                        response |= GECE_SET_ADDRESS(GECEPixelId++);
-                        response |= GECE_SET_RED(GetIntensityData());
-                        response |= GECE_SET_GREEN(GetIntensityData());
-                        response |= GECE_SET_BLUE(GetIntensityData());
-#ifdef USE_PIXEL_DEBUG_COUNTERS
-                        LastGECEdataSent = response;
-                        NumGECEdataSent++;
-#endif // def USE_PIXEL_DEBUG_COUNTERS
-                    }
-                    else
-#endif // def SUPPORT_OutputType_GECE
-                    {
-                        response = GetIntensityData();
-                    }
-                    break;
-                } // case PixelSendState_t::PixelSendIntensity:
+    // the channel pairs can only be decoded while preparing the frame
+    IntensityInputBytes = (UseSixteenBitInput && PreparedFrameBufferSize) ? 2 : 1;
 
-                case PixelSendState_t::PixelAppendNulls:
-                {
-#ifdef USE_PIXEL_DEBUG_COUNTERS
-                    PixelAppendNullsCounter++;
-#endif // def USE_PIXEL_DEBUG_COUNTERS
-       // pixel prepend goes here
-                    if (PixelPrependDataCurrentIndex < PixelPrependDataSize)
-                    {
-                        response = PixelPrependData[PixelPrependDataCurrentIndex++];
-                        break;
-                    }
-
-                    // response = 0x00;
-
-                    // has the pixel completed?
-                    if (++PixelIntensityCurrentIndex < NumIntensityBytesPerPixel)
-                    {
-                        break;
-                    }
-
-                    // pixel is complete. Move to the next one
-                    PixelIntensityCurrentIndex = 0;
-                    PixelPrependDataCurrentIndex = 0;
-
-                    if (++AppendNullPixelCurrentCount < AppendNullPixelCount)
-                    {
-                        break;
-                    }
-                    // AppendNullPixelCurrentCount = 0;
-
-                    if (FrameAppendDataSize)
-                    {
-                        // FrameAppendDataCurrentCount = 0;
-                        FrameState = FrameState_t::FrameAppendData;
-                        break;
-                    }
-
-                    FrameState = FrameState_t::FrameDone;
+    // DEBUG_V (String ("PreparedFrameBufferSize: ") + String (PreparedFrameBufferSize));
 
-                    break;
-                } // case PixelSendState_t::PixelAppendNulls:
+    // DEBUG_END;
+
+} // UpdatePreparedFrameBuffer
+
+//----------------------------------------------------------------------------
+/*
+    Dithering is applied while the frame is prepared so it is only available
+    when the prepared frame buffer exists. The table and one error byte per
+    intensity must fit in PIXEL_MAX_DITHER_MEMORY.
+*/
+void c_OutputPixel::UpdateDitherBuffer ()
+{
+    // DEBUG_START;
+
+    size_t NewBufferSize = 0;
+
+    if (DitherEnabled && !HdrBrightnessHeader && PreparedFrameBufferSize && (1 == PreparedFrameBytesPerIntensity))
+    {
+        NewBufferSize = (256 * sizeof (uint16_t)) + (pixel_count * NumIntensityBytesPerPixel);
+    }
 
-            } // switch SendPixelsState
+    do // once
+    {
+        if (NewBufferSize == DitherBufferSize)
+        {
+            // DEBUG_V ("No change in the dither buffer");
             break;
-        } // case FrameState_t::FrameSendPixels
+        }
 
-        case FrameState_t::FrameAppendData:
+        // stop PrepareFrame from using the old buffer
+        DitherBufferSize = 0;
+        pDitherTable     = nullptr;
+        pDitherError     = nullptr;
+
+        if (nullptr != pDitherBuffer)
+        {
+            free (pDitherBuffer);
+            pDitherBuffer = nullptr;
+        }
+
+        if (0 == NewBufferSize)
         {
-#ifdef USE_PIXEL_DEBUG_COUNTERS
-            FrameAppendDataCounter++;
-#endif // def USE_PIXEL_DEBUG_COUNTERS
-            response = pFrameAppendData[FrameAppendDataCurrentIndex];
-            if (++FrameAppendDataCurrentIndex < FrameAppendDataSize)
-            {
-                break;
-            }
-            // FrameAppendDataCurrentIndex = 0;
-            FrameState = FrameState_t::FrameDone;
             break;
-        } // case FrameState_t::FrameAppendData
+        }
 
-        case FrameState_t::FrameDone:
+        if (NewBufferSize > PIXEL_MAX_DITHER_MEMORY)
         {
-#ifdef USE_PIXEL_DEBUG_COUNTERS
-            FrameDoneCounter++;
-            response = 0x55;
-#endif // def USE_PIXEL_DEBUG_COUNTERS
+            logcon (String (F ("Dithering needs ")) + String (NewBufferSize) + String (F (" bytes. The limit is ")) + String (PIXEL_MAX_DITHER_MEMORY) + String (F (". Dithering is disabled.")));
             break;
-        } // case FrameState_t::FrameDone
+        }
 
-        default:
+        // only used in task context so it does not need to be in internal RAM
+        pDitherBuffer = (uint8_t *)malloc (NewBufferSize);
+        if (nullptr == pDitherBuffer)
         {
-#ifdef USE_PIXEL_DEBUG_COUNTERS
-            FrameStateUnknownCounter++;
-#endif // def USE_PIXEL_DEBUG_COUNTERS
+            logcon (String (F ("Could not allocate ")) + String (NewBufferSize) + String (F (" bytes for dithering. Dithering is disabled.")));
+            break;
         }
-        } // switch FrameState
 
-        if (InvertData)
+        pDitherTable = (uint16_t *)pDitherBuffer;
+        pDitherError = &pDitherBuffer[256 * sizeof (uint16_t)];
+
+        // start each intensity at a different point so the pixels do not all step on the same refresh
+        size_t NumErrors = NewBufferSize - (256 * sizeof (uint16_t));
+        for (size_t ErrorId = 0; ErrorId < NumErrors; ++ErrorId)
         {
-            response = ~response;
+            pDitherError[ErrorId] = uint8_t (ErrorId * 97);
         }
 
-        return response;
+        updateGammaTable ();
+        DitherBufferSize = NewBufferSize;
+
+    } while (false);
+
+    // DEBUG_V (String ("DitherBufferSize: ") + String (DitherBufferSize));
+
+    // DEBUG_END;
 
-} // NextIntensityToSend
+} // UpdateDitherBuffer
 
 //----------------------------------------------------------------------------
-uint32_t IRAM_ATTR c_OutputPixel::GetIntensityData()
+/*
+    Called in task context at the start of each frame. Applies color order,
+    gamma, brightness, dithering, grouping, zig zag and null pixels so that
+    the ISR only has to copy intensities to the hardware.
+*/
+void c_OutputPixel::PrepareFrame ()
 {
-    uint32_t response = 0;
+    // DEBUG_START;
+
+    uint32_t StartTimeUs = micros ();
 
     do // once
     {
-#ifdef ADJUST_INTENSITY_AT_ISR
-        response = (NextPixelToSend[ColorOffsets.Array[PixelIntensityCurrentIndex]]);
-        response = gamma_table[response];
-        response = uint8_t((uint32_t(response) * AdjustedBrightness) >> 8);
-
-        // has the pixel completed?
-        ++PixelIntensityCurrentIndex;
-        if (PixelIntensityCurrentIndex < NumIntensityBytesPerPixel)
+        // the frame layout changed since the buffer was allocated
+        if ((GetPreparedFrameSizeNeeded () * PreparedFrameBytesPerIntensity) != PreparedFrameBufferSize)
         {
-            // response = 0xF0;
+            // DEBUG_V ("Frame size mismatch. Use the ISR path");
             break;
         }
-        // response = 0xFF;
-
-        PixelIntensityCurrentIndex = 0;
-        PixelPrependDataCurrentIndex = 0;
 
-        // has the group completed?
-        if (++PixelGroupSizeCurrentCount < PixelGroupSize)
+#ifdef SUPPORT_OutputType_GECE
+        if (sizeof (uint32_t) == PreparedFrameBytesPerIntensity)
         {
-            // not finished with the group yet
-            break;
+            PreparedFrameLength = BuildGECEFrame ((uint32_t *)pPreparedFrame);
+        }
+        else
+#endif // def SUPPORT_OutputType_GECE
+        if (2 == PreparedFrameBytesPerIntensity)
+        {
+            PreparedFrameLength = BuildPreparedFrame ((uint16_t *)pPreparedFrame);
+        }
+        else
+        {
+            PreparedFrameLength = BuildPreparedFrame (pPreparedFrame);
         }
 
-        // refresh the group count
-        PixelGroupSizeCurrentCount = 0;
+    } while (false);
+
+    PrepareFrameTimeUs    = micros () - StartTimeUs;
+    PrepareFrameMaxTimeUs = max (PrepareFrameMaxTimeUs, PrepareFrameTimeUs);
+
+    // DEBUG_END;
+
+} // PrepareFrame
+
+//----------------------------------------------------------------------------
+/*
+    Fill the prepared frame. IntensityType is uint8_t for 8 bit outputs and
+    uint16_t for outputs that send wider intensities. Returns the number of
+    intensities in the frame.
+*/
+template <typename IntensityType>
+size_t c_OutputPixel::BuildPreparedFrame (IntensityType * pFrame)
+{
+    // DEBUG_START;
 
-        ++SentPixelsCount;
-        if (SentPixelsCount >= pixel_count)
+    IntensityType * pOutput = pFrame;
+
+    for (size_t DataId = 0; DataId < FramePrependDataSize; ++DataId)
+    {
+        *pOutput++ = pFramePrependData[DataId];
+    }
+
+    for (size_t NullPixelCount = 0; NullPixelCount < PrependNullPixelCount; ++NullPixelCount)
+    {
+        for (size_t DataId = 0; DataId < PixelPrependDataSize; ++DataId)
         {
-#ifdef USE_PIXEL_DEBUG_COUNTERS
-            FrameEndCounter++;
-#endif // def USE_PIXEL_DEBUG_COUNTERS
+            *pOutput++ = PixelPrependData[DataId] * IntensityMultiplier;
+        }
+        for (size_t IntensityId = 0; IntensityId < NumIntensityBytesPerPixel; ++IntensityId)
+        {
+            *pOutput++ = 0;
+        }
+    }
 
-            // response = 0xaa;
-            if (AppendNullPixelCount)
+    size_t BytesPerPixel         = PixelPrependDataSize + NumIntensityBytesPerPixel;
+    size_t SourceBytesPerPixel   = NumIntensityBytesPerPixel * IntensityInputBytes;
+    bool   EncodeHdr             = (1 == sizeof (IntensityType)) && (1 == PixelPrependDataSize) && (nullptr != pHdrGammaTable);
+    for (size_t PixelId = 0; PixelId < pixel_count; ++PixelId)
+    {
+        size_t SourcePixelId = PixelId;
+
+        if (nullptr != pPixelMap)
+        {
+            SourcePixelId = pPixelMap[PixelId];
+        }
+        // is this pixel in a backwards zig zag group?
+        else if (zig_size > 1)
+        {
+            size_t ZigZagGroupId = PixelId / zig_size;
+            if (0 != (ZigZagGroupId & 0x1))
             {
-                PixelPrependDataCurrentIndex = 0;
-                PixelIntensityCurrentIndex = 0;
-                AppendNullPixelCurrentCount = 0;
+                SourcePixelId = (ZigZagGroupId * zig_size) + (zig_size - 1) - (PixelId % zig_size);
+            }
+        }
 
-                PixelSendState = PixelSendState_t::PixelAppendNulls;
+        uint8_t       * pSourcePixel = &pOutputBuffer[SourcePixelId * SourceBytesPerPixel];
+        IntensityType * pFirstPixel  = pOutput;
+
+        for (size_t DataId = 0; DataId < PixelPrependDataSize; ++DataId)
+        {
+            *pOutput++ = PixelPrependData[DataId];
+        }
+
+        if (EncodeHdr)
+        {
+            // replaces the pixel header with the brightness for this pixel
+            EncodeHdrPixel (pSourcePixel, (uint8_t *)(pOutput - 1));
+            pOutput += NumIntensityBytesPerPixel;
+        }
+        else if (sizeof (IntensityType) > 1)
+        {
+            for (size_t IntensityId = 0; IntensityId < NumIntensityBytesPerPixel; ++IntensityId)
+            {
+                size_t ColorOffset = ColorOffsets.Array[IntensityId];
+                if (2 == IntensityInputBytes)
+                {
+                    // channel pairs are sent most significant byte first
+                    uint32_t Coarse = pSourcePixel[ColorOffset * 2];
+                    uint32_t Fine   = pSourcePixel[(ColorOffset * 2) + 1];
+                    uint32_t Low    = pWideGammaTable[Coarse];
+                    uint32_t High   = pWideGammaTable[Coarse + 1];
+                    *pOutput++ = IntensityType (Low + (((High - Low) * Fine) >> 8));
+                }
+                else
+                {
+                    *pOutput++ = pWideGammaTable[pSourcePixel[ColorOffset]];
+                }
             }
-            else if (FrameAppendDataSize)
+        }
+        else if (DitherBufferSize)
+        {
+            // send the integer part and carry the fraction into the next refresh
+            uint8_t * pPixelError = &pDitherError[SourcePixelId * NumIntensityBytesPerPixel];
+            for (size_t IntensityId = 0; IntensityId < NumIntensityBytesPerPixel; ++IntensityId)
             {
-                // FrameAppendDataCurrentIndex = 0;
-                FrameState = FrameState_t::FrameAppendData;
+                uint8_t & Error     = pPixelError[ColorOffsets.Array[IntensityId]];
+                uint32_t  Intensity = pDitherTable[pSourcePixel[ColorOffsets.Array[IntensityId]]] + Error;
+                Error      = uint8_t (Intensity);
+                *pOutput++ = IntensityType (Intensity >> 8);
             }
-            else
+        }
+        else
+        {
+            for (size_t IntensityId = 0; IntensityId < NumIntensityBytesPerPixel; ++IntensityId)
+            {
+                uint32_t Intensity = gamma_table[pSourcePixel[ColorOffsets.Array[IntensityId]]];
+                *pOutput++ = IntensityType ((Intensity * AdjustedBrightness) >> 8);
+            }
+        }
+
+        // replicate the pixel for the rest of the group
+        for (size_t GroupCount = 1; GroupCount < PixelGroupSize; ++GroupCount)
+        {
+            memcpy (pOutput, pFirstPixel, BytesPerPixel * sizeof (IntensityType));
+            pOutput += BytesPerPixel;
+        }
+    }
+
+    for (size_t NullPixelCount = 0; NullPixelCount < AppendNullPixelCount; ++NullPixelCount)
+    {
+        for (size_t DataId = 0; DataId < PixelPrependDataSize; ++DataId)
+        {
+            *pOutput++ = PixelPrependData[DataId];
+        }
+        for (size_t IntensityId = 0; IntensityId < NumIntensityBytesPerPixel; ++IntensityId)
+        {
+            *pOutput++ = 0;
+        }
+    }
+
+    for (size_t DataId = 0; DataId < FrameAppendDataSize; ++DataId)
+    {
+        *pOutput++ = pFrameAppendData[DataId];
+    }
+
+    if (InvertData)
+    {
+        for (IntensityType * pCurrent = pFrame; pCurrent < pOutput; ++pCurrent)
+        {
+            *pCurrent = ~(*pCurrent);
+        }
+    }
+
+    // DEBUG_END;
+
+    return size_t (pOutput - pFrame);
+
+} // BuildPreparedFrame
+
+#ifdef SUPPORT_OutputType_GECE
+//----------------------------------------------------------------------------
+/*
+    Build the complete 26 bit GECE word for every pixel: address, global
+    brightness and the three colors. The ISR only has to hand the words to
+    the UART / RMT bit translation. Returns the number of words in the frame.
+*/
+size_t c_OutputPixel::BuildGECEFrame (uint32_t * pFrame)
+{
+    // DEBUG_START;
+
+    uint32_t * pOutput = pFrame;
+    uint32_t   Address = 0;
+
+    for (size_t PixelId = 0; PixelId < pixel_count; ++PixelId)
+    {
+        size_t SourcePixelId = PixelId;
+
+        if (nullptr != pPixelMap)
+        {
+            SourcePixelId = pPixelMap[PixelId];
+        }
+        // is this pixel in a backwards zig zag group?
+        else if (zig_size > 1)
+        {
+            size_t ZigZagGroupId = PixelId / zig_size;
+            if (0 != (ZigZagGroupId & 0x1))
             {
+                SourcePixelId = (ZigZagGroupId * zig_size) + (zig_size - 1) - (PixelId % zig_size);
+            }
+        }
+
+        uint8_t * pSourcePixel = &pOutputBuffer[SourcePixelId * NumIntensityBytesPerPixel];
+        uint32_t  Red          = (uint32_t (gamma_table[pSourcePixel[ColorOffsets.Array[0]]]) * AdjustedBrightness) >> 8;
+        uint32_t  Green        = (uint32_t (gamma_table[pSourcePixel[ColorOffsets.Array[1]]]) * AdjustedBrightness) >> 8;
+        uint32_t  Blue         = (uint32_t (gamma_table[pSourcePixel[ColorOffsets.Array[2]]]) * AdjustedBrightness) >> 8;
+        uint32_t  Colors       = GECEBrightness | GECE_SET_RED (Red) | GECE_SET_GREEN (Green) | GECE_SET_BLUE (Blue);
+
+        // every pixel in the group gets its own address
+        for (size_t GroupCount = 0; GroupCount < PixelGroupSize; ++GroupCount)
+        {
+            uint32_t Word = Colors | GECE_SET_ADDRESS (Address++);
+            *pOutput++ = (InvertData) ? ~Word : Word;
+        }
+    }
+
 #ifdef USE_PIXEL_DEBUG_COUNTERS
-                IntensityBytesSentLastFrame = IntensityBytesSent;
+    if (pOutput != pFrame)
+    {
+        LastGECEdataSent = *(pOutput - 1);
+    }
+    NumGECEdataSent += size_t (pOutput - pFrame);
 #endif // def USE_PIXEL_DEBUG_COUNTERS
-                FrameState = FrameState_t::FrameDone;
-            }
 
+    // DEBUG_END;
+
+    return size_t (pOutput - pFrame);
+
+} // BuildGECEFrame
+#endif // def SUPPORT_OutputType_GECE
+
+//----------------------------------------------------------------------------
+/*
+    Split a pixel into a 5 bit global brightness and 8 bit PWM values.
+
+    The gamma curve gives 0 - 65280 (255 * 256) per color. Full scale is a
+    brightness of 31 with a PWM of 255, so a color is sent as
+
+        PWM = Intensity * 31 / (256 * Brightness)
+
+    The smallest brightness that still fits the brightest color in 8 bits
+    leaves the most PWM steps for the dim colors.
+*/
+void c_OutputPixel::EncodeHdrPixel (uint8_t * pSourcePixel, uint8_t * pOutput)
+{
+    uint32_t Intensities[sizeof (ColorOffsets.Array)];
+    uint32_t MaxIntensity = 0;
+
+    for (size_t IntensityId = 0; IntensityId < NumIntensityBytesPerPixel; ++IntensityId)
+    {
+        Intensities[IntensityId] = pHdrGammaTable[pSourcePixel[ColorOffsets.Array[IntensityId]]];
+        MaxIntensity = max (MaxIntensity, Intensities[IntensityId]);
+    }
+
+    uint32_t Brightness = ((MaxIntensity * 31) + 65279) / 65280;
+    Brightness = (0 == Brightness) ? 1 : Brightness;
+    uint32_t Divisor    = Brightness << 8;
+    uint32_t Rounding   = Brightness << 7;
+
+    *pOutput++ = uint8_t (0xE0 | Brightness);
+    for (size_t IntensityId = 0; IntensityId < NumIntensityBytesPerPixel; ++IntensityId)
+    {
+        *pOutput++ = uint8_t (min (uint32_t (255), ((Intensities[IntensityId] * 31) + Rounding) / Divisor));
+    }
+
+} // EncodeHdrPixel
+
+//----------------------------------------------------------------------------
+/*
+    Build the table that translates the order in which pixels are sent into
+    the order in which they are stored in the output buffer. The table is
+    either loaded from a map file or generated from the matrix settings.
+    When present it replaces the zig zag traverse.
+*/
+void c_OutputPixel::UpdatePixelMap ()
+{
+    // DEBUG_START;
+
+    uint16_t * pNewMap = nullptr;
+
+    // the ISR falls back to the generic path until the iterator is reselected
+    pIntensityIterator = nullptr;
+
+    do // once
+    {
+        if (PixelMapFileName.isEmpty () && (0 == PixelMapWidth))
+        {
+            // DEBUG_V ("No pixel map configured");
             break;
         }
 
-        // have we completed the forward traverse
-        if (++ZigPixelCurrentCount < ZigPixelCount)
+        if (pixel_count > (size_t (UINT16_MAX) + 1))
         {
-            // response = 0x0F;
-            // not finished with the set yet.
-            NextPixelToSend += NumIntensityBytesPerPixel;
+            logcon (CN_stars + String (F (" Pixel count is too large for a pixel map. Map disabled ")) + CN_stars);
             break;
         }
 
-        if (0 == ZagPixelCurrentCount)
+        size_t MapSize = pixel_count * sizeof (uint16_t);
+
+        // The ISR reads this table so it must be in internal RAM
+#ifdef ARDUINO_ARCH_ESP32
+        pNewMap = (uint16_t *)heap_caps_malloc (MapSize, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+#else
+        pNewMap = (uint16_t *)malloc (MapSize);
+#endif // def ARDUINO_ARCH_ESP32
+        if (nullptr == pNewMap)
         {
-            // first backward pixel
-            NextPixelToSend += NumIntensityBytesPerPixel * (ZagPixelCount);
+            logcon (String (F ("Could not allocate ")) + String (MapSize) + String (F (" bytes for the pixel map. Map disabled.")));
+            break;
         }
 
-        // have we completed the backward traverse
-        if (++ZagPixelCurrentCount < ZagPixelCount)
+        bool MapIsValid = false;
+
+        if (!PixelMapFileName.isEmpty ())
         {
-            // response = 0xF0;
-            // not finished with the set yet.
-            NextPixelToSend -= NumIntensityBytesPerPixel;
-            break;
+            MapIsValid = LoadPixelMapFile (pNewMap);
+        }
+        else if (0 != (pixel_count % PixelMapWidth))
+        {
+            logcon (CN_stars + String (F (" Pixel count is not a multiple of the map width. Map disabled ")) + CN_stars);
         }
+        else
+        {
+            GeneratePixelMap (pNewMap);
+            MapIsValid = true;
 
-        // response = 0xFF;
+            // a map that does not move anything is just overhead
+            bool MapIsIdentity = true;
+            for (size_t PixelId = 0; PixelId < pixel_count; ++PixelId)
+            {
+                if (pNewMap[PixelId] != PixelId)
+                {
+                    MapIsIdentity = false;
+                    break;
+                }
+            }
+            MapIsValid = !MapIsIdentity;
+        }
 
-        // move to next forward pixel
-        NextPixelToSend += NumIntensityBytesPerPixel * (ZagPixelCount - 1);
+        if (!MapIsValid)
+        {
+            free (pNewMap);
+            pNewMap = nullptr;
+        }
+
+    } while (false);
 
-        // refresh the zigZag
-        ZigPixelCurrentCount = 1;
-        ZagPixelCurrentCount = 0;
+    uint16_t * pOldMap = pPixelMap;
+    if (nullptr != pOldMap)
+    {
+        // the ISR may be walking the old table. Stop it before the table goes away.
+        bool WasPaused = OutputIsPaused;
+        PauseOutput (true);
+        pPixelMap = pNewMap;
+        free (pOldMap);
+        PauseOutput (WasPaused);
+    }
+    else
+    {
+        pPixelMap = pNewMap;
+    }
 
-        break;
+    // DEBUG_END;
 
-#else // !ADJUST_INTENSITY_AT_ISR Adjustments are made at write time
-        response = pOutputBuffer[PixelIntensityCurrentIndex];
+} // UpdatePixelMap
 
-        ++PixelIntensityCurrentIndex;
-        if (PixelIntensityCurrentIndex >= OutputBufferSize)
+//----------------------------------------------------------------------------
+/*
+    The map file is a binary file containing one little endian uint16_t per
+    pixel in output order. Each entry is the pixel position in the buffer.
+    The SD card is checked first and then the local file system.
+*/
+bool c_OutputPixel::LoadPixelMapFile (uint16_t * pMap)
+{
+    // DEBUG_START;
+
+    bool response = false;
+    size_t MapSize = pixel_count * sizeof (uint16_t);
+
+    // unread entries will fail the range check below
+    memset (pMap, 0xFF, MapSize);
+
+    do // once
+    {
+        String FileName = PixelMapFileName;
+        if (!FileName.startsWith ("/"))
         {
-            // response = 0xaa;
-            if (AppendNullPixelCount)
-            {
-                PixelPrependDataCurrentIndex = 0;
-                PixelIntensityCurrentIndex = 0;
-                AppendNullPixelCurrentCount = 0;
+            FileName = String ("/") + FileName;
+        }
 
-                PixelSendState = PixelSendState_t::PixelAppendNulls;
+        c_FileMgr::FileId FileHandle;
+        if (FileMgr.SdCardIsInstalled () && FileMgr.OpenSdFile (FileName, c_FileMgr::FileMode::FileRead, FileHandle))
+        {
+            size_t BytesRead = 0;
+            if (FileMgr.GetSdFileSize (FileHandle) == MapSize)
+            {
+                BytesRead = FileMgr.ReadSdFile (FileHandle, (byte *)pMap, MapSize);
             }
-            else if (FrameAppendDataSize)
+            FileMgr.CloseSdFile (FileHandle);
+
+            if (BytesRead != MapSize)
             {
-                // FrameAppendDataCurrentIndex = 0;
-                FrameState = FrameState_t::FrameAppendData;
+                logcon (CN_stars + String (F (" Pixel map file '")) + PixelMapFileName + F ("' must contain ") + String (MapSize) + F (" bytes ") + CN_stars);
+                break;
             }
-            else
+        }
+        else if (!FileMgr.ReadConfigFile (FileName, (byte *)pMap, MapSize + 1))
+        {
+            break;
+        }
+
+        response = true;
+        for (size_t PixelId = 0; PixelId < pixel_count; ++PixelId)
+        {
+            if (pMap[PixelId] >= pixel_count)
             {
+                logcon (CN_stars + String (F (" Pixel map file '")) + PixelMapFileName + F ("' has an invalid entry at pixel ") + String (PixelId) + " " + CN_stars);
+                response = false;
+                break;
+            }
+        }
+
+    } while (false);
+
+    // DEBUG_END;
+
+    return response;
+
+} // LoadPixelMapFile
+
+//----------------------------------------------------------------------------
+/*
+    The buffer holds the matrix in rows starting at the top left corner. The
+    string starts at the top left (0), top right (90), bottom right (180) or
+    bottom left (270) corner and runs along rows (0, 180) or columns (90, 270).
+    Mirror reverses the direction of every line, serpentine every other line.
+*/
+void c_OutputPixel::GeneratePixelMap (uint16_t * pMap)
+{
+    // DEBUG_START;
+
+    size_t Width      = PixelMapWidth;
+    size_t Height     = pixel_count / PixelMapWidth;
+    bool   Vertical   = (90 == PixelMapRotation) || (270 == PixelMapRotation);
+    size_t LineLength = (Vertical) ? Height : Width;
+
+    for (size_t PixelId = 0; PixelId < pixel_count; ++PixelId)
+    {
+        size_t Line     = PixelId / LineLength;
+        size_t Position = PixelId % LineLength;
+
+        if (PixelMapSerpentine && (Line & 0x1))
+        {
+            Position = (LineLength - 1) - Position;
+        }
+
+        if (PixelMapMirror)
+        {
+            Position = (LineLength - 1) - Position;
+        }
+
+        size_t Column;
+        size_t Row;
+        switch (PixelMapRotation)
+        {
+            case 90:  { Column = (Width - 1) - Line;     Row = Position;                break; }
+            case 180: { Column = (Width - 1) - Position; Row = (Height - 1) - Line;     break; }
+            case 270: { Column = Line;                   Row = (Height - 1) - Position; break; }
+            default:  { Column = Position;               Row = Line;                    break; }
+        }
+
+        pMap[PixelId] = uint16_t ((Row * Width) + Column);
+    }
+
+    // DEBUG_END;
+
+} // GeneratePixelMap
+
+//----------------------------------------------------------------------------
+uint32_t IRAM_ATTR c_OutputPixel::ISR_GetNextIntensityToSend ()
+{
+    uint32_t response = 0x00;
+
 #ifdef USE_PIXEL_DEBUG_COUNTERS
-                IntensityBytesSentLastFrame = IntensityBytesSent;
+    GetNextIntensityToSendCounter++;
+    uint32_t StartCycles = _getCycleCount ();
 #endif // def USE_PIXEL_DEBUG_COUNTERS
 
-                FrameState = FrameState_t::FrameDone;
-            }
-
-            break;
+    if (PreparedFrameLength)
+    {
+        // the frame has already been built. Just stream it out.
+        if (1 == PreparedFrameBytesPerIntensity)
+        {
+            response = uint32_t (pPreparedFrame[PreparedFrameCurrentIndex]);
+        }
+        else if (2 == PreparedFrameBytesPerIntensity)
+        {
+            response = uint32_t (((uint16_t *)pPreparedFrame)[PreparedFrameCurrentIndex]);
+        }
+        else
+        {
+            response = ((uint32_t *)pPreparedFrame)[PreparedFrameCurrentIndex];
         }
-#endif // ! def ADJUST_INTENSITY_AT_WRITE
+        if (++PreparedFrameCurrentIndex >= PreparedFrameLength)
+        {
+            FrameState = FrameState_t::FrameDone;
+        }
+    }
+    else
+    {
+        response = GetNextIteratorIntensity ();
+    }
+
+#ifdef USE_PIXEL_DEBUG_COUNTERS
+    IsrCycles += _getCycleCount () - StartCycles;
+    IsrIntensityCount++;
+#endif // def USE_PIXEL_DEBUG_COUNTERS
 
-    } while (false);
     return response;
-}
+
+} // ISR_GetNextIntensityToSend
 
 //----------------------------------------------------------------------------
 inline size_t c_OutputPixel::CalculateIntensityOffset(size_t ChannelId)
@@ -786,15 +1347,22 @@ inline size_t c_OutputPixel::CalculateIntensityOffset(size_t ChannelId)
 } // CalculateIntensityOffset
 
 //----------------------------------------------------------------------------
-void c_OutputPixel::WriteChannelData(size_t StartChannelId, size_t ChannelCount, byte *pSourceData)
+bool c_OutputPixel::WriteChannelData(size_t StartChannelId, size_t ChannelCount, byte *pSourceData)
 {
     // DEBUG_START;
 
     // DEBUG_V(String("         StartChannelId: 0x") + String(StartChannelId, HEX));
     // DEBUG_V(String("           ChannelCount: 0x") + String(ChannelCount, HEX));
 
+    bool response = true;
+
 #ifdef ADJUST_INTENSITY_AT_ISR
-    memcpy(&pOutputBuffer[StartChannelId], pSourceData, ChannelCount);
+    response = (0 != memcmp(&pBackBuffer[StartChannelId], pSourceData, ChannelCount));
+    if (response)
+    {
+        memcpy(&pBackBuffer[StartChannelId], pSourceData, ChannelCount);
+        MarkDataChanged (StartChannelId, ChannelCount);
+    }
 #else
 
     size_t EndChannelId = StartChannelId + ChannelCount;
@@ -804,13 +1372,16 @@ void c_OutputPixel::WriteChannelData(size_t StartChannelId, size_t ChannelCount,
         size_t CurrentIntensityData = gamma_table[pSourceData[SourceDataIndex]];
         CurrentIntensityData = uint8_t((uint32_t(CurrentIntensityData) * AdjustedBrightness) >> 8);
 
-        pOutputBuffer[CalculateIntensityOffset(currentChannelId)] = CurrentIntensityData;
+        pBackBuffer[CalculateIntensityOffset(currentChannelId)] = CurrentIntensityData;
     }
+    MarkAllDataChanged ();
 
 #endif // def ADJUST_INTENSITY_AT_ISR
 
     // DEBUG_END;
 
+    return response;
+
 } // WriteChannelData
 
 //----------------------------------------------------------------------------
@@ -821,14 +1392,14 @@ void c_OutputPixel::ReadChannelData(size_t StartChannelId, size_t ChannelCount,
     // DEBUG_V(String("         StartChannelId: 0x") + String(StartChannelId, HEX));
     // DEBUG_V(String("           ChannelCount: 0x") + String(ChannelCount, HEX));
 #ifdef ADJUST_INTENSITY_AT_ISR
-    memcpy(pTargetData, &pOutputBuffer[StartChannelId], ChannelCount);
+    memcpy(pTargetData, &pBackBuffer[StartChannelId], ChannelCount);
 #else  // !ADJUST_INTENSITY_AT_ISR
 
     size_t EndChannelId = StartChannelId + ChannelCount;
     size_t SourceDataIndex = 0;
     for (size_t currentChannelId = StartChannelId; currentChannelId < EndChannelId; ++currentChannelId, ++SourceDataIndex)
     {
-        uint8_t CurrentIntensityData = pOutputBuffer[CalculateIntensityOffset(currentChannelId)];
+        uint8_t CurrentIntensityData = pBackBuffer[CalculateIntensityOffset(currentChannelId)];
         // CurrentIntensityData = gamma_table[CurrentIntensityData];
         CurrentIntensityData = uint8_t((uint32_t(CurrentIntensityData << 8) / AdjustedBrightness));
         pTargetData[SourceDataIndex] = CurrentIntensityData;
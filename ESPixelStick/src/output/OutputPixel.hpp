@@ -23,18 +23,10 @@
 */
 
 #include "OutputCommon.hpp"
+#include "OutputPixelIterator.hpp"
 
-class c_OutputPixel : public c_OutputCommon
+class c_OutputPixel : public c_OutputCommon, private c_OutputPixelIterator
 {
-private:
-    enum FrameState_t
-    {
-        FramePrependData,
-        FrameSendPixels,
-        FrameAppendData,
-        FrameDone
-    };
-
 public:
     // These functions are inherited from c_OutputCommon
     c_OutputPixel (c_OutputMgr::e_OutputChannelIds OutputChannelId,
@@ -47,115 +39,91 @@ public:
     virtual  bool         SetConfig (ArduinoJson::JsonObject & jsonConfig); ///< Set a new config in the driver
     virtual  void         GetConfig (ArduinoJson::JsonObject & jsonConfig); ///< Get the current config used by the driver
     virtual  void         GetStatus (ArduinoJson::JsonObject& jsonStatus);
-             size_t       GetNumChannelsNeeded () { return (pixel_count * NumIntensityBytesPerPixel); };
+             size_t       GetNumChannelsNeeded () { return (pixel_count * NumIntensityBytesPerPixel * IntensityInputBytes); };
     virtual  void         SetOutputBufferSize (size_t NumChannelsAvailable);
              void         SetInvertData (bool _InvertData) { InvertData = _InvertData; }
-    virtual  void         WriteChannelData (size_t StartChannelId, size_t ChannelCount, byte *pSourceData);
+    virtual  bool         WriteChannelData (size_t StartChannelId, size_t ChannelCount, byte *pSourceData);
     virtual  void         ReadChannelData (size_t StartChannelId, size_t ChannelCount, byte *pTargetData);
     inline   void         SetIntensityBitTimeInUS (float value) { IntensityBitTimeInUs = value; }
              void         SetIntensityDataWidth(uint32_t value);
              void         StartNewFrame();
-    bool     IRAM_ATTR    ISR_MoreDataToSend () { return FrameState_t::FrameDone != FrameState; }
+    bool     IRAM_ATTR    ISR_MoreDataToSend () { return IteratorHasMoreData (); }
     uint32_t IRAM_ATTR    ISR_GetNextIntensityToSend ();
-    void                  SetPixelCount(size_t value) {pixel_count = value;}
+             void         SetPixelCount(size_t value);
+    virtual  void         PauseOutput (bool State) { OutputIsPaused = State; } ///< Derived drivers must call this before pausing their hardware
+             bool         FrameIsUnchanged () { return (0 == DitherBufferSize) && c_OutputCommon::FrameIsUnchanged (); } ///< A dithered frame changes on every refresh
     size_t                GetPixelCount() {return pixel_count;}
+             size_t       GetPreparedFrameSizeNeeded (); ///< Number of intensity values in one frame including the framing data
 
 protected:
 
     void SetFramePrependInformation (const uint8_t* data, size_t len);
     void SetFrameAppendInformation  (const uint8_t* data, size_t len);
     void SetPixelPrependInformation (const uint8_t* data, size_t len);
+    void SetHdrBrightnessHeader     (bool value) { HdrBrightnessHeader = value; }
 
     uint16_t  InterFrameGapInMicroSec = 300;
 
     void SetFrameDurration (float IntensityBitTimeInUs, uint16_t BlockSize = 1, float BlockDelayUs = 0.0);
 
 private:
-#define PIXEL_DEFAULT_INTENSITY_BYTES_PER_PIXEL 3
-
-    size_t      NumIntensityBytesPerPixel = PIXEL_DEFAULT_INTENSITY_BYTES_PER_PIXEL;
-
-    uint8_t   * NextPixelToSend             = nullptr;
-    size_t      pixel_count                 = 100;
-    size_t      SentPixelsCount             = 0;
-    size_t      PixelIntensityCurrentIndex  = 0;
-
-    uint8_t   * pFramePrependData           = nullptr;
-    size_t      FramePrependDataSize        = 0;
-    size_t      FramePrependDataCurrentIndex = 0;
-
-    uint8_t   * pFrameAppendData            = nullptr;
-    size_t      FrameAppendDataSize         = 0;
-    size_t      FrameAppendDataCurrentIndex = 0;
-
-    uint8_t   * PixelPrependData            = nullptr;
-    size_t      PixelPrependDataSize        = 0;
-    size_t      PixelPrependDataCurrentIndex = 0;
-
-    size_t      PixelGroupSize              = 1;
-    size_t      PixelGroupSizeCurrentCount  = 0;
-
+// Most memory one output may use for the dithering table and error accumulators
+#ifdef ARDUINO_ARCH_ESP8266
+#   define PIXEL_MAX_DITHER_MEMORY                 ((size_t)(4 * 1024))
+#else
+#   define PIXEL_MAX_DITHER_MEMORY                 ((size_t)(16 * 1024))
+#endif // def ARDUINO_ARCH_ESP8266
+
+    bool        OutputIsPaused              = false;
     float       IntensityBitTimeInUs        = 0.0;
     size_t      BlockSize                   = 1;
     float       BlockDelayUs                = 0.0;
 
-    size_t      zig_size                    = 0;
-    size_t      ZigPixelCount               = 1;
-    size_t      ZigPixelCurrentCount        = 1;
-    size_t      ZagPixelCount               = 1;
-    size_t      ZagPixelCurrentCount        = 1;
-
-    size_t      PrependNullPixelCount       = 0;
-    size_t      PrependNullPixelCurrentCount = 0;
+    // output order to buffer order pixel map. Replaces zig zag when present.
+    size_t      PixelMapWidth               = 0;
+    uint16_t    PixelMapRotation            = 0;
+    bool        PixelMapMirror              = false;
+    bool        PixelMapSerpentine          = false;
+    String      PixelMapFileName;
+
+    // outputs that send more than 8 bits per intensity
+    bool        SixteenBitInput             = false;    ///< Config: read two channels (MSB first) per intensity
+    size_t      IntensityInputBytes         = 1;        ///< Channels per intensity actually in use
+
+    // frame prepared in task context at the start of each frame
+    bool        PrepareFrameEnabled         = false;
+    uint8_t   * pPreparedFrame              = nullptr;
+    size_t      PreparedFrameBufferSize     = 0;
+    size_t      PreparedFrameBytesPerIntensity = 1;      ///< 1, 2 or 4 (GECE words)
+    size_t      PreparedFrameLength         = 0;
+    size_t      PreparedFrameCurrentIndex   = 0;
+    uint32_t    PrepareFrameTimeUs          = 0;
+    uint32_t    PrepareFrameMaxTimeUs       = 0;
+
+    // temporal dithering. The gamma table keeps 8 fractional bits and the
+    // remainder of each intensity is carried into the next refresh.
+    bool        DitherEnabled               = false;
+    uint8_t   * pDitherBuffer               = nullptr;
+    size_t      DitherBufferSize            = 0;
+    uint16_t  * pDitherTable                = nullptr;
+    uint8_t   * pDitherError                = nullptr;
+
+    // The one byte pixel header carries a 5 bit global brightness (APA102 / SK9822).
+    // Each pixel is split into the best header / PWM combination from a 16 bit gamma curve.
+    bool        HdrBrightnessHeader         = false;
+    uint16_t  * pHdrGammaTable              = nullptr;
 
-    size_t      AppendNullPixelCount        = 0;
-    size_t      AppendNullPixelCurrentCount = 0;
-
-    bool        InvertData                  = false;
-    uint32_t    IntensityMultiplier         = 1;
-    
-// #define USE_PIXEL_DEBUG_COUNTERS
 #ifdef USE_PIXEL_DEBUG_COUNTERS
-    size_t     PixelsToSend                     = 0;
-    size_t     IntensityBytesSent               = 0;
-    size_t     IntensityBytesSentLastFrame      = 0;
-    uint32_t   FrameStartCounter                = 0;
-    uint32_t   FrameEndCounter                  = 0;
-    size_t     SentPixels                       = 0;
-    uint32_t   AbortFrameCounter                = 0;
-    uint32_t   FramePrependDataCounter          = 0;
-    uint32_t   FrameSendPixelsCounter           = 0;
-    uint32_t   FrameAppendDataCounter           = 0;
-    uint32_t   FrameDoneCounter                 = 0;
-    uint32_t   FrameStateUnknownCounter         = 0;
-    uint32_t   PixelPrependNullsCounter         = 0;
-    uint32_t   PixelSendIntensityCounter        = 0;
-    uint32_t   PixelAppendNullsCounter          = 0;
-    uint32_t   PixelUnkownState                 = 0;
-    uint32_t   GetNextIntensityToSendCounter    = 0;
-    uint32_t   LastGECEdataSent                 = uint32_t(-1);
-    uint32_t   NumGECEdataSent                  = 0;
+    static inline uint32_t _getCycleCount(void)
+    {
+        uint32_t ccount;
+        __asm__ __volatile__("rsr %0,ccount" : "=a"(ccount));
+        return ccount;
+    }
 #endif // def USE_PIXEL_DEBUG_COUNTERS
 
-    typedef union ColorOffsets_s
-    {
-        struct offsets
-        {
-            uint8_t r;
-            uint8_t g;
-            uint8_t b;
-            uint8_t w;
-        } offset;
-        uint8_t Array[4];
-    } ColorOffsets_t;
-    ColorOffsets_t  ColorOffsets;
-
-    uint8_t     gamma_table[256]    = { 0 };    ///< Gamma Adjustment table
     float       gamma               = 1.0;      ///< gamma value to use
     uint8_t     brightness          = 100;
-    uint32_t    AdjustedBrightness  = 256;
-    uint32_t    GECEPixelId         = 0;
-    uint32_t    GECEBrightness      = 255;
 
     // JSON configuration parameters
     String      color_order = "rgb"; ///< Pixel color order
@@ -166,17 +134,18 @@ private:
     void updateColorOrderOffsets(); ///< Update color order
     bool validate ();        ///< confirm that the current configuration is valid
     inline size_t CalculateIntensityOffset(size_t ChannelId);
-    uint32_t IRAM_ATTR GetIntensityData();
-
-    enum PixelSendState_t
-    {
-        PixelPrependNulls,
-        PixelSendIntensity,
-        PixelAppendNulls,
-    };
-
-    FrameState_t FrameState = FrameState_t::FrameDone;
-    PixelSendState_t PixelSendState = PixelSendState_t::PixelSendIntensity;
+    void     UpdatePreparedFrameBuffer ();
+    void     PrepareFrame ();
+    template <typename IntensityType>
+    size_t   BuildPreparedFrame (IntensityType * pFrame);
+#ifdef SUPPORT_OutputType_GECE
+    size_t   BuildGECEFrame (uint32_t * pFrame);
+#endif // def SUPPORT_OutputType_GECE
+    void     EncodeHdrPixel (uint8_t * pSourcePixel, uint8_t * pOutput);
+    void     UpdateDitherBuffer ();
+    void     UpdatePixelMap ();
+    bool     LoadPixelMapFile (uint16_t * pMap);
+    void     GeneratePixelMap (uint16_t * pMap);
 
 }; // c_OutputPixel
 
@@ -0,0 +1,717 @@
+#pragma once
+/*
+* OutputPixelIterator.hpp - Pixel intensity iterators used by the output ISRs
+*
+* Project: ESPixelStick - An ESP8266 / ESP32 and E1.31 based pixel driver
+* Copyright (c) 2015, 2022 Shelby Merrick
+* http://www.forkineye.com
+*
+*  This program is provided free for you to use in any way that you wish,
+*  subject to the laws and regulations where you are using it.  Due diligence
+*  is strongly suggested before using this code.  Please give credit where due.
+*
+*  The Author makes no warranty of any kind, express or implied, with regard
+*  to this program or the documentation contained in this document.  The
+*  Author shall not be liable in any event for incidental or consequential
+*  damages in connection with, or arising out of, the furnishing, performance
+*  or use of these programs.
+*
+*   Walks the output buffer one intensity at a time in wire order: frame and
+*   pixel framing data, null pixels, grouping, zig zag / pixel map, color
+*   order, gamma and brightness. c_OutputPixel owns the configuration and
+*   calls these from the output ISRs.
+*
+*/
+
+#include <stdint.h>
+#include <stddef.h>
+#include "OutputGECEFrame.hpp"
+
+// On the target this file is included after Arduino.h has defined IRAM_ATTR
+#ifndef IRAM_ATTR
+#   define IRAM_ATTR
+#endif // ndef IRAM_ATTR
+
+#define ADJUST_INTENSITY_AT_ISR
+#define PIXEL_DEFAULT_INTENSITY_BYTES_PER_PIXEL 3
+
+// #define USE_PIXEL_DEBUG_COUNTERS
+
+class c_OutputPixelIterator
+{
+protected:
+    enum FrameState_t
+    {
+        FramePrependData,
+        FrameSendPixels,
+        FrameAppendData,
+        FrameDone
+    };
+
+    enum PixelSendState_t
+    {
+        PixelPrependNulls,
+        PixelSendIntensity,
+        PixelAppendNulls,
+    };
+
+    inline   void         StartIterator (uint8_t * pData, size_t DataSize); ///< Rewind to the first intensity of a new frame
+             void         SelectIntensityIterator ();                      ///< Call after any of the config below changes
+    inline   uint32_t     IRAM_ATTR GetNextIteratorIntensity ();
+    inline   bool         IRAM_ATTR IteratorHasMoreData () { return FrameState_t::FrameDone != FrameState; }
+
+    uint8_t   * pPixelData                  = nullptr;  ///< First byte of the pixel data for this frame
+    size_t      PixelDataSize               = 0;
+
+    size_t      NumIntensityBytesPerPixel   = PIXEL_DEFAULT_INTENSITY_BYTES_PER_PIXEL;
+
+    uint8_t   * NextPixelToSend             = nullptr;
+    size_t      pixel_count                 = 100;
+    size_t      SentPixelsCount             = 0;
+    size_t      PixelIntensityCurrentIndex  = 0;
+
+    uint8_t   * pFramePrependData           = nullptr;
+    size_t      FramePrependDataSize        = 0;
+    size_t      FramePrependDataCurrentIndex = 0;
+
+    uint8_t   * pFrameAppendData            = nullptr;
+    size_t      FrameAppendDataSize         = 0;
+    size_t      FrameAppendDataCurrentIndex = 0;
+
+    uint8_t   * PixelPrependData            = nullptr;
+    size_t      PixelPrependDataSize        = 0;
+    size_t      PixelPrependDataCurrentIndex = 0;
+
+    size_t      PixelGroupSize              = 1;
+    size_t      PixelGroupSizeCurrentCount  = 0;
+
+    size_t      zig_size                    = 0;
+    size_t      ZigPixelCount               = 1;
+    size_t      ZigPixelCurrentCount        = 1;
+    size_t      ZagPixelCount               = 1;
+    size_t      ZagPixelCurrentCount        = 1;
+
+    // output order to buffer order pixel map. Replaces zig zag when present.
+    uint16_t  * pPixelMap                   = nullptr;
+
+    size_t      PrependNullPixelCount       = 0;
+    size_t      PrependNullPixelCurrentCount = 0;
+
+    size_t      AppendNullPixelCount        = 0;
+    size_t      AppendNullPixelCurrentCount = 0;
+
+    bool        InvertData                  = false;
+    uint32_t    IntensityMultiplier         = 1;
+
+    // outputs that send more than 8 bits per intensity
+    uint16_t  * pWideGammaTable             = nullptr;  ///< 257 entries. The last one is used to interpolate 16 bit input
+
+    // fast path iterator used when the frame has no extra framing
+    typedef uint32_t (c_OutputPixelIterator::*IntensityIterator_t)();
+    IntensityIterator_t pIntensityIterator  = nullptr;
+    int32_t     FastPixelStep               = PIXEL_DEFAULT_INTENSITY_BYTES_PER_PIXEL;
+    size_t      FastZigPixelCurrentCount    = 0;
+    size_t      FastZigJump                 = 0;
+
+#ifdef USE_PIXEL_DEBUG_COUNTERS
+    size_t     PixelsToSend                     = 0;
+    size_t     IntensityBytesSent               = 0;
+    size_t     IntensityBytesSentLastFrame      = 0;
+    uint32_t   FrameStartCounter                = 0;
+    uint32_t   FrameEndCounter                  = 0;
+    size_t     SentPixels                       = 0;
+    uint32_t   AbortFrameCounter                = 0;
+    uint32_t   FramePrependDataCounter          = 0;
+    uint32_t   FrameSendPixelsCounter           = 0;
+    uint32_t   FrameAppendDataCounter           = 0;
+    uint32_t   FrameDoneCounter                 = 0;
+    uint32_t   FrameStateUnknownCounter         = 0;
+    uint32_t   PixelPrependNullsCounter         = 0;
+    uint32_t   PixelSendIntensityCounter        = 0;
+    uint32_t   PixelAppendNullsCounter          = 0;
+    uint32_t   PixelUnkownState                 = 0;
+    uint32_t   GetNextIntensityToSendCounter    = 0;
+    uint32_t   LastGECEdataSent                 = uint32_t(-1);
+    uint32_t   NumGECEdataSent                  = 0;
+    uint32_t   IsrCycles                        = 0;
+    uint32_t   IsrIntensityCount                = 0;
+#endif // def USE_PIXEL_DEBUG_COUNTERS
+
+    typedef union ColorOffsets_s
+    {
+        struct offsets
+        {
+            uint8_t r;
+            uint8_t g;
+            uint8_t b;
+            uint8_t w;
+        } offset;
+        uint8_t Array[4];
+    } ColorOffsets_t;
+    ColorOffsets_t  ColorOffsets;
+
+    uint8_t     gamma_table[256]    = { 0 };    ///< Gamma Adjustment table
+    uint32_t    AdjustedBrightness  = 256;
+    bool        SendGECEWords       = false;    ///< Each pixel is sent as one GECE word
+    uint32_t    GECEPixelId         = 0;
+    uint32_t    GECEBrightness      = 255;
+
+    FrameState_t FrameState = FrameState_t::FrameDone;
+    PixelSendState_t PixelSendState = PixelSendState_t::PixelSendIntensity;
+
+    uint32_t IRAM_ATTR GetIntensityData();
+    uint32_t IRAM_ATTR ISR_GetNextIntensityGeneric ();
+
+    template <size_t NumBytesPerPixel, bool ZigZag, bool Grouped, bool Mapped>
+    uint32_t IRAM_ATTR ISR_GetNextIntensityFast ();
+
+}; // c_OutputPixelIterator
+
+//----------------------------------------------------------------------------
+inline void c_OutputPixelIterator::StartIterator (uint8_t * pData, size_t DataSize)
+{
+    pPixelData    = pData;
+    PixelDataSize = DataSize;
+
+    NextPixelToSend = pPixelData;
+    if (nullptr != pPixelMap)
+    {
+        NextPixelToSend += pPixelMap[0] * NumIntensityBytesPerPixel;
+    }
+    FramePrependDataCurrentIndex    = 0;
+    FrameAppendDataCurrentIndex     = 0;
+    ZigPixelCurrentCount            = 1;
+    ZagPixelCurrentCount            = 0;
+    SentPixelsCount                 = 0;
+    PixelIntensityCurrentIndex      = 0;
+    PixelGroupSizeCurrentCount      = 0;
+    PrependNullPixelCurrentCount    = 0;
+    AppendNullPixelCurrentCount     = 0;
+    PixelPrependDataCurrentIndex    = 0;
+    GECEPixelId                     = 0;
+    FastPixelStep                   = int32_t(NumIntensityBytesPerPixel);
+    FastZigPixelCurrentCount        = 0;
+
+    FrameState     = (FramePrependDataSize)  ? FrameState_t::FramePrependData : FrameState_t::FrameSendPixels;
+    PixelSendState = (PrependNullPixelCount) ? PixelSendState_t::PixelPrependNulls : PixelSendState_t::PixelSendIntensity;
+
+#ifdef USE_PIXEL_DEBUG_COUNTERS
+    SentPixels         = SentPixelsCount;
+    PixelsToSend       = pixel_count;
+    IntensityBytesSent = 0;
+#endif // def USE_PIXEL_DEBUG_COUNTERS
+
+} // StartIterator
+
+//----------------------------------------------------------------------------
+inline uint32_t IRAM_ATTR c_OutputPixelIterator::GetNextIteratorIntensity ()
+{
+    if (nullptr != pIntensityIterator)
+    {
+        return (this->*pIntensityIterator)();
+    }
+
+    return ISR_GetNextIntensityGeneric ();
+
+} // GetNextIteratorIntensity
+
+//----------------------------------------------------------------------------
+/*
+    Pick the ISR iterator that matches the current configuration. Anything
+    that needs framing data, null pixels, more than 8 bits per intensity or
+    inverted data uses the generic state machine.
+*/
+inline void c_OutputPixelIterator::SelectIntensityIterator ()
+{
+    // DEBUG_START;
+
+    IntensityIterator_t NewIterator = nullptr;
+
+    do // once
+    {
+#ifndef ADJUST_INTENSITY_AT_ISR
+        break;
+#endif // ndef ADJUST_INTENSITY_AT_ISR
+
+        if (FramePrependDataSize || FrameAppendDataSize || PixelPrependDataSize ||
+            PrependNullPixelCount || AppendNullPixelCount ||
+            InvertData || (1 != IntensityMultiplier))
+        {
+            break;
+        }
+
+#ifdef SUPPORT_OutputType_GECE
+        if (SendGECEWords)
+        {
+            break;
+        }
+#endif // def SUPPORT_OutputType_GECE
+
+        bool Mapped  = (nullptr != pPixelMap);
+        bool ZigZag  = (zig_size > 1) && !Mapped;
+        bool Grouped = (PixelGroupSize > 1);
+
+        if (3 == NumIntensityBytesPerPixel)
+        {
+            if (Mapped)
+            {
+                NewIterator = (Grouped) ? &c_OutputPixelIterator::ISR_GetNextIntensityFast<3, false, true,  true>
+                                        : &c_OutputPixelIterator::ISR_GetNextIntensityFast<3, false, false, true>;
+            }
+            else if (ZigZag)
+            {
+                NewIterator = (Grouped) ? &c_OutputPixelIterator::ISR_GetNextIntensityFast<3, true,  true,  false>
+                                        : &c_OutputPixelIterator::ISR_GetNextIntensityFast<3, true,  false, false>;
+            }
+            else
+            {
+                NewIterator = (Grouped) ? &c_OutputPixelIterator::ISR_GetNextIntensityFast<3, false, true,  false>
+                                        : &c_OutputPixelIterator::ISR_GetNextIntensityFast<3, false, false, false>;
+            }
+        }
+        else if (4 == NumIntensityBytesPerPixel)
+        {
+            if (Mapped)
+            {
+                NewIterator = (Grouped) ? &c_OutputPixelIterator::ISR_GetNextIntensityFast<4, false, true,  true>
+                                        : &c_OutputPixelIterator::ISR_GetNextIntensityFast<4, false, false, true>;
+            }
+            else if (ZigZag)
+            {
+                NewIterator = (Grouped) ? &c_OutputPixelIterator::ISR_GetNextIntensityFast<4, true,  true,  false>
+                                        : &c_OutputPixelIterator::ISR_GetNextIntensityFast<4, true,  false, false>;
+            }
+            else
+            {
+                NewIterator = (Grouped) ? &c_OutputPixelIterator::ISR_GetNextIntensityFast<4, false, true,  false>
+                                        : &c_OutputPixelIterator::ISR_GetNextIntensityFast<4, false, false, false>;
+            }
+        }
+
+    } while (false);
+
+    FastZigJump        = zig_size * NumIntensityBytesPerPixel;
+    pIntensityIterator = NewIterator;
+
+#ifdef USE_PIXEL_DEBUG_COUNTERS
+    IsrCycles         = 0;
+    IsrIntensityCount = 0;
+#endif // def USE_PIXEL_DEBUG_COUNTERS
+
+    // DEBUG_END;
+
+} // SelectIntensityIterator
+
+//----------------------------------------------------------------------------
+/*
+    Fast path used when there is no frame / pixel framing data, no null
+    pixels and the data is sent as 8 bit intensities. The template
+    parameters remove the checks that do not apply to the current config.
+*/
+template <size_t NumBytesPerPixel, bool ZigZag, bool Grouped, bool Mapped>
+uint32_t IRAM_ATTR c_OutputPixelIterator::ISR_GetNextIntensityFast ()
+{
+    uint32_t response = gamma_table[NextPixelToSend[ColorOffsets.Array[PixelIntensityCurrentIndex]]];
+    response = (response * AdjustedBrightness) >> 8;
+
+    do // once
+    {
+        if (++PixelIntensityCurrentIndex < NumBytesPerPixel)
+        {
+            break;
+        }
+        PixelIntensityCurrentIndex = 0;
+
+        if (Grouped)
+        {
+            if (++PixelGroupSizeCurrentCount < PixelGroupSize)
+            {
+                break;
+            }
+            PixelGroupSizeCurrentCount = 0;
+        }
+
+        if (++SentPixelsCount >= pixel_count)
+        {
+            FrameState = FrameState_t::FrameDone;
+            break;
+        }
+
+        if (Mapped)
+        {
+            NextPixelToSend = pPixelData + (pPixelMap[SentPixelsCount] * NumBytesPerPixel);
+            break;
+        }
+
+        if (ZigZag)
+        {
+            if (++FastZigPixelCurrentCount < zig_size)
+            {
+                NextPixelToSend += FastPixelStep;
+                break;
+            }
+
+            // jump to the far end of the next group and reverse direction
+            FastZigPixelCurrentCount = 0;
+            NextPixelToSend += FastZigJump;
+            FastPixelStep = -FastPixelStep;
+            break;
+        }
+
+        NextPixelToSend += NumBytesPerPixel;
+
+    } while (false);
+
+    return response;
+
+} // ISR_GetNextIntensityFast
+
+//----------------------------------------------------------------------------
+inline uint32_t IRAM_ATTR c_OutputPixelIterator::ISR_GetNextIntensityGeneric ()
+{
+    uint32_t response = 0x00;
+
+    switch (FrameState)
+    {
+        case FrameState_t::FramePrependData:
+        {
+#ifdef USE_PIXEL_DEBUG_COUNTERS
+            FramePrependDataCounter++;
+#endif // def USE_PIXEL_DEBUG_COUNTERS
+
+            response = pFramePrependData[FramePrependDataCurrentIndex];
+            if (++FramePrependDataCurrentIndex < FramePrependDataSize)
+            {
+                break;
+            }
+
+            // FramePrependDataCurrentIndex = 0;
+            FrameState = FrameState_t::FrameSendPixels;
+            // PixelIntensityCurrentIndex = 0;
+            // PixelPrependDataCurrentIndex = 0;
+            break;
+        } // case FrameState_t::FramePrependData
+
+        case FrameState_t::FrameSendPixels:
+        {
+#ifdef USE_PIXEL_DEBUG_COUNTERS
+            FrameSendPixelsCounter++;
+#endif // def USE_PIXEL_DEBUG_COUNTERS
+
+            switch (PixelSendState)
+            {
+                default:
+                {
+#ifdef USE_PIXEL_DEBUG_COUNTERS
+                    PixelUnkownState++;
+                    break;
+#endif // def USE_PIXEL_DEBUG_COUNTERS
+                }
+                
+                case PixelSendState_t::PixelPrependNulls:
+                {
+#ifdef USE_PIXEL_DEBUG_COUNTERS
+                    PixelPrependNullsCounter++;
+#endif // def USE_PIXEL_DEBUG_COUNTERS
+                    if (PixelPrependDataCurrentIndex < PixelPrependDataSize)
+                    {
+                        response = PixelPrependData[PixelPrependDataCurrentIndex++] * IntensityMultiplier;
+                        break;
+                    }
+
+                    // response = 0x00;
+
+                    // has the pixel completed?
+                    if (++PixelIntensityCurrentIndex < NumIntensityBytesPerPixel)
+                    {
+                        break;
+                    }
+
+                    // pixel is complete. Move to the next one
+                    PixelIntensityCurrentIndex = 0;
+                    PixelPrependDataCurrentIndex = 0;
+
+                    if (++PrependNullPixelCurrentCount < PrependNullPixelCount)
+                    {
+                        break;
+                    }
+
+                    // no more null pixels to send
+                    // PrependNullPixelCurrentCount = 0;
+                    PixelSendState = PixelSendState_t::PixelSendIntensity;
+                    break;
+                } // case PixelSendState_t::PixelPrependNulls:
+
+                case PixelSendState_t::PixelSendIntensity:
+                {
+#ifdef USE_PIXEL_DEBUG_COUNTERS
+                    PixelSendIntensityCounter++;
+                    IntensityBytesSent++;
+#endif // def USE_PIXEL_DEBUG_COUNTERS
+
+                    // pixel prepend goes here
+                    if (PixelPrependDataCurrentIndex < PixelPrependDataSize)
+                    {
+                        response = PixelPrependData[PixelPrependDataCurrentIndex++];
+                        break;
+                    }
+#ifdef SUPPORT_OutputType_GECE
+                    if (SendGECEWords)
+                    {
+                        // build a GECE intensity frame
+                        response = GECEBrightness;
+                        response |= GECE_SET_ADDRESS(GECEPixelId++);
+                        response |= GECE_SET_RED(GetIntensityData());
+                        response |= GECE_SET_GREEN(GetIntensityData());
+                        response |= GECE_SET_BLUE(GetIntensityData());
+#ifdef USE_PIXEL_DEBUG_COUNTERS
+                        LastGECEdataSent = response;
+                        NumGECEdataSent++;
+#endif // def USE_PIXEL_DEBUG_COUNTERS
+                    }
+                    else
+#endif // def SUPPORT_OutputType_GECE
+                    {
+                        response = GetIntensityData();
+                    }
+                    break;
+                } // case PixelSendState_t::PixelSendIntensity:
+
+                case PixelSendState_t::PixelAppendNulls:
+                {
+#ifdef USE_PIXEL_DEBUG_COUNTERS
+                    PixelAppendNullsCounter++;
+#endif // def USE_PIXEL_DEBUG_COUNTERS
+       // pixel prepend goes here
+                    if (PixelPrependDataCurrentIndex < PixelPrependDataSize)
+                    {
+                        response = PixelPrependData[PixelPrependDataCurrentIndex++];
+                        break;
+                    }
+
+                    // response = 0x00;
+
+                    // has the pixel completed?
+                    if (++PixelIntensityCurrentIndex < NumIntensityBytesPerPixel)
+                    {
+                        break;
+                    }
+
+                    // pixel is complete. Move to the next one
+                    PixelIntensityCurrentIndex = 0;
+                    PixelPrependDataCurrentIndex = 0;
+
+                    if (++AppendNullPixelCurrentCount < AppendNullPixelCount)
+                    {
+                        break;
+                    }
+                    // AppendNullPixelCurrentCount = 0;
+
+                    if (FrameAppendDataSize)
+                    {
+                        // FrameAppendDataCurrentCount = 0;
+                        FrameState = FrameState_t::FrameAppendData;
+                        break;
+                    }
+
+                    FrameState = FrameState_t::FrameDone;
+
+                    break;
+                } // case PixelSendState_t::PixelAppendNulls:
+
+            } // switch SendPixelsState
+            break;
+        } // case FrameState_t::FrameSendPixels
+
+        case FrameState_t::FrameAppendData:
+        {
+#ifdef USE_PIXEL_DEBUG_COUNTERS
+            FrameAppendDataCounter++;
+#endif // def USE_PIXEL_DEBUG_COUNTERS
+            response = pFrameAppendData[FrameAppendDataCurrentIndex];
+            if (++FrameAppendDataCurrentIndex < FrameAppendDataSize)
+            {
+                break;
+            }
+            // FrameAppendDataCurrentIndex = 0;
+            FrameState = FrameState_t::FrameDone;
+            break;
+        } // case FrameState_t::FrameAppendData
+
+        case FrameState_t::FrameDone:
+        {
+#ifdef USE_PIXEL_DEBUG_COUNTERS
+            FrameDoneCounter++;
+            response = 0x55;
+#endif // def USE_PIXEL_DEBUG_COUNTERS
+            break;
+        } // case FrameState_t::FrameDone
+
+        default:
+        {
+#ifdef USE_PIXEL_DEBUG_COUNTERS
+            FrameStateUnknownCounter++;
+#endif // def USE_PIXEL_DEBUG_COUNTERS
+        }
+        } // switch FrameState
+
+        if (InvertData)
+        {
+            response = ~response;
+        }
+
+        return response;
+
+} // ISR_GetNextIntensityGeneric
+
+//----------------------------------------------------------------------------
+inline uint32_t IRAM_ATTR c_OutputPixelIterator::GetIntensityData()
+{
+    uint32_t response = 0;
+
+    do // once
+    {
+#ifdef ADJUST_INTENSITY_AT_ISR
+        response = (NextPixelToSend[ColorOffsets.Array[PixelIntensityCurrentIndex]]);
+        if (nullptr != pWideGammaTable)
+        {
+            response = pWideGammaTable[response];
+        }
+        else
+        {
+            response = gamma_table[response];
+            response = uint8_t((uint32_t(response) * AdjustedBrightness) >> 8);
+        }
+
+        // has the pixel completed?
+        ++PixelIntensityCurrentIndex;
+        if (PixelIntensityCurrentIndex < NumIntensityBytesPerPixel)
+        {
+            // response = 0xF0;
+            break;
+        }
+        // response = 0xFF;
+
+        PixelIntensityCurrentIndex = 0;
+        PixelPrependDataCurrentIndex = 0;
+
+        // has the group completed?
+        if (++PixelGroupSizeCurrentCount < PixelGroupSize)
+        {
+            // not finished with the group yet
+            break;
+        }
+
+        // refresh the group count
+        PixelGroupSizeCurrentCount = 0;
+
+        ++SentPixelsCount;
+        if (SentPixelsCount >= pixel_count)
+        {
+#ifdef USE_PIXEL_DEBUG_COUNTERS
+            FrameEndCounter++;
+#endif // def USE_PIXEL_DEBUG_COUNTERS
+
+            // response = 0xaa;
+            if (AppendNullPixelCount)
+            {
+                PixelPrependDataCurrentIndex = 0;
+                PixelIntensityCurrentIndex = 0;
+                AppendNullPixelCurrentCount = 0;
+
+                PixelSendState = PixelSendState_t::PixelAppendNulls;
+            }
+            else if (FrameAppendDataSize)
+            {
+                // FrameAppendDataCurrentIndex = 0;
+                FrameState = FrameState_t::FrameAppendData;
+            }
+            else
+            {
+#ifdef USE_PIXEL_DEBUG_COUNTERS
+                IntensityBytesSentLastFrame = IntensityBytesSent;
+#endif // def USE_PIXEL_DEBUG_COUNTERS
+                FrameState = FrameState_t::FrameDone;
+            }
+
+            break;
+        }
+
+        // the map replaces the zig zag traverse
+        if (nullptr != pPixelMap)
+        {
+            NextPixelToSend = pPixelData + (pPixelMap[SentPixelsCount] * NumIntensityBytesPerPixel);
+            break;
+        }
+
+        // have we completed the forward traverse
+        if (++ZigPixelCurrentCount < ZigPixelCount)
+        {
+            // response = 0x0F;
+            // not finished with the set yet.
+            NextPixelToSend += NumIntensityBytesPerPixel;
+            break;
+        }
+
+        if (0 == ZagPixelCurrentCount)
+        {
+            // first backward pixel
+            NextPixelToSend += NumIntensityBytesPerPixel * (ZagPixelCount);
+        }
+
+        // have we completed the backward traverse
+        if (++ZagPixelCurrentCount < ZagPixelCount)
+        {
+            // response = 0xF0;
+            // not finished with the set yet.
+            NextPixelToSend -= NumIntensityBytesPerPixel;
+            break;
+        }
+
+        // response = 0xFF;
+
+        // move to next forward pixel
+        NextPixelToSend += NumIntensityBytesPerPixel * (ZagPixelCount - 1);
+
+        // refresh the zigZag
+        ZigPixelCurrentCount = 1;
+        ZagPixelCurrentCount = 0;
+
+        break;
+
+#else // !ADJUST_INTENSITY_AT_ISR Adjustments are made at write time
+        response = pPixelData[PixelIntensityCurrentIndex];
+
+        ++PixelIntensityCurrentIndex;
+        if (PixelIntensityCurrentIndex >= PixelDataSize)
+        {
+            // response = 0xaa;
+            if (AppendNullPixelCount)
+            {
+                PixelPrependDataCurrentIndex = 0;
+                PixelIntensityCurrentIndex = 0;
+                AppendNullPixelCurrentCount = 0;
+
+                PixelSendState = PixelSendState_t::PixelAppendNulls;
+            }
+            else if (FrameAppendDataSize)
+            {
+                // FrameAppendDataCurrentIndex = 0;
+                FrameState = FrameState_t::FrameAppendData;
+            }
+            else
+            {
+#ifdef USE_PIXEL_DEBUG_COUNTERS
+                IntensityBytesSentLastFrame = IntensityBytesSent;
+#endif // def USE_PIXEL_DEBUG_COUNTERS
+
+                FrameState = FrameState_t::FrameDone;
+            }
+
+            break;
+        }
+#endif // ! def ADJUST_INTENSITY_AT_WRITE
+
+    } while (false);
+    return response;
+}
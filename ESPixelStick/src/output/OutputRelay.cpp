@@ -32,6 +32,12 @@ GNU General Public License for more details.
 #include "OutputRelay.hpp"
 #include "OutputCommon.hpp"
 
+#if defined(ARDUINO_ARCH_ESP32)
+#   include <driver/ledc.h>
+#   include <soc/soc.h>
+#   include <soc/gpio_struct.h>
+#endif // defined(ARDUINO_ARCH_ESP32)
+
 #define Relay_OUTPUT_ENABLED         true
 #define Relay_OUTPUT_DISABLED        false
 #define Relay_OUTPUT_INVERTED        true
@@ -40,8 +46,6 @@ GNU General Public License for more details.
 #define Relay_OUTPUT_NOT_PWM         false
 #define Relay_DEFAULT_TRIGGER_LEVEL  128
 #define Relay_DEFAULT_GPIO_ID        ((gpio_num_t)0)
-#define RelayPwmHigh                 255
-#define RelayPwmLow                  0
 
 #if defined(ARDUINO_ARCH_ESP32)
 #   define RelayPwmFrequency         , 12000
@@ -49,6 +53,11 @@ GNU General Public License for more details.
 #   define RelayPwmFrequency
 #endif // defined(ARDUINO_ARCH_ESP32)
 
+#if defined(ARDUINO_ARCH_ESP32)
+// The fade service is shared by every LEDC channel
+static bool LedcFadeServiceInstalled = false;
+#endif // defined(ARDUINO_ARCH_ESP32)
+
 static const c_OutputRelay::RelayChannel_t RelayChannelDefaultSettings[] =
 {
     {Relay_OUTPUT_DISABLED, Relay_OUTPUT_INVERTED, Relay_OUTPUT_NOT_PWM, Relay_DEFAULT_TRIGGER_LEVEL, Relay_DEFAULT_GPIO_ID, LOW, HIGH, HIGH RelayPwmFrequency},
@@ -146,46 +155,107 @@ bool c_OutputRelay::validate ()
         response = false;
     }
 
+    if ((PwmBits < OM_RELAY_PWM_BITS_MIN) || (PwmBits > OM_RELAY_PWM_BITS_MAX))
+    {
+        logcon (CN_stars + String (F (" Requested PWM resolution was not valid. Setting to ")) + OM_RELAY_PWM_BITS_DEFAULT + F (" bits ") + CN_stars);
+        PwmBits = OM_RELAY_PWM_BITS_DEFAULT;
+        response = false;
+    }
+
+    if (Gamma <= 0.0)
+    {
+        logcon (CN_stars + String (F (" Requested gamma was not valid. Setting to 1.0 ")) + CN_stars);
+        Gamma = 1.0;
+        response = false;
+    }
+
+#if defined(ARDUINO_ARCH_ESP32)
+    FadeTimeMs = min (FadeTimeMs, uint16_t (OM_RELAY_FADE_TIME_MAX_MS));
+    if ((0 != FadeTimeMs) && !LedcFadeServiceInstalled)
+    {
+        LedcFadeServiceInstalled = (ESP_OK == ledc_fade_func_install (0));
+        if (!LedcFadeServiceInstalled)
+        {
+            logcon (CN_stars + String (F (" Could not start the LEDC fade service. PWM outputs will not fade ")) + CN_stars);
+            FadeTimeMs = 0;
+        }
+    }
+
+    // LEDC channels 2n and 2n+1 run from the same timer. The lower channel sets the frequency for both.
+    for (uint8_t FirstChannel = 0; FirstChannel < OM_RELAY_CHANNEL_LIMIT; FirstChannel += OM_RELAY_CHANNELS_PER_LEDC_TIMER)
+    {
+        RelayChannel_t & TimerOwner = OutputList[FirstChannel];
+        RelayChannel_t & TimerUser  = OutputList[FirstChannel + 1];
+
+        if (!TimerOwner.Enabled || !TimerOwner.Pwm || !TimerUser.Enabled || !TimerUser.Pwm)
+        {
+            continue;
+        }
+
+        if (TimerOwner.PwmFrequency != TimerUser.PwmFrequency)
+        {
+            logcon (CN_stars + String (F (" Relay channels ")) + String (FirstChannel + 1) + F (" and ") + String (FirstChannel + 2) + F (" share a PWM timer. Setting channel ") + String (FirstChannel + 2) + F (" to ") + String (TimerOwner.PwmFrequency) + F (" Hz ") + CN_stars);
+            TimerUser.PwmFrequency = TimerOwner.PwmFrequency;
+            response = false;
+        }
+    }
+#else
+    // One PWM range is shared by every pin
+    analogWriteRange ((uint32_t (1) << PwmBits) - 1);
+#endif // defined(ARDUINO_ARCH_ESP32)
+
+    updateDutyTable ();
+
     SetOutputBufferSize (Num_Channels);
     uint8_t Channel = 0;
     for (RelayChannel_t & currentRelay : OutputList)
     {
+        currentRelay.PwmBits = PwmBits;
+
         if (currentRelay.Enabled)
         {
             #if defined(ARDUINO_ARCH_ESP32)
-               // assign GPIO to a channel and set the pwm 12 Khz frequency, 8 bit
-               ledcAttachPin(currentRelay.GpioId, Channel);
-               ledcSetup(Channel, currentRelay.PwmFrequency, 8);
+               if (currentRelay.Pwm)
+               {
+                   currentRelay.PwmFrequency = max (currentRelay.PwmFrequency, uint16_t (1));
+
+                   // The timer runs from the 80 Mhz APB clock. Drop bits until one PWM period holds a full count.
+                   while ((currentRelay.PwmBits > OM_RELAY_PWM_BITS_MIN) && ((APB_CLK_FREQ / currentRelay.PwmFrequency) < (uint32_t (1) << currentRelay.PwmBits)))
+                   {
+                       --currentRelay.PwmBits;
+                   }
+
+                   if (currentRelay.PwmBits != PwmBits)
+                   {
+                       logcon (String (F ("Relay channel ")) + String (Channel + 1) + F (" is limited to ") + String (currentRelay.PwmBits) + F (" bits at ") + String (currentRelay.PwmFrequency) + F (" Hz"));
+                   }
+
+                   // assign GPIO to a channel and set the pwm frequency and resolution
+                   ledcSetup (Channel, currentRelay.PwmFrequency, currentRelay.PwmBits);
+                   ledcAttachPin (currentRelay.GpioId, Channel);
+                   currentRelay.FadeActive = false;
+                   currentRelay.FadePending = false;
+               }
+               else
+               {
+                   // switched by the GPIO set / clear registers
+                   ledcDetachPin (currentRelay.GpioId);
+                   pinMode (currentRelay.GpioId, OUTPUT);
+               }
             #else
                pinMode (currentRelay.GpioId, OUTPUT);
             #endif
         }
 
-        if (currentRelay.Pwm)
+        if (currentRelay.InvertOutput)
         {
-            if (currentRelay.InvertOutput)
-            {
-                currentRelay.OffValue = RelayPwmHigh;
-                currentRelay.OnValue = RelayPwmLow;
-            }
-            else
-            {
-                currentRelay.OffValue = RelayPwmLow;
-                currentRelay.OnValue = RelayPwmHigh;
-            }
+            currentRelay.OffValue = HIGH;
+            currentRelay.OnValue = LOW;
         }
         else
         {
-            if (currentRelay.InvertOutput)
-            {
-                currentRelay.OffValue = HIGH;
-                currentRelay.OnValue = LOW;
-            }
-            else
-            {
-                currentRelay.OffValue = LOW;
-                currentRelay.OnValue = HIGH;
-            }
+            currentRelay.OffValue = LOW;
+            currentRelay.OnValue = HIGH;
         }
 
         // DEBUGV (String ("CurrentRelayChanIndex: ") + String (CurrentRelayChanIndex++));
@@ -201,6 +271,26 @@ bool c_OutputRelay::validate ()
 
 } // validate
 
+//----------------------------------------------------------------------------
+/*
+*   Build the gamma corrected duty for every input value at the configured
+*   PWM resolution. Channels whose timer cannot reach that resolution shift
+*   the result down.
+*/
+void c_OutputRelay::updateDutyTable ()
+{
+    // DEBUG_START;
+
+    double MaxDuty = double ((uint32_t (1) << PwmBits) - 1);
+
+    for (uint32_t InputValue = 0; InputValue < (sizeof (DutyTable) / sizeof (DutyTable[0])); ++InputValue)
+    {
+        DutyTable[InputValue] = uint16_t (min ((MaxDuty * pow (double (InputValue) / 255.0, Gamma)) + 0.5, MaxDuty));
+    }
+
+    // DEBUG_END;
+} // updateDutyTable
+
 //----------------------------------------------------------------------------
 /* Process the config
 *
@@ -221,6 +311,15 @@ bool c_OutputRelay::SetConfig (ArduinoJson::JsonObject & jsonConfig)
 
         // PrettyPrint (jsonConfig, String("c_OutputRelay::SetConfig"));
         setFromJSON (UpdateInterval, jsonConfig, OM_RELAY_UPDATE_INTERVAL_NAME);
+        setFromJSON (KeepAliveIntervalMs, jsonConfig, CN_keepalive);
+        setFromJSON (Gamma, jsonConfig, CN_gamma);
+        setFromJSON (PwmBits, jsonConfig, CN_pwmbits);
+#if defined(ARDUINO_ARCH_ESP32)
+        setFromJSON (FadeTimeMs, jsonConfig, CN_fadetime);
+#endif // defined(ARDUINO_ARCH_ESP32)
+
+        // apply the new settings to every output on the next render
+        MarkAllDataChanged ();
 
         // do we have a channel configuration array?
         if (false == jsonConfig.containsKey (CN_channels))
@@ -263,6 +362,9 @@ bool c_OutputRelay::SetConfig (ArduinoJson::JsonObject & jsonConfig)
             {
                 // DEBUGV ("Revert Pin to input");
                 // The pin has changed. Let go of the old pin
+#if defined(ARDUINO_ARCH_ESP32)
+                ledcDetachPin (CurrentOutputChannel->GpioId);
+#endif // defined(ARDUINO_ARCH_ESP32)
                 pinMode (CurrentOutputChannel->GpioId, INPUT);
             }
             CurrentOutputChannel->GpioId = (gpio_num_t)temp;
@@ -300,6 +402,12 @@ void c_OutputRelay::GetConfig (ArduinoJson::JsonObject & jsonConfig)
     // DEBUG_START;
 
     jsonConfig[OM_RELAY_UPDATE_INTERVAL_NAME] = UpdateInterval;
+    jsonConfig[CN_keepalive] = KeepAliveIntervalMs;
+    jsonConfig[CN_gamma]     = Gamma;
+    jsonConfig[CN_pwmbits]   = PwmBits;
+#if defined(ARDUINO_ARCH_ESP32)
+    jsonConfig[CN_fadetime]  = FadeTimeMs;
+#endif // defined(ARDUINO_ARCH_ESP32)
 
     JsonArray JsonChannelList = jsonConfig.createNestedArray (CN_channels);
 
@@ -340,47 +448,189 @@ void  c_OutputRelay::GetDriverName (String & sDriverName)
 } // GetDriverName
 
 //----------------------------------------------------------------------------
-void c_OutputRelay::Render ()
+/*
+*   Send the gamma corrected duty to a PWM channel. On the ESP32 the LEDC
+*   hardware can fade to the new duty. A fade cannot be changed while it
+*   runs, so a newer duty waits in previousValue until the fade ends.
+*/
+void c_OutputRelay::WritePwm (uint8_t ChannelId, RelayChannel_t & currentRelay)
+{
+    // DEBUG_START;
+
+#if defined(ARDUINO_ARCH_ESP32)
+    if (0 != FadeTimeMs)
+    {
+        if (currentRelay.FadeActive && ((millis () - currentRelay.FadeStartMs) <= FadeTimeMs))
+        {
+            currentRelay.FadePending = true;
+        }
+        else
+        {
+            StartFade (ChannelId, currentRelay);
+        }
+    }
+    else
+    {
+        ledcWrite (ChannelId, currentRelay.previousValue);
+    }
+#else
+    analogWrite (currentRelay.GpioId, currentRelay.previousValue);
+#endif // defined(ARDUINO_ARCH_ESP32)
+
+    // DEBUG_END;
+} // WritePwm
+
+#if defined(ARDUINO_ARCH_ESP32)
+//----------------------------------------------------------------------------
+void c_OutputRelay::StartFade (uint8_t ChannelId, RelayChannel_t & currentRelay)
 {
     // DEBUG_START;
 
-    uint8_t OutputDataIndex = 0;
+    // Match ledcWrite: a duty with every bit set means always on
+    uint32_t MaxDuty = (uint32_t (1) << currentRelay.PwmBits) - 1;
+    uint32_t TargetDuty = (currentRelay.previousValue == MaxDuty) ? (MaxDuty + 1) : currentRelay.previousValue;
+
+    // Arduino channels 0 - 7 are the high speed LEDC channels
+    ledc_mode_t    SpeedMode   = ledc_mode_t (ChannelId / LEDC_CHANNEL_MAX);
+    ledc_channel_t LedcChannel = ledc_channel_t (ChannelId % LEDC_CHANNEL_MAX);
+
+    ledc_set_fade_with_time (SpeedMode, LedcChannel, TargetDuty, FadeTimeMs);
+    ledc_fade_start (SpeedMode, LedcChannel, LEDC_FADE_NO_WAIT);
+
+    currentRelay.FadeActive  = true;
+    currentRelay.FadePending = false;
+    currentRelay.FadeStartMs = millis ();
+
+    // DEBUG_END;
+} // StartFade
+
+//----------------------------------------------------------------------------
+void c_OutputRelay::ServicePendingFades ()
+{
+    // DEBUG_START;
 
+    uint8_t ChannelId = 0;
     for (RelayChannel_t & currentRelay : OutputList)
     {
-        // DEBUG_V (String("OutputDataIndex: ") + String(OutputDataIndex));
-        if (currentRelay.Enabled)
+        if (currentRelay.FadePending && ((millis () - currentRelay.FadeStartMs) > FadeTimeMs))
         {
-            uint8_t newOutputValue = map (pOutputBuffer[OutputDataIndex], 0, 255, currentRelay.OffValue, currentRelay.OnValue);
-            if (currentRelay.Pwm)
-            {
-                #if defined(ARDUINO_ARCH_ESP32)
-                   ledcWrite(OutputDataIndex, newOutputValue);
-                #else
-                   analogWrite(currentRelay.GpioId, newOutputValue);
-                #endif
-            }
-            else
+            StartFade (ChannelId, currentRelay);
+        }
+        ++ChannelId;
+    }
+
+    // DEBUG_END;
+} // ServicePendingFades
+#endif // defined(ARDUINO_ARCH_ESP32)
+
+//----------------------------------------------------------------------------
+/*
+*   Drive every on / off relay from one write to the GPIO set and clear
+*   registers so they all switch at the same instant.
+*/
+void c_OutputRelay::CommitRelayMasks (uint32_t * SetMasks, uint32_t * ClearMasks)
+{
+    // DEBUG_START;
+
+#if defined(ARDUINO_ARCH_ESP32)
+    GPIO.out_w1ts      = SetMasks[0];
+    GPIO.out_w1tc      = ClearMasks[0];
+    GPIO.out1_w1ts.val = SetMasks[1];
+    GPIO.out1_w1tc.val = ClearMasks[1];
+#else
+    GPOS = SetMasks[0] & 0xffff;
+    GPOC = ClearMasks[0] & 0xffff;
+
+    // GPIO 16 lives in the RTC block
+    if ((SetMasks[0] | ClearMasks[0]) & (uint32_t (1) << 16))
+    {
+        GP16O = (SetMasks[0] & (uint32_t (1) << 16)) ? 1 : 0;
+    }
+#endif // defined(ARDUINO_ARCH_ESP32)
+
+    // DEBUG_END;
+} // CommitRelayMasks
+
+//----------------------------------------------------------------------------
+void c_OutputRelay::Render ()
+{
+    // DEBUG_START;
+
+    size_t StartChannelId;
+    size_t EndChannelId;
+
+    LatchFrame ();
+
+    do // once
+    {
+        // only touch the outputs whose data changed
+        if (!RefreshNeeded (StartChannelId, EndChannelId))
+        {
+            break;
+        }
+
+        uint32_t SetMasks[OM_RELAY_GPIO_BANKS]   = { 0 };
+        uint32_t ClearMasks[OM_RELAY_GPIO_BANKS] = { 0 };
+
+        EndChannelId = min (EndChannelId, size_t (OM_RELAY_CHANNEL_LIMIT));
+        for (uint8_t OutputDataIndex = StartChannelId; OutputDataIndex < EndChannelId; ++OutputDataIndex)
+        {
+            RelayChannel_t & currentRelay = OutputList[OutputDataIndex];
+
+            // DEBUG_V (String("OutputDataIndex: ") + String(OutputDataIndex));
+            if (currentRelay.Enabled)
             {
-                newOutputValue = (newOutputValue > currentRelay.OnOffTriggerLevel) ? currentRelay.OnValue : currentRelay.OffValue;
-                if (newOutputValue != currentRelay.previousValue)
+                uint8_t InputValue = pOutputBuffer[OutputDataIndex];
+                if (currentRelay.Pwm)
                 {
-                    digitalWrite (currentRelay.GpioId, newOutputValue);
+                    uint16_t newOutputValue = DutyTable[InputValue] >> (PwmBits - currentRelay.PwmBits);
+                    if (currentRelay.InvertOutput)
+                    {
+                        newOutputValue = ((uint32_t (1) << currentRelay.PwmBits) - 1) - newOutputValue;
+                    }
+                    currentRelay.previousValue = newOutputValue;
+                    WritePwm (OutputDataIndex, currentRelay);
+                }
+                else
+                {
+                    uint8_t newOutputValue = (InputValue > currentRelay.OnOffTriggerLevel) ? currentRelay.OnValue : currentRelay.OffValue;
+                    uint32_t GpioBank = uint32_t (currentRelay.GpioId) / 32;
+                    uint32_t GpioBit  = uint32_t (1) << (uint32_t (currentRelay.GpioId) % 32);
+                    if (GpioBank < OM_RELAY_GPIO_BANKS)
+                    {
+                        if (HIGH == newOutputValue)
+                        {
+                            SetMasks[GpioBank] |= GpioBit;
+                        }
+                        else
+                        {
+                            ClearMasks[GpioBank] |= GpioBit;
+                        }
+                    }
+                    currentRelay.previousValue = newOutputValue;
                 }
-            }
 
-            // DEBUGV (String ("OutputDataIndex: ")       + String (OutputDataIndex++));
-            // DEBUGV (String ("currentRelay.OnValue: ")  + String (currentRelay.OnValue));
-            // DEBUGV (String ("currentRelay.OffValue: ") + String (currentRelay.OffValue));
-            // DEBUGV (String ("currentRelay.Enabled: ")  + String (currentRelay.Enabled));
-            // DEBUGV (String ("currentRelay.GpioId: ")   + String (currentRelay.GpioId));
-            // DEBUGV (String ("newOutputValue: ")        + String (newOutputValue));
-            // DEBUGV (String ("Pwm: ")                   + String (currentRelay.Pwm));
-            currentRelay.previousValue = newOutputValue;
+                // DEBUGV (String ("OutputDataIndex: ")       + String (OutputDataIndex));
+                // DEBUGV (String ("currentRelay.OnValue: ")  + String (currentRelay.OnValue));
+                // DEBUGV (String ("currentRelay.OffValue: ") + String (currentRelay.OffValue));
+                // DEBUGV (String ("currentRelay.Enabled: ")  + String (currentRelay.Enabled));
+                // DEBUGV (String ("currentRelay.GpioId: ")   + String (currentRelay.GpioId));
+                // DEBUGV (String ("previousValue: ")         + String (currentRelay.previousValue));
+                // DEBUGV (String ("Pwm: ")                   + String (currentRelay.Pwm));
+            }
         }
-        ++OutputDataIndex;
+
+        CommitRelayMasks (SetMasks, ClearMasks);
+        ReportNewFrame ();
+
+    } while (false);
+
+#if defined(ARDUINO_ARCH_ESP32)
+    if (0 != FadeTimeMs)
+    {
+        ServicePendingFades ();
     }
-    ReportNewFrame ();
+#endif // defined(ARDUINO_ARCH_ESP32)
 
     // DEBUG_END;
 } // render
@@ -45,11 +45,19 @@ public:
         gpio_num_t  GpioId;
         uint8_t     OnValue;
         uint8_t     OffValue;
-        uint8_t     previousValue;
+        uint16_t    previousValue;
 #if defined(ARDUINO_ARCH_ESP32)
         uint16_t    PwmFrequency;
 #endif // defined(ARDUINO_ARCH_ESP32)
 
+        // non config data
+        uint8_t     PwmBits;        ///< Resolution the channel timer can reach at PwmFrequency
+#if defined(ARDUINO_ARCH_ESP32)
+        bool        FadeActive;
+        bool        FadePending;    ///< previousValue is waiting for the running fade to end
+        uint32_t    FadeStartMs;
+#endif // defined(ARDUINO_ARCH_ESP32)
+
     } RelayChannel_t;
 
     // These functions are inherited from c_OutputCommon
@@ -75,16 +83,39 @@ private:
 #   define OM_RELAY_CHANNEL_ENABLED_NAME    CN_en
 #   define OM_RELAY_CHANNEL_INVERT_NAME     CN_inv
 #   define OM_RELAY_CHANNEL_PWM_NAME        CN_pwm
+#   define OM_RELAY_PWM_BITS_MIN            8
+#   define OM_RELAY_PWM_BITS_MAX            16
+#   define OM_RELAY_PWM_BITS_DEFAULT        12
+#   define OM_RELAY_FADE_TIME_MAX_MS        10000
+#if defined(ARDUINO_ARCH_ESP32)
+#   define OM_RELAY_GPIO_BANKS              2
+#   define OM_RELAY_CHANNELS_PER_LEDC_TIMER 2       // arduino-esp32 maps LEDC channels 2n and 2n+1 to one timer
+#else
+#   define OM_RELAY_GPIO_BANKS              1
+#endif // defined(ARDUINO_ARCH_ESP32)
 
     bool    validate ();
+    void    updateDutyTable ();
+    void    WritePwm (uint8_t ChannelId, RelayChannel_t & currentRelay);
+    void    CommitRelayMasks (uint32_t * SetMasks, uint32_t * ClearMasks);
+#if defined(ARDUINO_ARCH_ESP32)
+    void    StartFade (uint8_t ChannelId, RelayChannel_t & currentRelay);
+    void    ServicePendingFades ();
+#endif // defined(ARDUINO_ARCH_ESP32)
 
     // config data
     RelayChannel_t  OutputList[OM_RELAY_CHANNEL_LIMIT];
     uint16_t        UpdateInterval = 0;
+    float           Gamma          = 1.0;
+    uint8_t         PwmBits        = OM_RELAY_PWM_BITS_DEFAULT;
+#if defined(ARDUINO_ARCH_ESP32)
+    uint16_t        FadeTimeMs     = 0;     ///< 0 = jump to the new duty
+#endif // defined(ARDUINO_ARCH_ESP32)
 
     // non config data
     String      OutputName;
     uint16_t    Num_Channels = OM_RELAY_CHANNEL_LIMIT;
+    uint16_t    DutyTable[256];     ///< gamma corrected duty at PwmBits resolution
 
 }; // c_OutputRelay
 
@@ -21,8 +21,23 @@
 
 #include "OutputRmt.hpp"
 
-// forward declaration for the isr handler
-static void IRAM_ATTR rmt_intr_handler (void* param);
+bool     c_OutputRmt::SyncStartEnabled            = false;
+uint32_t c_OutputRmt::PendingTxStartMask          = 0;
+uint32_t c_OutputRmt::SyncFrameStartTime          = 0;
+uint32_t c_OutputRmt::SyncFrameDurationInMicroSec = 0;
+uint32_t c_OutputRmt::ChannelFrameDurationInMicroSec[RMT_CHANNEL_MAX];
+uint32_t c_OutputRmt::FirstStartCycleThisPass     = 0;
+uint32_t c_OutputRmt::LastStartCycleThisPass      = 0;
+uint32_t c_OutputRmt::ChannelsStartedThisPass     = 0;
+uint32_t c_OutputRmt::LastStartSkewInCycles       = 0;
+uint32_t c_OutputRmt::MaxStartSkewInCycles        = 0;
+uint32_t c_OutputRmt::SynchronizedFrameCount      = 0;
+c_OutputRmt *    c_OutputRmt::ChannelTable[RMT_CHANNEL_MAX];
+rmt_isr_handle_t c_OutputRmt::DispatcherHandle              = NULL;
+uint32_t         c_OutputRmt::DispatcherIsrCount            = 0;
+uint32_t         c_OutputRmt::DispatcherIsrNotForAnyChannel = 0;
+uint32_t c_OutputRmt::RegisteredChannelsMask      = 0;
+uint32_t c_OutputRmt::ClaimedMemBlocks[RMT_CHANNEL_MAX];
 
 //----------------------------------------------------------------------------
 c_OutputRmt::c_OutputRmt()
@@ -30,6 +45,7 @@ c_OutputRmt::c_OutputRmt()
     // DEBUG_START;
 
     memset((void *)&Intensity2Rmt[0],   0x00, sizeof(Intensity2Rmt));
+    memset((void *)&Nibble2Rmt[0][0],   0x00, sizeof(Nibble2Rmt));
 #ifdef USE_RMT_DEBUG_COUNTERS
     memset((void *)&BitTypeCounters[0], 0x00, sizeof(BitTypeCounters));
 #endif // def USE_RMT_DEBUG_COUNTERS
@@ -49,6 +65,8 @@ c_OutputRmt::~c_OutputRmt ()
 
         DisableInterrupts;
         RMT.conf_ch[OutputRmtConfig.RmtChannelId].conf1.tx_start = 0;
+        PendingTxStartMask &= ~(1 << OutputRmtConfig.RmtChannelId);
+        SetMinFrameDurationInUs (0);
         RMT.int_ena.val = 0;
         RMT.int_ena.val = 0;
         RMT.int_clr.val = RMT_INT_THR_EVNT_BIT;
@@ -58,26 +76,85 @@ c_OutputRmt::~c_OutputRmt ()
         RMT.conf_ch[OutputRmtConfig.RmtChannelId].conf1.mem_rd_rst = 1;
         RMT.conf_ch[OutputRmtConfig.RmtChannelId].conf1.mem_rd_rst = 0;
 
-        rmt_isr_deregister (RMT_intr_handle);
+        // give back any borrowed memory blocks
+        RMT.conf_ch[OutputRmtConfig.RmtChannelId].conf0.mem_size = 1;
+        RegisteredChannelsMask &= ~(1 << OutputRmtConfig.RmtChannelId);
+        ClaimedMemBlocks[OutputRmtConfig.RmtChannelId] = 0;
 
-        EnableInterrupts;
+        ChannelTable[OutputRmtConfig.RmtChannelId] = nullptr;
+
+        bool ChannelsStillRunning = false;
+        for (auto CurrentChannel : ChannelTable)
+        {
+            ChannelsStillRunning |= (nullptr != CurrentChannel);
+        }
+        if (!ChannelsStillRunning && (NULL != DispatcherHandle))
+        {
+            rmt_isr_deregister (DispatcherHandle);
+            DispatcherHandle = NULL;
+        }
     }
 
     // DEBUG_END;
 } // ~c_OutputRmt
 
 //----------------------------------------------------------------------------
-/* shell function to set the 'this' pointer of the real ISR
-   This allows me to use non static variables in the ISR.
+/* The one ISR for all of the RMT channels.
+   Reads the interrupt status once and calls the handler of each channel
+   that has an enabled interrupt pending. The time spent in each channel
+   handler is recorded against that channel when the debug counters are
+   enabled.
  */
-static void IRAM_ATTR rmt_intr_handler (void* param)
+void IRAM_ATTR c_OutputRmt::ISR_Dispatcher (void* param)
 {
-    if (param)
+    // the enabled interrupts that are pending
+    uint32_t int_st = RMT.int_st.val;
+
+    ++DispatcherIsrCount;
+    if (0 == int_st)
     {
-        reinterpret_cast<c_OutputRmt *>(param)->ISR_Handler();
+        ++DispatcherIsrNotForAnyChannel;
     }
 
-} // rmt_intr_handler
+    for (uint32_t ChannelId = 0; (0 != int_st) && (ChannelId < RMT_CHANNEL_MAX); ++ChannelId)
+    {
+        uint32_t ChannelBits = ((RMT_INT_TX_END | RMT_INT_RX_END | RMT_INT_ERROR) << (ChannelId * 3)) |
+                               (RMT_INT_THR_EVNT << ChannelId);
+        uint32_t ChannelStatus = int_st & ChannelBits;
+        if (0 == ChannelStatus)
+        {
+            continue;
+        }
+        int_st &= ~ChannelBits;
+
+        c_OutputRmt * pChannel = ChannelTable[ChannelId];
+        if (nullptr == pChannel)
+        {
+            // nobody to service it. Make sure it does not fire again.
+            RMT.int_ena.val &= ~ChannelBits;
+            RMT.int_clr.val = ChannelBits;
+            continue;
+        }
+
+        ++pChannel->IsrCount;
+#ifdef USE_RMT_DEBUG_COUNTERS
+        uint32_t StartCycle = xthal_get_ccount ();
+#endif // def USE_RMT_DEBUG_COUNTERS
+
+        // only the enabled interrupts that are pending for this channel
+        pChannel->ISR_Handler (ChannelStatus);
+
+#ifdef USE_RMT_DEBUG_COUNTERS
+        uint32_t ElapsedCycles = xthal_get_ccount () - StartCycle;
+        pChannel->IsrCycles += ElapsedCycles;
+        if (ElapsedCycles > pChannel->MaxIsrCycles)
+        {
+            pChannel->MaxIsrCycles = ElapsedCycles;
+        }
+#endif // def USE_RMT_DEBUG_COUNTERS
+    }
+
+} // ISR_Dispatcher
 
 //----------------------------------------------------------------------------
 void c_OutputRmt::Begin (OutputRmtConfig_t config )
@@ -101,12 +178,22 @@ void c_OutputRmt::Begin (OutputRmtConfig_t config )
 
         NumRmtSlotsPerIntensityValue = OutputRmtConfig.IntensityDataWidth + ((OutputRmtConfig.SendInterIntensityBits) ? 1 : 0);
         TxIntensityDataStartingMask  = 1 << (OutputRmtConfig.IntensityDataWidth - 1);
+        TxIntensityDataStartingShift = OutputRmtConfig.IntensityDataWidth - RMT_ITEMS_PER_NIBBLE;
+#ifdef RMT_DISABLE_NIBBLE_TABLE
+        UseNibbleTable = false;
+#else
+        UseNibbleTable = (0 != OutputRmtConfig.IntensityDataWidth) &&
+                         (0 == (OutputRmtConfig.IntensityDataWidth % RMT_ITEMS_PER_NIBBLE));
+#endif // def RMT_DISABLE_NIBBLE_TABLE
         // DEBUG_V (String("          IntensityDataWidth: ") + String(OutputRmtConfig.IntensityDataWidth));
         // DEBUG_V (String("NumRmtSlotsPerIntensityValue: ") + String (NumRmtSlotsPerIntensityValue));
         // DEBUG_V(String("  TxIntensityDataStartingMask: 0x") + String(TxIntensityDataStartingMask, HEX));
         // DEBUG_V (String ("                    DataPin: ") + String (OutputRmtConfig.DataPin));
         // DEBUG_V (String ("               RmtChannelId: ") + String (OutputRmtConfig.RmtChannelId));
 
+        // a lower channel may still be sending out of our block
+        ReclaimMemBlock ();
+
         // Configure RMT channel
         rmt_config_t RmtConfig;
         RmtConfig.rmt_mode = rmt_mode_t::RMT_MODE_TX;
@@ -127,8 +214,11 @@ void c_OutputRmt::Begin (OutputRmtConfig_t config )
         // DEBUG_V();
         ESP_ERROR_CHECK(rmt_set_source_clk(RmtConfig.channel, rmt_source_clk_t::RMT_BASECLK_APB));
         // DEBUG_V();
-        // ESP_ERROR_CHECK (esp_intr_alloc (ETS_RMT_INTR_SOURCE, ESP_INTR_FLAG_IRAM | ESP_INTR_FLAG_LEVEL3 | ESP_INTR_FLAG_SHARED, rmt_intr_handler, this, &RMT_intr_handle));
-        ESP_ERROR_CHECK(rmt_isr_register(rmt_intr_handler, this, ESP_INTR_FLAG_IRAM | ESP_INTR_FLAG_LEVEL1 | ESP_INTR_FLAG_SHARED, &RMT_intr_handle));
+        ChannelTable[OutputRmtConfig.RmtChannelId] = this;
+        if (NULL == DispatcherHandle)
+        {
+            ESP_ERROR_CHECK(rmt_isr_register(ISR_Dispatcher, nullptr, ESP_INTR_FLAG_IRAM | ESP_INTR_FLAG_LEVEL1 | ESP_INTR_FLAG_SHARED, &DispatcherHandle));
+        }
         // DEBUG_V();
 
         RMT.apb_conf.fifo_mask = 1;      // enable access to the mem blocks
@@ -141,12 +231,16 @@ void c_OutputRmt::Begin (OutputRmtConfig_t config )
         // DEBUG_V();
 
         RmtStartAddr = &RMTMEM.chan[OutputRmtConfig.RmtChannelId].data32[0];
-        RmtEndAddr = &RMTMEM.chan[OutputRmtConfig.RmtChannelId].data32[63];
+        RmtEndAddr = &RMTMEM.chan[OutputRmtConfig.RmtChannelId].data32[NUM_RMT_SLOTS - 1];
         RmtCurrentAddr = RmtStartAddr;
         // DEBUG_V();
 
+        // Start with our own block. Render grows the buffer into the
+        // blocks of unused channels once it knows which channels are in use.
+        ClaimedMemBlocks[OutputRmtConfig.RmtChannelId] = (1 << OutputRmtConfig.RmtChannelId);
+
         RMT.tx_lim_ch[OutputRmtConfig.RmtChannelId].limit = NumRmtSlotsPerInterrupt;
-        NumAvailableRmtSlotsToFill = NUM_RMT_SLOTS;
+        NumAvailableRmtSlotsToFill = NumRmtSlots;
         // DEBUG_V();
 
         // this should be a vector but Arduino does not support them.
@@ -161,9 +255,10 @@ void c_OutputRmt::Begin (OutputRmtConfig_t config )
                 CurrentTranslation++;
             }
         }
+        BuildNibble2RmtTable ();
 
         // create a delay before starting to send data
-        LastFrameStartTime = millis();
+        LastFrameStartTime = micros ();
 
         // DEBUG_V (String ("                Intensity2Rmt[0]: 0x") + String (uint32_t (Intensity2Rmt[0].val), HEX));
         // DEBUG_V (String ("                Intensity2Rmt[1]: 0x") + String (uint32_t (Intensity2Rmt[1].val), HEX));
@@ -181,11 +276,10 @@ void c_OutputRmt::Begin (OutputRmtConfig_t config )
 } // init
 
 //----------------------------------------------------------------------------
-void IRAM_ATTR c_OutputRmt::ISR_Handler ()
+void IRAM_ATTR c_OutputRmt::ISR_Handler (uint32_t int_st)
 {
     // //DEBUG_START;
 
-    uint32_t int_st = RMT.int_raw.val;
     // //DEBUG_V(String("              int_st: 0x") + String(int_st, HEX));
     // //DEBUG_V(String("  RMT_INT_TX_END_BIT: 0x") + String(RMT_INT_TX_END_BIT, HEX));
     // //DEBUG_V(String("RMT_INT_THR_EVNT_BIT: 0x") + String(RMT_INT_THR_EVNT_BIT, HEX));
@@ -194,6 +288,7 @@ void IRAM_ATTR c_OutputRmt::ISR_Handler ()
     {
         if (int_st & RMT_INT_TX_END_BIT)
         {
+            ++InterruptsThisFrame;
 #ifdef USE_RMT_DEBUG_COUNTERS
             FrameEndISRcounter++;
 #endif // def USE_RMT_DEBUG_COUNTERS
@@ -212,6 +307,7 @@ void IRAM_ATTR c_OutputRmt::ISR_Handler ()
         if (int_st & RMT_INT_THR_EVNT_BIT)
         {
             // //DEBUG_V("RMT_INT_THR_EVNT_BIT");
+            ++InterruptsThisFrame;
 
 #ifdef USE_RMT_DEBUG_COUNTERS
             DataISRcounter++;
@@ -221,9 +317,9 @@ void IRAM_ATTR c_OutputRmt::ISR_Handler ()
             RMT.int_clr.val = RMT_INT_THR_EVNT_BIT;
 
             NumAvailableRmtSlotsToFill += NumRmtSlotsPerInterrupt;
-            if (NUM_RMT_SLOTS < NumAvailableRmtSlotsToFill)
+            if (NumRmtSlots < NumAvailableRmtSlotsToFill)
             {
-                NumAvailableRmtSlotsToFill = NUM_RMT_SLOTS;
+                NumAvailableRmtSlotsToFill = NumRmtSlots;
             }
 
             if (MoreDataToSend())
@@ -260,6 +356,39 @@ void IRAM_ATTR c_OutputRmt::ISR_Handler ()
 
 } // ISR_Handler
 
+//----------------------------------------------------------------------------
+void c_OutputRmt::SetIntensity2Rmt (rmt_item32_t NewValue, RmtDataBitIdType_t ID)
+{
+    // DEBUG_START;
+
+    Intensity2Rmt[ID] = NewValue;
+
+    if ((RmtDataBitIdType_t::RMT_DATA_BIT_ZERO_ID == ID) ||
+        (RmtDataBitIdType_t::RMT_DATA_BIT_ONE_ID  == ID))
+    {
+        BuildNibble2RmtTable ();
+    }
+
+    // DEBUG_END;
+} // SetIntensity2Rmt
+
+//----------------------------------------------------------------------------
+/*
+    Expand every possible nibble value into the four RMT items that
+    represent it, MSB first. The ISR then copies whole nibbles into
+    RMT memory instead of testing and translating one bit at a time.
+*/
+void c_OutputRmt::BuildNibble2RmtTable ()
+{
+    // DEBUG_START;
+
+    RmtBuildNibbleTable (Intensity2Rmt[RmtDataBitIdType_t::RMT_DATA_BIT_ONE_ID].val,
+                         Intensity2Rmt[RmtDataBitIdType_t::RMT_DATA_BIT_ZERO_ID].val,
+                         Nibble2Rmt);
+
+    // DEBUG_END;
+} // BuildNibble2RmtTable
+
 //----------------------------------------------------------------------------
 void c_OutputRmt::PauseOutput(bool PauseOutput)
 {
@@ -274,6 +403,7 @@ void c_OutputRmt::PauseOutput(bool PauseOutput)
         // //DEBUG_V("stop the output");
         DisableInterrupts;
         RMT.conf_ch[OutputRmtConfig.RmtChannelId].conf1.tx_start = 0;
+        PendingTxStartMask &= ~(1 << OutputRmtConfig.RmtChannelId);
 
         RMT.int_clr.val = RMT_INT_THR_EVNT_BIT;
         RMT.int_clr.val = RMT_INT_TX_END_BIT;
@@ -289,16 +419,7 @@ inline void IRAM_ATTR c_OutputRmt::ISR_EnqueueData(uint32_t value)
 {
     // //DEBUG_START;
 
-    // write the data
-    RmtCurrentAddr->val = value;
-
-    --NumAvailableRmtSlotsToFill;
-
-    // increment address, check for address wrap around
-    if (++RmtCurrentAddr > RmtEndAddr)
-    {
-        RmtCurrentAddr = RmtStartAddr;
-    }
+    RmtEnqueueItem (RmtCurrentAddr, RmtStartAddr, RmtEndAddr, NumAvailableRmtSlotsToFill, value);
 
     // //DEBUG_END;
 }
@@ -361,6 +482,9 @@ void c_OutputRmt::StartNewFrame ()
     FrameStartCounter++;
 #endif // def USE_RMT_DEBUG_COUNTERS
 
+    InterruptsPerFrame  = InterruptsThisFrame;
+    InterruptsThisFrame = 0;
+
     // Need to build up a backlog of entries in the buffer
     // so that there is still plenty of data to send when the isr fires.
     // //DEBUG_V(String("NumIdleBits: ") + String(OutputRmtConfig.NumIdleBits));
@@ -399,7 +523,7 @@ void c_OutputRmt::StartNewFrame ()
     // DEBUG_V();
 /*
     // dump the intensity data we just wrote
-    for (uint8_t bitIndex = 0; NUM_RMT_SLOTS > bitIndex; bitIndex++)
+    for (uint8_t bitIndex = 0; NumRmtSlots > bitIndex; bitIndex++)
     {
         // DEBUG_V(String("Data at '" + String(bitIndex) + "': 0x") + String(((uint32_t *)RmtStartAddr)[bitIndex], HEX));
     }
@@ -413,34 +537,33 @@ void IRAM_ATTR c_OutputRmt::ISR_Handler_SendIntensityData ()
 {
     // //DEBUG_START;
 
-    uint32_t OneBitValue  = Intensity2Rmt[RmtDataBitIdType_t::RMT_DATA_BIT_ONE_ID].val;
-    uint32_t ZeroBitValue = Intensity2Rmt[RmtDataBitIdType_t::RMT_DATA_BIT_ZERO_ID].val;
+#ifdef USE_RMT_DEBUG_COUNTERS
+    uint32_t StartCycle = xthal_get_ccount ();
+    uint32_t IntensityValuesThisPass = 0;
+#endif // def USE_RMT_DEBUG_COUNTERS
 
     while ((NumAvailableRmtSlotsToFill > NumRmtSlotsPerIntensityValue) && MoreDataToSend())
     {
         uint32_t IntensityValue = GetNextIntensityToSend();
 #ifdef USE_RMT_DEBUG_COUNTERS
         IntensityValuesSent++;
+        IntensityValuesThisPass++;
+        IntensityBitsSent += OutputRmtConfig.IntensityDataWidth;
+        uint32_t NumOneBits = __builtin_popcount (IntensityValue & ((TxIntensityDataStartingMask << 1) - 1));
+        BitTypeCounters[int(RmtDataBitIdType_t::RMT_DATA_BIT_ONE_ID)]  += NumOneBits;
+        BitTypeCounters[int(RmtDataBitIdType_t::RMT_DATA_BIT_ZERO_ID)] += OutputRmtConfig.IntensityDataWidth - NumOneBits;
 #endif // def USE_RMT_DEBUG_COUNTERS
 
         // convert the intensity data into RMT slot data
-        for (uint32_t bitmask = TxIntensityDataStartingMask; 0 != bitmask; bitmask >>= 1)
+        if (UseNibbleTable)
         {
-#ifdef USE_RMT_DEBUG_COUNTERS
-            IntensityBitsSent++;
-#endif // def USE_RMT_DEBUG_COUNTERS
-            ISR_EnqueueData((IntensityValue & bitmask) ? OneBitValue : ZeroBitValue);
-#ifdef USE_RMT_DEBUG_COUNTERS
-            if (IntensityValue & bitmask)
-            {
-                BitTypeCounters[int(RmtDataBitIdType_t::RMT_DATA_BIT_ONE_ID)]++;
-            }
-            else
-            {
-                BitTypeCounters[int(RmtDataBitIdType_t::RMT_DATA_BIT_ZERO_ID)]++;
-            }
-#endif // def USE_RMT_DEBUG_COUNTERS
-        } // end send one intensity value
+            RmtEnqueueIntensityByNibble (RmtCurrentAddr, RmtStartAddr, RmtEndAddr, NumAvailableRmtSlotsToFill,
+                                         IntensityValue, TxIntensityDataStartingShift, Nibble2Rmt);
+        }
+        else
+        {
+            ISR_SendIntensityBitByBit (IntensityValue);
+        }
 
         if (OutputRmtConfig.SendEndOfFrameBits && !MoreDataToSend())
         {
@@ -462,10 +585,37 @@ void IRAM_ATTR c_OutputRmt::ISR_Handler_SendIntensityData ()
     // gets overwritten on next refill
     RmtCurrentAddr->val = 0;
 
+#ifdef USE_RMT_DEBUG_COUNTERS
+    if (IntensityValuesThisPass)
+    {
+        IsrSendCycles          += xthal_get_ccount () - StartCycle;
+        IsrSendIntensityValues += IntensityValuesThisPass;
+        IsrCyclesPerIntensityValue = IsrSendCycles / IsrSendIntensityValues;
+        if (IsrSendIntensityValues > 100000)
+        {
+            // keep a rolling measurement without overflowing the cycle count
+            IsrSendCycles          = 0;
+            IsrSendIntensityValues = 0;
+        }
+    }
+#endif // def USE_RMT_DEBUG_COUNTERS
+
     // //DEBUG_END;
 
 } // ISR_Handler_SendIntensityData
 
+//----------------------------------------------------------------------------
+/*
+    Used for intensity widths that are not a whole number of nibbles (GECE)
+*/
+inline void IRAM_ATTR c_OutputRmt::ISR_SendIntensityBitByBit (uint32_t IntensityValue)
+{
+    RmtEnqueueIntensityBitByBit (RmtCurrentAddr, RmtStartAddr, RmtEndAddr, NumAvailableRmtSlotsToFill,
+                                 IntensityValue, TxIntensityDataStartingMask,
+                                 Intensity2Rmt[RmtDataBitIdType_t::RMT_DATA_BIT_ONE_ID].val,
+                                 Intensity2Rmt[RmtDataBitIdType_t::RMT_DATA_BIT_ZERO_ID].val);
+} // ISR_SendIntensityBitByBit
+
 //----------------------------------------------------------------------------
 bool c_OutputRmt::Render ()
 {
@@ -484,8 +634,29 @@ bool c_OutputRmt::Render ()
             break;
         }
 
-        if ((millis() - LastFrameStartTime) < MIN_FRAME_TIME_MS)
+        if (!UpdateMemBlocks ())
         {
+            // a lower channel is still sending out of our memory block
+            break;
+        }
+
+        if (SyncStartEnabled)
+        {
+            // every channel runs from the frame clock of the slowest channel
+            if ((micros () - SyncFrameStartTime) < SyncFrameDurationInMicroSec)
+            {
+                break;
+            }
+        }
+        else if ((micros () - LastFrameStartTime) < FrameMinDurationInMicroSec)
+        {
+            break;
+        }
+
+        // nothing new to send and the pixels are holding the last frame
+        if (OutputRmtConfig.pPixelDataSource && OutputRmtConfig.pPixelDataSource->FrameIsUnchanged ())
+        {
+            OutputRmtConfig.pPixelDataSource->RefreshSkipped ();
             break;
         }
 
@@ -507,7 +678,7 @@ bool c_OutputRmt::Render ()
         RMT.conf_ch[OutputRmtConfig.RmtChannelId].conf1.mem_rd_rst = 1;
         RMT.conf_ch[OutputRmtConfig.RmtChannelId].conf1.mem_rd_rst = 0;
         RmtCurrentAddr = RmtStartAddr;
-        NumAvailableRmtSlotsToFill = NUM_RMT_SLOTS;
+        NumAvailableRmtSlotsToFill = NumRmtSlots;
         RMT.tx_lim_ch[OutputRmtConfig.RmtChannelId].limit = NumRmtSlotsPerInterrupt;
 
         // //DEBUG_V("Set up a new Frame");
@@ -516,8 +687,17 @@ bool c_OutputRmt::Render ()
         // //DEBUG_V("Start Transmit");
         // enable the threshold event interrupt
         EnableInterrupts;
-        RMT.conf_ch[OutputRmtConfig.RmtChannelId].conf1.tx_start = 1;
-        LastFrameStartTime = millis ();
+        if (SyncStartEnabled)
+        {
+            // the data is in place. StartSynchronizedChannels starts the transmit.
+            PendingTxStartMask |= (1 << OutputRmtConfig.RmtChannelId);
+        }
+        else
+        {
+            RMT.conf_ch[OutputRmtConfig.RmtChannelId].conf1.tx_start = 1;
+            RecordChannelStart (xthal_get_ccount ());
+        }
+        LastFrameStartTime = micros ();
         // //DEBUG_V("Transmit Started");
         Response = true;
 
@@ -529,13 +709,269 @@ bool c_OutputRmt::Render ()
 
 } // render
 
+//----------------------------------------------------------------------------
+/*
+    Called between frames. Claim the memory blocks from our own block up to
+    the next channel that is in use (or the end of RMT memory). Each block is
+    64 items so every extra block cuts the refill interrupts per frame.
+
+    Channels register as they start. A lower channel that borrowed blocks
+    from a channel that has since started gives them back at its next frame.
+    Until then the higher channel waits.
+
+    returns false if our own block is still in use by another channel.
+*/
+bool c_OutputRmt::UpdateMemBlocks ()
+{
+    // //DEBUG_START;
+
+    bool Response = false;
+    uint32_t ChannelId = uint32_t (OutputRmtConfig.RmtChannelId);
+
+    do // once
+    {
+        uint32_t BlocksClaimedByOthers = 0;
+        for (uint32_t OtherChannelId = 0; OtherChannelId < RMT_CHANNEL_MAX; ++OtherChannelId)
+        {
+            if (OtherChannelId != ChannelId)
+            {
+                BlocksClaimedByOthers |= ClaimedMemBlocks[OtherChannelId];
+            }
+        }
+
+        uint32_t NewNumMemBlocks = 0;
+        uint32_t NewClaim        = 0;
+        for (uint32_t BlockId = ChannelId; BlockId < RMT_MAX_MEM_BLOCKS; ++BlockId)
+        {
+            uint32_t BlockMask = (1 << BlockId);
+            if ((BlockId != ChannelId) && (RegisteredChannelsMask & BlockMask))
+            {
+                // that channel owns this block
+                break;
+            }
+            if (BlocksClaimedByOthers & BlockMask)
+            {
+                break;
+            }
+            NewClaim |= BlockMask;
+            ++NewNumMemBlocks;
+        }
+
+        if (0 == NewNumMemBlocks)
+        {
+            ClaimedMemBlocks[ChannelId] = 0;
+            break;
+        }
+
+        Response = true;
+        ClaimedMemBlocks[ChannelId] = NewClaim;
+
+        if (NewNumMemBlocks == NumMemBlocks)
+        {
+            break;
+        }
+
+        NumMemBlocks = NewNumMemBlocks;
+        NumRmtSlots  = NUM_RMT_SLOTS * NumMemBlocks;
+        // one block keeps the original 75% threshold. Otherwise refill half the buffer at a time.
+        NumRmtSlotsPerInterrupt = (1 == NumMemBlocks) ? (NUM_RMT_SLOTS * 0.75) : (NumRmtSlots / 2);
+
+        RMT.conf_ch[ChannelId].conf0.mem_size = NumMemBlocks;
+        RmtEndAddr = RmtStartAddr + (NumRmtSlots - 1);
+
+        // DEBUG_V (String ("RMT channel ") + String (ChannelId) + String (" uses ") + String (NumMemBlocks) + String (" memory blocks"));
+
+    } while (false);
+
+    // //DEBUG_END;
+
+    return Response;
+
+} // UpdateMemBlocks
+
+//----------------------------------------------------------------------------
+/*
+    Called before this channel configures its own memory block. A lower
+    channel may have borrowed the block and be part way through a frame.
+    Register first so the lower channel cannot claim the block again, wait
+    for its frame to end (stop it if it does not) and then shrink it back
+    to its own blocks.
+*/
+void c_OutputRmt::ReclaimMemBlock ()
+{
+    // DEBUG_START;
+
+    uint32_t ChannelId = uint32_t (OutputRmtConfig.RmtChannelId);
+    uint32_t BlockMask = (1 << ChannelId);
+
+    RegisteredChannelsMask |= BlockMask;
+
+    for (uint32_t OtherChannelId = 0; OtherChannelId < ChannelId; ++OtherChannelId)
+    {
+        c_OutputRmt * pBorrower = ChannelTable[OtherChannelId];
+        if ((nullptr == pBorrower) || (0 == (ClaimedMemBlocks[OtherChannelId] & BlockMask)))
+        {
+            continue;
+        }
+
+        uint32_t WaitTimeMs = 0;
+        while (!pBorrower->NoFrameInProgress () && (WaitTimeMs++ < RMT_RECLAIM_MAX_WAIT_MS))
+        {
+            delay (1);
+        }
+
+        if (!pBorrower->NoFrameInProgress ())
+        {
+            logcon (String (F("RMT channel ")) + String (OtherChannelId) + F(" did not finish its frame. Stopping it."));
+            bool WasPaused = pBorrower->OutputIsPaused;
+            pBorrower->PauseOutput (true);
+            pBorrower->PauseOutput (WasPaused);
+        }
+
+        // the borrower is idle. It gives back every block above its own up to ours.
+        pBorrower->UpdateMemBlocks ();
+        // DEBUG_V (String ("RMT channel ") + String (OtherChannelId) + String (" now uses ") + String (pBorrower->NumMemBlocks) + String (" memory blocks"));
+    }
+
+    // DEBUG_END;
+
+} // ReclaimMemBlock
+
+//----------------------------------------------------------------------------
+void c_OutputRmt::SetMinFrameDurationInUs (uint32_t value)
+{
+    // DEBUG_START;
+
+    FrameMinDurationInMicroSec = value;
+
+    if (uint32_t (OutputRmtConfig.RmtChannelId) < uint32_t (RMT_CHANNEL_MAX))
+    {
+        ChannelFrameDurationInMicroSec[OutputRmtConfig.RmtChannelId] = value;
+    }
+
+    SyncFrameDurationInMicroSec = 0;
+    for (uint32_t Duration : ChannelFrameDurationInMicroSec)
+    {
+        SyncFrameDurationInMicroSec = max (SyncFrameDurationInMicroSec, Duration);
+    }
+
+    // DEBUG_END;
+
+} // SetMinFrameDurationInUs
+
+//----------------------------------------------------------------------------
+void c_OutputRmt::SetSyncStart (bool value)
+{
+    // DEBUG_START;
+
+    if (SyncStartEnabled != value)
+    {
+        logcon (String (F ("RMT synchronized start ")) + ((value) ? F ("enabled") : F ("disabled")));
+    }
+
+    SyncStartEnabled = value;
+
+    // DEBUG_END;
+
+} // SetSyncStart
+
+//----------------------------------------------------------------------------
+void c_OutputRmt::RecordChannelStart (uint32_t StartCycle)
+{
+    if (0 == ChannelsStartedThisPass++)
+    {
+        FirstStartCycleThisPass = StartCycle;
+    }
+    LastStartCycleThisPass = StartCycle;
+
+} // RecordChannelStart
+
+//----------------------------------------------------------------------------
+/*
+    Called once per output manager render pass after every driver has had
+    its Render call. Starts the channels that Render prepared in a single
+    tight loop and records how far apart the channels started in this pass.
+
+    The original ESP32 RMT has no simultaneous transmit group so tx_start
+    is written channel by channel with interrupts off. The skew is the
+    time from the first to the last of those writes.
+*/
+void c_OutputRmt::StartSynchronizedChannels ()
+{
+    // //DEBUG_START;
+
+    if (PendingTxStartMask)
+    {
+        uint32_t Mask = PendingTxStartMask;
+        PendingTxStartMask = 0;
+
+        portDISABLE_INTERRUPTS ();
+        uint32_t FirstStartCycle = xthal_get_ccount ();
+        for (uint32_t ChannelId = 0; Mask; ++ChannelId, Mask >>= 1)
+        {
+            if (Mask & 1)
+            {
+                RMT.conf_ch[ChannelId].conf1.tx_start = 1;
+            }
+        }
+        uint32_t LastStartCycle = xthal_get_ccount ();
+        portENABLE_INTERRUPTS ();
+
+        RecordChannelStart (FirstStartCycle);
+        RecordChannelStart (LastStartCycle);
+        SyncFrameStartTime = micros ();
+        ++SynchronizedFrameCount;
+    }
+
+    // a single channel has nothing to be skewed against
+    if (1 < ChannelsStartedThisPass)
+    {
+        LastStartSkewInCycles = LastStartCycleThisPass - FirstStartCycleThisPass;
+        MaxStartSkewInCycles  = max (MaxStartSkewInCycles, LastStartSkewInCycles);
+    }
+    ChannelsStartedThisPass = 0;
+
+    // //DEBUG_END;
+
+} // StartSynchronizedChannels
+
+//----------------------------------------------------------------------------
+void c_OutputRmt::GetSharedStatus (ArduinoJson::JsonObject& jsonStatus)
+{
+    // //DEBUG_START;
+
+    uint32_t CyclesPerMicroSec = getCpuFrequencyMhz ();
+
+    JsonObject SyncStatus = jsonStatus.createNestedObject (F ("RmtSync"));
+    SyncStatus[F ("Enabled")]            = SyncStartEnabled;
+    SyncStatus[F ("FrameDurationUs")]    = SyncFrameDurationInMicroSec;
+    SyncStatus[F ("SynchronizedFrames")] = SynchronizedFrameCount;
+    SyncStatus[F ("LastStartSkewNs")]    = uint32_t ((uint64_t (LastStartSkewInCycles) * 1000) / CyclesPerMicroSec);
+    SyncStatus[F ("MaxStartSkewNs")]     = uint32_t ((uint64_t (MaxStartSkewInCycles) * 1000) / CyclesPerMicroSec);
+
+    JsonObject IsrStatus = jsonStatus.createNestedObject (F ("RmtIsr"));
+    IsrStatus[F ("Interrupts")]          = DispatcherIsrCount;
+    IsrStatus[F ("NotForAnyChannel")]    = DispatcherIsrNotForAnyChannel;
+
+    // //DEBUG_END;
+
+} // GetSharedStatus
+
 //----------------------------------------------------------------------------
 void c_OutputRmt::GetStatus (ArduinoJson::JsonObject& jsonStatus)
 {
     // //DEBUG_START;
 
     jsonStatus[F("NumRmtSlotOverruns")] = NumRmtSlotOverruns;
+    jsonStatus[F("MemBlocks")]          = NumMemBlocks;
+    jsonStatus[F("InterruptsPerFrame")] = InterruptsPerFrame;
+
+    jsonStatus[F("IsrCount")]           = IsrCount;
 #ifdef USE_RMT_DEBUG_COUNTERS
+    uint32_t CyclesPerMicroSec = getCpuFrequencyMhz ();
+    jsonStatus[F("AvgIsrTimeNs")]       = (0 == IsrCount) ? 0 : uint32_t ((uint64_t (IsrCycles / IsrCount) * 1000) / CyclesPerMicroSec);
+    jsonStatus[F("MaxIsrTimeNs")]       = uint32_t ((uint64_t (MaxIsrCycles) * 1000) / CyclesPerMicroSec);
+
     JsonObject debugStatus = jsonStatus.createNestedObject("RMT Debug");
     debugStatus["RmtChannelId"]                 = OutputRmtConfig.RmtChannelId;
     debugStatus["DataISRcounter"]               = DataISRcounter;
@@ -562,6 +998,8 @@ void c_OutputRmt::GetStatus (ArduinoJson::JsonObject& jsonStatus)
     debugStatus["SendInterIntensityBits"]       = OutputRmtConfig.SendInterIntensityBits;
     debugStatus["SendEndOfFrameBits"]           = OutputRmtConfig.SendEndOfFrameBits;
     debugStatus["NumRmtSlotsPerIntensityValue"] = NumRmtSlotsPerIntensityValue;
+    debugStatus["TxPath"]                       = (UseNibbleTable) ? F("NibbleTable") : F("BitByBit");
+    debugStatus["IsrCyclesPerIntensityValue"]   = IsrCyclesPerIntensityValue;
 
     uint32_t index = 0;
     for (auto CurrentCounter : BitTypeCounters)
@@ -23,6 +23,7 @@
 #include <driver/rmt.h>
 #include "OutputPixel.hpp"
 #include "OutputSerial.hpp"
+#include "OutputRmtItems.hpp"
 
 class c_OutputRmt
 {
@@ -88,21 +89,56 @@ private:
     uint32_t            NumRmtSlotsPerIntensityValue      = 8;
     uint32_t            NumRmtSlotOverruns                = 0;
 
-    rmt_isr_handle_t       RMT_intr_handle = NULL;
     volatile rmt_item32_t *RmtStartAddr    = nullptr;
     volatile rmt_item32_t *RmtCurrentAddr  = nullptr;
     volatile rmt_item32_t *RmtEndAddr      = nullptr;
 
 #define NUM_RMT_SLOTS (sizeof(RMTMEM.chan[0].data32) / sizeof(RMTMEM.chan[0].data32[0]))
-#define MIN_FRAME_TIME_MS 25
+#define RMT_MAX_MEM_BLOCKS  RMT_CHANNEL_MAX
 
+    // A channel may borrow the memory blocks of the unused channels above it.
+    // With more than one block the buffer is split in two halves that are
+    // refilled alternately (ping-pong).
+    uint32_t            NumMemBlocks                = 1;
+    size_t              NumRmtSlots                 = NUM_RMT_SLOTS;
     volatile size_t     NumAvailableRmtSlotsToFill  = NUM_RMT_SLOTS;
-    const size_t        NumRmtSlotsPerInterrupt     = NUM_RMT_SLOTS * 0.75;
-    uint32_t            LastFrameStartTime          = 0;
-    uint32_t            FrameMinDurationInMicroSec  = 1000;
+    size_t              NumRmtSlotsPerInterrupt     = NUM_RMT_SLOTS * 0.75;
+    volatile uint32_t   InterruptsThisFrame         = 0;
+    uint32_t            InterruptsPerFrame          = 0;
+    bool                UpdateMemBlocks ();
+    void                ReclaimMemBlock ();
+#define RMT_RECLAIM_MAX_WAIT_MS     100     // longest wait for a borrowing channel to finish its frame
+
+    // One interrupt handler services every channel. It reads the status
+    // once and calls only the channels that have a pending interrupt.
+    static c_OutputRmt *    ChannelTable[RMT_CHANNEL_MAX];
+    static rmt_isr_handle_t DispatcherHandle;
+    static uint32_t         DispatcherIsrCount;
+    static uint32_t         DispatcherIsrNotForAnyChannel;
+    static void IRAM_ATTR   ISR_Dispatcher (void * param);
+    uint32_t                IsrCount                    = 0;
+#ifdef USE_RMT_DEBUG_COUNTERS
+    uint64_t                IsrCycles                   = 0;
+    uint32_t                MaxIsrCycles                = 0;
+#endif // def USE_RMT_DEBUG_COUNTERS
+
+    static uint32_t     RegisteredChannelsMask;
+    static uint32_t     ClaimedMemBlocks[RMT_CHANNEL_MAX];                  ///< mask of blocks used by each channel
+    uint32_t            LastFrameStartTime          = 0; ///< micros
+    uint32_t            FrameMinDurationInMicroSec  = 25000;
     uint32_t            TxIntensityDataStartingMask = 0x80;
     RmtDataBitIdType_t  InterIntensityValueId       = RMT_INVALID_VALUE;
 
+    // The nibble to item table is rebuilt whenever the zero / one bit
+    // translations change and is used for any intensity width that is a
+    // whole number of nibbles.
+// #define RMT_DISABLE_NIBBLE_TABLE
+    uint32_t            Nibble2Rmt[RMT_NUM_NIBBLE_VALUES][RMT_ITEMS_PER_NIBBLE];
+    bool                UseNibbleTable              = false;
+    uint32_t            TxIntensityDataStartingShift = 4;
+    void                BuildNibble2RmtTable ();
+    inline void     IRAM_ATTR ISR_SendIntensityBitByBit (uint32_t IntensityValue);
+
     void                  StartNewFrame ();
     void            IRAM_ATTR ISR_Handler_SendIntensityData ();
     inline void     IRAM_ATTR ISR_EnqueueData(uint32_t value);
@@ -116,6 +152,21 @@ private:
 
     TaskHandle_t SendIntensityDataTaskHandle = NULL;
 
+    // Synchronized start. All channels share one frame clock and are
+    // prepared by Render. StartSynchronizedChannels kicks them together.
+    static bool         SyncStartEnabled;
+    static uint32_t     PendingTxStartMask;
+    static uint32_t     SyncFrameStartTime;                                 ///< micros
+    static uint32_t     SyncFrameDurationInMicroSec;                        ///< longest channel
+    static uint32_t     ChannelFrameDurationInMicroSec[RMT_CHANNEL_MAX];
+    static uint32_t     FirstStartCycleThisPass;
+    static uint32_t     LastStartCycleThisPass;
+    static uint32_t     ChannelsStartedThisPass;
+    static uint32_t     LastStartSkewInCycles;
+    static uint32_t     MaxStartSkewInCycles;
+    static uint32_t     SynchronizedFrameCount;
+    static void         RecordChannelStart (uint32_t StartCycle);
+
 public:
     c_OutputRmt ();
     virtual ~c_OutputRmt ();
@@ -125,10 +176,14 @@ public:
     void GetStatus                              (ArduinoJson::JsonObject& jsonStatus);
     void set_pin                                (gpio_num_t _DataPin) { OutputRmtConfig.DataPin = _DataPin; rmt_set_gpio (OutputRmtConfig.RmtChannelId, rmt_mode_t::RMT_MODE_TX, OutputRmtConfig.DataPin, false); }
     void PauseOutput                            (bool State);
-    void SetMinFrameDurationInUs                (uint32_t value) { FrameMinDurationInMicroSec = value; }
+    void SetMinFrameDurationInUs                (uint32_t value);
     inline uint32_t IRAM_ATTR GetRmtIntMask     ()               { return ((RMT_INT_TX_END_BIT | RMT_INT_ERROR_BIT | RMT_INT_ERROR_BIT | RMT_INT_THR_EVNT_BIT)); }
     void GetDriverName                          (String &value)  { value = CN_RMT; }
 
+    static void SetSyncStart                    (bool value);
+    static void StartSynchronizedChannels       ();
+    static void GetSharedStatus                 (ArduinoJson::JsonObject& jsonStatus);
+
 #define DisableInterrupts RMT.int_ena.val &= ~(RMT_INT_TX_END_BIT | RMT_INT_THR_EVNT_BIT)
 #define EnableInterrupts  RMT.int_ena.val |=  (RMT_INT_TX_END_BIT | RMT_INT_THR_EVNT_BIT)
 
@@ -136,11 +191,11 @@ public:
 #define RMT_Clock_Divisor   2.0
 #define RMT_TickLengthNS    float ( (1/ (RMT_ClockRate/RMT_Clock_Divisor)) * float(NanoSecondsInASecond))
 
-    void SetIntensity2Rmt (rmt_item32_t NewValue, RmtDataBitIdType_t ID) { Intensity2Rmt[ID] = NewValue; }
+    void SetIntensity2Rmt (rmt_item32_t NewValue, RmtDataBitIdType_t ID);
 
     bool NoFrameInProgress () { return (0 == (RMT.int_ena.val & (RMT_INT_TX_END_BIT | RMT_INT_THR_EVNT_BIT))); }
 
-    void IRAM_ATTR ISR_Handler ();
+    void IRAM_ATTR ISR_Handler (uint32_t int_st);
    
 // #define USE_RMT_DEBUG_COUNTERS
 #ifdef USE_RMT_DEBUG_COUNTERS
@@ -161,6 +216,9 @@ public:
    uint32_t IncompleteFrame = 0;
    uint32_t IncompleteFrameLastFrame = 0;
    uint32_t BitTypeCounters[RmtDataBitIdType_t::RMT_NUM_BIT_TYPES];
+   uint32_t IsrSendCycles = 0;
+   uint32_t IsrSendIntensityValues = 0;
+   uint32_t IsrCyclesPerIntensityValue = 0;
 #endif // def USE_RMT_DEBUG_COUNTERS
 };
 #endif // def #ifdef SUPPORT_RMT_OUTPUT
@@ -0,0 +1,147 @@
+#pragma once
+/*
+* OutputRmtItems.hpp - Intensity to RMT item encoding
+*
+* Project: ESPixelStick - An ESP8266 / ESP32 and E1.31 based pixel driver
+* Copyright (c) 2015, 2022 Shelby Merrick
+* http://www.forkineye.com
+*
+*  This program is provided free for you to use in any way that you wish,
+*  subject to the laws and regulations where you are using it.  Due diligence
+*  is strongly suggested before using this code.  Please give credit where due.
+*
+*  The Author makes no warranty of any kind, express or implied, with regard
+*  to this program or the documentation contained in this document.  The
+*  Author shall not be liable in any event for incidental or consequential
+*  damages in connection with, or arising out of, the furnishing, performance
+*  or use of these programs.
+*
+*   Every intensity bit becomes one 32 bit RMT item, MSB first. The items
+*   are written into the channel memory, which is used as a ring from
+*   pStart to pEnd (inclusive). Item_t only needs a uint32_t member named
+*   val (rmt_item32_t on the target).
+*
+*/
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Each nibble of intensity data expands to four RMT items.
+#define RMT_ITEMS_PER_NIBBLE    4
+#define RMT_NUM_NIBBLE_VALUES   16
+
+//----------------------------------------------------------------------------
+/*
+    Expand every possible nibble value into the four RMT items that
+    represent it, MSB first.
+*/
+inline void RmtBuildNibbleTable (uint32_t OneBitValue, uint32_t ZeroBitValue, uint32_t Nibble2Rmt[][RMT_ITEMS_PER_NIBBLE])
+{
+    for (uint32_t NibbleValue = 0; NibbleValue < RMT_NUM_NIBBLE_VALUES; ++NibbleValue)
+    {
+        uint32_t ItemIndex = 0;
+        for (uint32_t bitmask = 1 << (RMT_ITEMS_PER_NIBBLE - 1); 0 != bitmask; bitmask >>= 1)
+        {
+            Nibble2Rmt[NibbleValue][ItemIndex++] = (NibbleValue & bitmask) ? OneBitValue : ZeroBitValue;
+        }
+    }
+
+} // RmtBuildNibbleTable
+
+//----------------------------------------------------------------------------
+template <typename Item_t>
+inline __attribute__((always_inline)) void RmtEnqueueItem (volatile Item_t * & pCurrent,
+                                                           volatile Item_t *   pStart,
+                                                           volatile Item_t *   pEnd,
+                                                           volatile size_t   & NumAvailableSlotsToFill,
+                                                           uint32_t            Value)
+{
+    // write the data
+    pCurrent->val = Value;
+
+    --NumAvailableSlotsToFill;
+
+    // increment address, check for address wrap around
+    if (++pCurrent > pEnd)
+    {
+        pCurrent = pStart;
+    }
+
+} // RmtEnqueueItem
+
+//----------------------------------------------------------------------------
+template <typename Item_t>
+inline __attribute__((always_inline)) void RmtEnqueueNibble (volatile Item_t * & pCurrent,
+                                                             volatile Item_t *   pStart,
+                                                             volatile Item_t *   pEnd,
+                                                             volatile size_t   & NumAvailableSlotsToFill,
+                                                             const uint32_t    * pRmtItems)
+{
+    if ((pCurrent + (RMT_ITEMS_PER_NIBBLE - 1)) <= pEnd)
+    {
+        // the whole nibble fits before the wrap point. Use word writes.
+        volatile uint32_t * pRmtMem = &pCurrent->val;
+        pRmtMem[0] = pRmtItems[0];
+        pRmtMem[1] = pRmtItems[1];
+        pRmtMem[2] = pRmtItems[2];
+        pRmtMem[3] = pRmtItems[3];
+
+        NumAvailableSlotsToFill -= RMT_ITEMS_PER_NIBBLE;
+        pCurrent += RMT_ITEMS_PER_NIBBLE;
+        if (pCurrent > pEnd)
+        {
+            pCurrent = pStart;
+        }
+    }
+    else
+    {
+        RmtEnqueueItem (pCurrent, pStart, pEnd, NumAvailableSlotsToFill, pRmtItems[0]);
+        RmtEnqueueItem (pCurrent, pStart, pEnd, NumAvailableSlotsToFill, pRmtItems[1]);
+        RmtEnqueueItem (pCurrent, pStart, pEnd, NumAvailableSlotsToFill, pRmtItems[2]);
+        RmtEnqueueItem (pCurrent, pStart, pEnd, NumAvailableSlotsToFill, pRmtItems[3]);
+    }
+
+} // RmtEnqueueNibble
+
+//----------------------------------------------------------------------------
+/*
+    One table lookup per nibble. StartingShift is the data width - 4.
+    Only valid for widths that are a whole number of nibbles.
+*/
+template <typename Item_t>
+inline __attribute__((always_inline)) void RmtEnqueueIntensityByNibble (volatile Item_t * & pCurrent,
+                                                                        volatile Item_t *   pStart,
+                                                                        volatile Item_t *   pEnd,
+                                                                        volatile size_t   & NumAvailableSlotsToFill,
+                                                                        uint32_t            IntensityValue,
+                                                                        int32_t             StartingShift,
+                                                                        const uint32_t      Nibble2Rmt[][RMT_ITEMS_PER_NIBBLE])
+{
+    for (int32_t shift = StartingShift; shift >= 0; shift -= RMT_ITEMS_PER_NIBBLE)
+    {
+        RmtEnqueueNibble (pCurrent, pStart, pEnd, NumAvailableSlotsToFill, Nibble2Rmt[(IntensityValue >> shift) & 0x0F]);
+    }
+
+} // RmtEnqueueIntensityByNibble
+
+//----------------------------------------------------------------------------
+/*
+    One test per bit. Used for intensity widths that are not a whole number
+    of nibbles (GECE). StartingMask is the mask of the first bit to send.
+*/
+template <typename Item_t>
+inline __attribute__((always_inline)) void RmtEnqueueIntensityBitByBit (volatile Item_t * & pCurrent,
+                                                                        volatile Item_t *   pStart,
+                                                                        volatile Item_t *   pEnd,
+                                                                        volatile size_t   & NumAvailableSlotsToFill,
+                                                                        uint32_t            IntensityValue,
+                                                                        uint32_t            StartingMask,
+                                                                        uint32_t            OneBitValue,
+                                                                        uint32_t            ZeroBitValue)
+{
+    for (uint32_t bitmask = StartingMask; 0 != bitmask; bitmask >>= 1)
+    {
+        RmtEnqueueItem (pCurrent, pStart, pEnd, NumAvailableSlotsToFill, (IntensityValue & bitmask) ? OneBitValue : ZeroBitValue);
+    }
+
+} // RmtEnqueueIntensityBitByBit
@@ -0,0 +1,64 @@
+#pragma once
+/*
+* OutputRoutingTable.hpp - Find the output that owns a channel
+*
+* Project: ESPixelStick - An ESP8266 / ESP32 and E1.31 based pixel driver
+* Copyright (c) 2021, 2022 Shelby Merrick
+* http://www.forkineye.com
+*
+*  This program is provided free for you to use in any way that you wish,
+*  subject to the laws and regulations where you are using it.  Due diligence
+*  is strongly suggested before using this code.  Please give credit where due.
+*
+*  The Author makes no warranty of any kind, express or implied, with regard
+*  to this program or the documentation contained in this document.  The
+*  Author shall not be liable in any event for incidental or consequential
+*  damages in connection with, or arising out of, the furnishing, performance
+*  or use of these programs.
+*
+*   The routing table holds the outputs that own at least one channel,
+*   sorted by starting channel. Each entry must provide StartingChannelId
+*   and EndChannelId.
+*
+*/
+
+#include <stddef.h>
+
+//----------------------------------------------------------------------------
+/*
+    Find the entry that owns ChannelId. Index holds the entry used by the
+    previous write on entry since writes usually continue in the same
+    output. A binary search is only done when that entry does not match.
+    Returns true when the previous entry was reused. Caller must make sure
+    ChannelId is inside the table.
+*/
+template <typename Entry_t>
+inline bool RoutingTableFind (Entry_t * const * RoutingTable, size_t RoutingTableSize, size_t ChannelId, size_t & Index)
+{
+    if ((Index < RoutingTableSize) &&
+        (ChannelId >= RoutingTable[Index]->StartingChannelId) &&
+        (ChannelId <  RoutingTable[Index]->EndChannelId))
+    {
+        return true;
+    }
+
+    // last entry whose starting channel is not above ChannelId
+    size_t Low  = 0;
+    size_t High = RoutingTableSize;
+    while ((Low + 1) < High)
+    {
+        size_t Middle = (Low + High) / 2;
+        if (RoutingTable[Middle]->StartingChannelId <= ChannelId)
+        {
+            Low = Middle;
+        }
+        else
+        {
+            High = Middle;
+        }
+    }
+
+    Index = Low;
+    return false;
+
+} // RoutingTableFind
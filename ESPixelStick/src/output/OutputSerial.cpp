@@ -82,11 +82,12 @@ void c_OutputSerial::GetStatus (ArduinoJson::JsonObject& jsonStatus)
     // DEBUG_START;
 
     c_OutputCommon::GetStatus (jsonStatus);
+    jsonStatus[F("EncodedFrameSize")] = EncodedFrameSize;
 
 #ifdef USE_SERIAL_DEBUG_COUNTERS
     JsonObject debugStatus = jsonStatus.createNestedObject("Serial Debug");
     debugStatus["Num_Channels"]                = Num_Channels;
-    debugStatus["NextIntensityToSend"]         = String(int(NextIntensityToSend), HEX);
+    debugStatus["NextByteToSend"]              = String(int(pNextByteToSend), HEX);
     debugStatus["IntensityBytesSent"]          = IntensityBytesSent;
     debugStatus["IntensityBytesSentLastFrame"] = IntensityBytesSentLastFrame;
     debugStatus["FrameStartCounter"]           = FrameStartCounter;
@@ -278,11 +279,10 @@ void c_OutputSerial::StartNewFrame ()
     FrameStartCounter++;
 #endif // def USE_SERIAL_DEBUG_COUNTERS
 
-    NextIntensityToSend = GetBufferAddress();
-    intensity_count     = Num_Channels;
-    SentIntensityCount  = 0;
-    SerialHeaderIndex   = 0;
-    SerialFooterIndex   = 0;
+    // this frame carries every change marked so far
+    RefreshStarted ();
+    LatchFrame();
+    EncodeFrame();
 
 #ifdef USE_SERIAL_DEBUG_COUNTERS
     IntensityBytesSentLastFrame = IntensityBytesSent;
@@ -290,13 +290,35 @@ void c_OutputSerial::StartNewFrame ()
     // IntensityBytesSentLastFrame = 0;
 #endif // def USE_SERIAL_DEBUG_COUNTERS
 
-    // start the next frame
+    ReportNewFrame();
+
+    // DEBUG_END;
+
+} // StartNewFrame
+
+//----------------------------------------------------------------------------
+/*
+    Build the complete wire image of the frame in task context: the DMX
+    start code, the Renard sync / command bytes with every escaped value
+    already expanded, or the generic serial header and footer. The ISR then
+    streams TxBuffer without looking at the data.
+*/
+void c_OutputSerial::EncodeFrame ()
+{
+    // DEBUG_START;
+
+    const uint8_t * pInput    = GetBufferAddress();
+    const uint8_t * pInputEnd = pInput + Num_Channels;
+    uint8_t       * pOutput   = TxBuffer;
+
     switch (OutputType)
     {
 #ifdef SUPPORT_OutputType_DMX
         case c_OutputMgr::e_OutputType::OutputType_DMX:
         {
-            SerialFrameState = SerialFrameState_t::DMXSendFrameStart;
+            *pOutput++ = DMX_START_CODE;
+            memcpy(pOutput, pInput, Num_Channels);
+            pOutput += Num_Channels;
             break;
         }  // DMX512
 #endif // def SUPPORT_OutputType_DMX
@@ -304,7 +326,22 @@ void c_OutputSerial::StartNewFrame ()
 #ifdef SUPPORT_OutputType_Renard
         case c_OutputMgr::e_OutputType::OutputType_Renard:
         {
-            SerialFrameState = SerialFrameState_t::RenardFrameStart;
+            *pOutput++ = RenardFrameDefinitions_t::FRAME_START_CHAR;
+            *pOutput++ = RenardFrameDefinitions_t::CMD_DATA_START;
+
+            while (pInput < pInputEnd)
+            {
+                uint8_t data = *pInput++;
+                // do we have to adjust the renard data stream?
+                if ((data >= RenardFrameDefinitions_t::MIN_VAL_TO_ESC) &&
+                    (data <= RenardFrameDefinitions_t::MAX_VAL_TO_ESC))
+                {
+                    // Send a two byte substitute for the value
+                    *pOutput++ = RenardFrameDefinitions_t::ESC_CHAR;
+                    data -= uint8_t(RenardFrameDefinitions_t::ESCAPED_OFFSET);
+                }
+                *pOutput++ = data;
+            }
             break;
         }  // RENARD
 #endif // def SUPPORT_OutputType_Renard
@@ -312,7 +349,13 @@ void c_OutputSerial::StartNewFrame ()
 #ifdef SUPPORT_OutputType_Serial
         case c_OutputMgr::e_OutputType::OutputType_Serial:
         {
-            SerialFrameState = (SerialHeaderSize) ? SerialFrameState_t::GenSerSendHeader : SerialFrameState_t::GenSerSendData;
+            memcpy(pOutput, GenericSerialHeader.c_str(), SerialHeaderSize);
+            pOutput += SerialHeaderSize;
+            memcpy(pOutput, pInput, Num_Channels);
+            pOutput += Num_Channels;
+            memcpy(pOutput, GenericSerialFooter.c_str(), SerialFooterSize);
+            pOutput += SerialFooterSize;
+            break;
         }  // GENERIC
 #endif // def SUPPORT_OutputType_Serial
 
@@ -323,159 +366,53 @@ void c_OutputSerial::StartNewFrame ()
 
     } // end switch (OutputType)
 
-    ReportNewFrame();
+    EncodedFrameSize   = size_t(pOutput - TxBuffer);
+    pNextByteToSend    = TxBuffer;
+    pEndOfEncodedFrame = pOutput;
+
+    // DEBUG_V (String ("EncodedFrameSize: ") + String (EncodedFrameSize));
 
     // DEBUG_END;
 
-} // StartNewFrame
+} // EncodeFrame
 
 //----------------------------------------------------------------------------
 uint32_t IRAM_ATTR c_OutputSerial::ISR_GetNextIntensityToSend ()
 {
-    uint32_t data = 0x00;
-
 #ifdef USE_SERIAL_DEBUG_COUNTERS
     IntensityBytesSent++;
-#endif // def USE_SERIAL_DEBUG_COUNTERS
-
-    switch (SerialFrameState)
+    if ((pNextByteToSend + 1) == pEndOfEncodedFrame)
     {
-        case SerialFrameState_t::RenardFrameStart:
-        {
-            data = RenardFrameDefinitions_t::FRAME_START_CHAR;
-            SerialFrameState = SerialFrameState_t::RenardDataStart;
-            break;
-        }
-
-        case SerialFrameState_t::RenardDataStart:
-        {
-            data = RenardFrameDefinitions_t::CMD_DATA_START;
-            SerialFrameState = SerialFrameState_t::RenardSendData;
-            break;
-        }
-
-        case SerialFrameState_t::RenardSendData:
-        {
-            data = *NextIntensityToSend;
-            // do we have to adjust the renard data stream?
-            if ((data >= RenardFrameDefinitions_t::MIN_VAL_TO_ESC) &&
-                (data <= RenardFrameDefinitions_t::MAX_VAL_TO_ESC))
-            {
-                // Send a two byte substitute for the value
-                data = RenardFrameDefinitions_t::ESC_CHAR;
-                SerialFrameState = SerialFrameState_t::RenardSendEscapedData;
-
-            } // end modified data
-            else
-            {
-                ++NextIntensityToSend;
-                if (0 == --intensity_count)
-                {
-                    SerialFrameState = SerialFrameState_t::SerialIdle;
-#ifdef USE_SERIAL_DEBUG_COUNTERS
-                    ++FrameEndCounter;
-#endif // def USE_SERIAL_DEBUG_COUNTERS
-                }
-            }
-
-            break;
-        }
-
-        case SerialFrameState_t::RenardSendEscapedData:
-        {
-            data = *NextIntensityToSend - uint8_t(RenardFrameDefinitions_t::ESCAPED_OFFSET);
-            ++NextIntensityToSend;           
-            if (0 == --intensity_count)
-            {
-                SerialFrameState = SerialFrameState_t::SerialIdle;
-#ifdef USE_SERIAL_DEBUG_COUNTERS
-                ++FrameEndCounter;
+        ++FrameEndCounter;
+    }
 #endif // def USE_SERIAL_DEBUG_COUNTERS
-            }
-            else
-            {
-                SerialFrameState = SerialFrameState_t::RenardSendData;
-            }
-            break;
-        }
 
-        case SerialFrameState_t::DMXSendFrameStart:
-        {
-            data = 0x00; // DMX Lighting frame start
-            SerialFrameState = SerialFrameState_t::DMXSendData;
-            break;
-        }
+    return *pNextByteToSend++;
 
-        case SerialFrameState_t::DMXSendData:
-        {
-            data = *NextIntensityToSend++;
-            if (0 == --intensity_count)
-            {
-                SerialFrameState = SerialFrameState_t::SerialIdle;
-#ifdef USE_SERIAL_DEBUG_COUNTERS
-                ++FrameEndCounter;
-#endif // def USE_SERIAL_DEBUG_COUNTERS
-            }
-            break;
-        }
+} // ISR_GetNextIntensityToSend
 
-        case SerialFrameState_t::GenSerSendHeader:
-        {
-            data = GenericSerialHeader[SerialHeaderIndex++];
-            if (SerialHeaderSize <= SerialHeaderIndex)
-            {
-                SerialFrameState = SerialFrameState_t::GenSerSendData;
-            }
-            break;
-        }
+//----------------------------------------------------------------------------
+/*
+    Hand out up to MaxLength bytes of the encoded frame in one piece.
+    Returns the number of bytes at *ppData.
+*/
+size_t IRAM_ATTR c_OutputSerial::ISR_GetNextBlockToSend (const uint8_t ** ppData, size_t MaxLength)
+{
+    size_t NumBytes = min(MaxLength, size_t(pEndOfEncodedFrame - pNextByteToSend));
 
-        case SerialFrameState_t::GenSerSendData:
-        {
-            data = *NextIntensityToSend++;
-            if (0 == --intensity_count)
-            {
-                if (SerialFooterSize)
-                {
-                    SerialFrameState = SerialFrameState_t::GenSerSendFooter;
-                }
-                else
-                {
-                    SerialFrameState = SerialFrameState_t::SerialIdle;
-#ifdef USE_SERIAL_DEBUG_COUNTERS
-                    ++FrameEndCounter;
-#endif // def USE_SERIAL_DEBUG_COUNTERS
-                }
-            }
-            break;
-        }
+    *ppData          = pNextByteToSend;
+    pNextByteToSend += NumBytes;
 
-        case SerialFrameState_t::GenSerSendFooter:
-        {
-            data = GenericSerialFooter[SerialFooterIndex++];
-            if (SerialFooterSize <= SerialFooterIndex)
-            {
-                SerialFrameState = SerialFrameState_t::SerialIdle;
 #ifdef USE_SERIAL_DEBUG_COUNTERS
-                ++FrameEndCounter;
+    IntensityBytesSent += NumBytes;
+    if (NumBytes && (pNextByteToSend == pEndOfEncodedFrame))
+    {
+        ++FrameEndCounter;
+    }
 #endif // def USE_SERIAL_DEBUG_COUNTERS
-            }
-            break;
-        }
 
-        case SerialFrameState_t::SerialIdle:
-        default:
-        {
-            break;
-        }
-    } // switch SerialFrameState
+    return NumBytes;
 
-/*
-    if (InvertData)
-    {
-        response = ~response;
-    }
-*/
-    return data;
-} // NextIntensityToSend
+} // ISR_GetNextBlockToSend
 
 #endif // defined(SUPPORT_OutputType_DMX) || defined(SUPPORT_OutputType_Serial) || defined(SUPPORT_OutputType_Renard)
@@ -47,7 +47,9 @@ public:
             void   StartNewFrame();
             
     uint32_t IRAM_ATTR   ISR_GetNextIntensityToSend();
-    bool     IRAM_ATTR   ISR_MoreDataToSend() { return (SerialFrameState_t::SerialIdle != SerialFrameState); }
+    size_t   IRAM_ATTR   ISR_GetNextBlockToSend(const uint8_t ** ppData, size_t MaxLength);
+    bool     IRAM_ATTR   ISR_MoreDataToSend() { return (pNextByteToSend < pEndOfEncodedFrame); }
+            size_t GetEncodedFrameSize () { return EncodedFrameSize; }
 
 protected:
     void SetFrameDurration();
@@ -71,31 +73,33 @@ protected:
 
 private:
 
+#define SERIAL_MAX_CHANNELS     1024
+#define SERIAL_TX_BUFFER_SIZE   (2 + (2 * SERIAL_MAX_CHANNELS))    // Renard frame with every value escaped
+
     const size_t    MAX_HDR_SIZE         = 10;      // Max generic serial header size
     const size_t    MAX_FOOTER_SIZE      = 10;      // max generic serial footer size
-    const size_t    MAX_CHANNELS         = 1024;
+    const size_t    MAX_CHANNELS         = SERIAL_MAX_CHANNELS;
     const uint16_t  DEFAULT_NUM_CHANNELS = 64;
-    const size_t    BUF_SIZE             = (MAX_CHANNELS + MAX_HDR_SIZE + MAX_FOOTER_SIZE);
     const uint32_t  DMX_BITS_PER_BYTE    = (1.0 + 8.0 + 2.0);
     const size_t    DMX_MaxFrameSize     = 512;
     
 
     size_t      Num_Channels = DEFAULT_NUM_CHANNELS;       // Number of data channels to transmit
 
-    uint8_t*    NextIntensityToSend = nullptr;
-    size_t      intensity_count = 0;
-    size_t      SentIntensityCount = 0;
+    // The whole frame is encoded at frame start. The ISR only copies bytes.
+    uint8_t         TxBuffer[SERIAL_TX_BUFFER_SIZE];
+    const uint8_t * pNextByteToSend    = TxBuffer;
+    const uint8_t * pEndOfEncodedFrame = TxBuffer;
+    size_t          EncodedFrameSize   = 0;
 
     float       IntensityBitTimeInUs = 0.0;
     size_t      NumBitsPerIntensity = 1 + 8 + 2;   // Start. 8 Data, Stop
 
     String      GenericSerialHeader;
     size_t      SerialHeaderSize  = 0;
-    size_t      SerialHeaderIndex = 0;
 
     String      GenericSerialFooter;
     size_t      SerialFooterSize  = 0;
-    size_t      SerialFooterIndex = 0;
 
 // #define USE_SERIAL_DEBUG_COUNTERS
 #ifdef USE_SERIAL_DEBUG_COUNTERS
@@ -107,6 +111,7 @@ private:
 #endif // def USE_SERIAL_DEBUG_COUNTERS
 
     bool validate ();        ///< confirm that the current configuration is valid
+    void EncodeFrame ();     ///< build the bytes for the whole frame in TxBuffer
 
     enum RenardFrameDefinitions_t
     {
@@ -119,20 +124,7 @@ private:
         MAX_VAL_TO_ESC   = ESC_CHAR
     };
 
-    enum SerialFrameState_t
-    {
-        RenardFrameStart,
-        RenardDataStart,
-        RenardSendData,
-        RenardSendEscapedData,
-        DMXSendFrameStart,
-        DMXSendData,
-        GenSerSendHeader,
-        GenSerSendData,
-        GenSerSendFooter,
-        SerialIdle
-    };
-    SerialFrameState_t SerialFrameState = SerialIdle;
+#define DMX_START_CODE  0x00    // DMX Lighting frame start
 
 }; // c_OutputSerial
 
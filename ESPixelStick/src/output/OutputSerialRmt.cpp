@@ -83,7 +83,7 @@ bool c_OutputSerialRmt::SetConfig (ArduinoJson::JsonObject& jsonConfig)
     SetUpRmtBitTimes();
 
     Rmt.set_pin (DataPin);
-    Rmt.SetMinFrameDurationInUs(FrameMinDurationInMicroSec);
+    Rmt.SetMinFrameDurationInUs (GetFrameDurationInMicroSec ());
 
     // DEBUG_END;
     return response;
@@ -177,7 +177,7 @@ void c_OutputSerialRmt::SetOutputBufferSize(uint16_t NumChannelsAvailable)
     // DEBUG_START;
 
     c_OutputSerial::SetOutputBufferSize (NumChannelsAvailable);
-    Rmt.SetMinFrameDurationInUs (FrameMinDurationInMicroSec);
+    Rmt.SetMinFrameDurationInUs (GetFrameDurationInMicroSec ());
 
     // DEBUG_END;
 
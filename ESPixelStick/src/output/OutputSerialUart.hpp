@@ -45,6 +45,7 @@ public:
     virtual void    GetConfig(ArduinoJson::JsonObject &jsonConfig); ///< Set a new config in the driver
     virtual void    GetStatus(ArduinoJson::JsonObject &jsonStatus);
     void            Render();
+    void            PauseOutput (bool State) override {c_OutputSerial::PauseOutput (State); Uart.PauseOutput (State);}
 
 private:
     c_OutputUart Uart;
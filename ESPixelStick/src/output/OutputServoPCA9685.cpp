@@ -43,6 +43,14 @@ c_OutputServoPCA9685::c_OutputServoPCA9685 (c_OutputMgr::e_OutputChannelIds Outp
         currentServoPCA9685Channel.Is16Bit          = false;
         currentServoPCA9685Channel.IsScaled         = true;
         currentServoPCA9685Channel.HomeValue        = 0;
+        currentServoPCA9685Channel.VelocityLimit    = 0;
+    }
+
+    uint8_t Address = SERVO_PCA9685_BASE_ADDRESS;
+    for (ServoPCA9685Board_t & CurrentBoard : Boards)
+    {
+        CurrentBoard.Address = Address++;
+        memset (CurrentBoard.RegisterImage, 0x00, sizeof (CurrentBoard.RegisterImage));
     }
 
     // DEBUG_END;
@@ -53,10 +61,14 @@ c_OutputServoPCA9685::~c_OutputServoPCA9685 ()
 {
     // DEBUG_START;
 
-    if(nullptr != pwm)
+    for (ServoPCA9685Board_t & CurrentBoard : Boards)
     {
-        // DEBUG_V();
-        delete pwm;
+        if (nullptr != CurrentBoard.pwm)
+        {
+            // DEBUG_V();
+            delete CurrentBoard.pwm;
+            CurrentBoard.pwm = nullptr;
+        }
     }
 
     // DEBUG_END;
@@ -69,13 +81,9 @@ void c_OutputServoPCA9685::Begin ()
 
     if(!HasBeenInitialized)
     {
-        // DEBUG_V("Allocate PWM");
-        pwm = new Adafruit_PWMServoDriver();
-
         SetOutputBufferSize(Num_Channels);
 
-        pwm->begin();
-        pwm->setPWMFreq(UpdateFrequency);
+        UpdateBoards ();
 
         validate();
 
@@ -85,6 +93,48 @@ void c_OutputServoPCA9685::Begin ()
     // DEBUG_END;
 } // Begin
 
+//----------------------------------------------------------------------------
+/*
+    Create a driver for each configured board and remove the rest. The
+    boards share the bus so the clock is set after all of them have
+    started the Wire interface.
+*/
+void c_OutputServoPCA9685::UpdateBoards ()
+{
+    // DEBUG_START;
+
+    uint8_t BoardId = 0;
+    for (ServoPCA9685Board_t & CurrentBoard : Boards)
+    {
+        if ((BoardId < NumBoards) && (nullptr == CurrentBoard.pwm))
+        {
+            // DEBUG_V (String ("Allocate PWM at 0x") + String (CurrentBoard.Address, HEX));
+            CurrentBoard.pwm = new Adafruit_PWMServoDriver (CurrentBoard.Address);
+            CurrentBoard.pwm->begin ();
+        }
+        else if ((BoardId >= NumBoards) && (nullptr != CurrentBoard.pwm))
+        {
+            delete CurrentBoard.pwm;
+            CurrentBoard.pwm = nullptr;
+        }
+
+        if (nullptr != CurrentBoard.pwm)
+        {
+            // also turns on register auto increment (MODE1 AI)
+            CurrentBoard.pwm->setPWMFreq (UpdateFrequency);
+        }
+
+        // nothing to write until the next frame
+        CurrentBoard.FirstDirtyChannel = SERVO_PCA9685_CHANNELS_PER_BOARD;
+        CurrentBoard.LastDirtyChannel  = 0;
+        ++BoardId;
+    }
+
+    Wire.setClock (SERVO_PCA9685_I2C_CLOCK_HZ);
+
+    // DEBUG_END;
+} // UpdateBoards
+
 #ifdef UseCustomClearBuffer
 //-----------------------------------------------------------------------------
 void c_OutputServoPCA9685::ClearBuffer ()
@@ -94,9 +144,10 @@ void c_OutputServoPCA9685::ClearBuffer ()
     // memset(GetBufferAddress(), 0x00, GetBufferUsedSize());
     for (ServoPCA9685Channel_t & currentServoPCA9685Channel : OutputList)
     {
-        GetBufferAddress()[currentServoPCA9685Channel.Id] = 
+        pBackBuffer[currentServoPCA9685Channel.Id] = 
             currentServoPCA9685Channel.HomeValue;
     }
+    MarkAllDataChanged ();
 
     // DEBUG_END;
 } // ClearBuffer
@@ -108,25 +159,43 @@ bool c_OutputServoPCA9685::validate ()
     // DEBUG_START;
     bool response = true;
 
-    if ((Num_Channels > OM_SERVO_PCA9685_CHANNEL_LIMIT) || (Num_Channels < 1))
+    if ((NumBoards > SERVO_PCA9685_MAX_BOARDS) || (NumBoards < 1))
     {
-        logcon (CN_stars + String (F (" Requested channel count was not valid. Setting to ")) + OM_SERVO_PCA9685_CHANNEL_LIMIT + " " + CN_stars);
-        Num_Channels = OM_SERVO_PCA9685_CHANNEL_LIMIT;
+        logcon (CN_stars + String (F (" Requested board count was not valid. Setting to 1 ")) + CN_stars);
+        NumBoards = 1;
         response = false;
     }
 
-    if (Num_Channels < OM_SERVO_PCA9685_CHANNEL_LIMIT)
+    Num_Channels = NumBoards * SERVO_PCA9685_CHANNELS_PER_BOARD;
+
+    // channels on boards that are not configured
+    for (int ChannelIndex = OM_SERVO_PCA9685_CHANNEL_LIMIT - 1; ChannelIndex >= Num_Channels; ChannelIndex--)
     {
-        logcon (CN_stars + String (F (" Requested channel count was not valid. Insuficient number of input channels avaialable ")) + CN_stars);
+        OutputList[ChannelIndex].Enabled = false;
+    }
 
-        for (int ChannelIndex = OM_SERVO_PCA9685_CHANNEL_LIMIT - 1; ChannelIndex > Num_Channels; ChannelIndex--)
-        {
-            logcon (CN_stars + String (F (" Disabling channel '")) + String (ChannelIndex + 1) + "' " + CN_stars);
-            OutputList[ChannelIndex].Enabled = false;
-        }
+    if (Smoothing >= SmoothingEnd)
+    {
+        logcon (CN_stars + String (F (" Requested smoothing mode was not valid. Turning smoothing off ")) + CN_stars);
+        Smoothing = SmoothingOff;
+        response = false;
+    }
 
+    if ((StepRate < SERVO_PCA9685_STEP_RATE_MIN) || (StepRate > SERVO_PCA9685_STEP_RATE_MAX))
+    {
+        logcon (CN_stars + String (F (" Requested step rate was not valid. Setting to ")) + SERVO_PCA9685_STEP_RATE_DEFAULT + F (" Hz ") + CN_stars);
+        StepRate = SERVO_PCA9685_STEP_RATE_DEFAULT;
         response = false;
     }
+    StepPeriodUs = MicroSecondsInASecond / StepRate;
+
+    // the next frame sets new targets with the new settings
+    for (ServoPCA9685Channel_t & currentServoPCA9685 : OutputList)
+    {
+        currentServoPCA9685.Moving   = false;
+        currentServoPCA9685.Velocity = 0.0;
+    }
+    NumMovingServos = 0;
 
     SetOutputBufferSize (Num_Channels);
 
@@ -161,7 +230,15 @@ bool c_OutputServoPCA9685::SetConfig (ArduinoJson::JsonObject & jsonConfig)
 
         // PrettyPrint (jsonConfig, String("c_OutputServoPCA9685::SetConfig"));
         setFromJSON (UpdateFrequency, jsonConfig, OM_SERVO_PCA9685_UPDATE_INTERVAL_NAME);
-        pwm->setPWMFreq (UpdateFrequency);
+        setFromJSON (KeepAliveIntervalMs, jsonConfig, CN_keepalive);
+        setFromJSON (NumBoards, jsonConfig, OM_SERVO_PCA9685_BOARDS_NAME);
+        setFromJSON (Smoothing, jsonConfig, OM_SERVO_PCA9685_SMOOTHING_NAME);
+        setFromJSON (StepRate,  jsonConfig, OM_SERVO_PCA9685_STEP_RATE_NAME);
+        NumBoards = max (uint8_t (1), min (uint8_t (SERVO_PCA9685_MAX_BOARDS), NumBoards));
+        UpdateBoards ();
+
+        // apply the new settings to every channel on the next render
+        MarkAllDataChanged ();
 
         // do we have a channel configuration array?
         if (false == jsonConfig.containsKey (OM_SERVO_PCA9685_CHANNELS_NAME))
@@ -194,6 +271,7 @@ bool c_OutputServoPCA9685::SetConfig (ArduinoJson::JsonObject & jsonConfig)
             setFromJSON (CurrentOutputChannel->Is16Bit,    JsonChannelData, OM_SERVO_PCA9685_CHANNEL_16BITS);
             setFromJSON (CurrentOutputChannel->IsScaled,   JsonChannelData, OM_SERVO_PCA9685_CHANNEL_SCALED);
             setFromJSON (CurrentOutputChannel->HomeValue,  JsonChannelData, OM_SERVO_PCA9685_CHANNEL_HOME);
+            setFromJSON (CurrentOutputChannel->VelocityLimit, JsonChannelData, OM_SERVO_PCA9685_CHANNEL_VELOCITY_LIMIT);
 
             // DEBUG_V (String ("ChannelId: ") + String (ChannelId));
             // DEBUG_V (String ("  Enabled: ") + String (CurrentOutputChannel->Enabled));
@@ -219,12 +297,21 @@ void c_OutputServoPCA9685::GetConfig (ArduinoJson::JsonObject & jsonConfig)
     // DEBUG_START;
 
     jsonConfig[OM_SERVO_PCA9685_UPDATE_INTERVAL_NAME] = UpdateFrequency;
+    jsonConfig[CN_keepalive] = KeepAliveIntervalMs;
+    jsonConfig[OM_SERVO_PCA9685_BOARDS_NAME] = NumBoards;
+    jsonConfig[OM_SERVO_PCA9685_SMOOTHING_NAME] = Smoothing;
+    jsonConfig[OM_SERVO_PCA9685_STEP_RATE_NAME] = StepRate;
 
     JsonArray JsonChannelList = jsonConfig.createNestedArray (OM_SERVO_PCA9685_CHANNELS_NAME);
 
     uint8_t ChannelId = 0;
     for (ServoPCA9685Channel_t & currentServoPCA9685 : OutputList)
     {
+        if (ChannelId >= Num_Channels)
+        {
+            break;
+        }
+
         JsonObject JsonChannelData = JsonChannelList.createNestedObject ();
 
         JsonChannelData[OM_SERVO_PCA9685_CHANNEL_ID_NAME]       = ChannelId;
@@ -235,6 +322,7 @@ void c_OutputServoPCA9685::GetConfig (ArduinoJson::JsonObject & jsonConfig)
         JsonChannelData[OM_SERVO_PCA9685_CHANNEL_16BITS]        = currentServoPCA9685.Is16Bit;
         JsonChannelData[OM_SERVO_PCA9685_CHANNEL_SCALED]        = currentServoPCA9685.IsScaled;
         JsonChannelData[OM_SERVO_PCA9685_CHANNEL_HOME]          = currentServoPCA9685.HomeValue;
+        JsonChannelData[OM_SERVO_PCA9685_CHANNEL_VELOCITY_LIMIT] = currentServoPCA9685.VelocityLimit;
 
         // DEBUG_V (String ("ChannelId: ") + String (ChannelId));
         // DEBUG_V (String ("  Enabled: ") + String (currentServoPCA9685.Enabled));
@@ -263,13 +351,45 @@ void c_OutputServoPCA9685::Render ()
     // DEBUG_START;
 
     uint8_t OutputDataIndex = 0;
+    size_t  StartChannelId;
+    size_t  EndChannelId;
+
+    LatchFrame ();
+
+    // nothing changed and the keep alive has not expired
+    if (!RefreshNeeded (StartChannelId, EndChannelId))
+    {
+        // keep moving toward the last targets and finish sending the last frame
+        StepServos ();
+        FlushRegisterImages ();
+        return;
+    }
     ReportNewFrame ();
 
+    if (!FrameLatencyPending)
+    {
+        FrameLatchTimeUs    = micros ();
+        FrameLatencyPending = true;
+    }
+
+    // a full buffer refresh rewrites every channel
+    bool ForceUpdate = (0 == StartChannelId) && (OutputBufferSize == EndChannelId);
+    bool NewTargets  = false;
+
     for (ServoPCA9685Channel_t & currentServoPCA9685 : OutputList)
     {
+        if (OutputDataIndex >= Num_Channels)
+        {
+            break;
+        }
+
         // DEBUG_V (String("OutputDataIndex: ") + String(OutputDataIndex));
         // DEBUG_V (String ("       Enabled: ") + String (currentServoPCA9685.Enabled));
-        if (currentServoPCA9685.Enabled)
+        size_t FirstByte = (currentServoPCA9685.Is16Bit) ? (OutputDataIndex * 2) : OutputDataIndex;
+        size_t LastByte  = (currentServoPCA9685.Is16Bit) ? (FirstByte + 1) : FirstByte;
+        bool   IsDirty   = (FirstByte < EndChannelId) && (LastByte >= StartChannelId);
+
+        if (currentServoPCA9685.Enabled && IsDirty)
         {
             uint16_t MaxScaledValue = 255;
             uint16_t MinScaledValue = 0;
@@ -291,7 +411,7 @@ void c_OutputServoPCA9685::Render ()
             // DEBUG_V (String ("newOutputValue: ") + String (newOutputValue));
             // DEBUG_V (String (" PreviousValue: ") + String (currentServoPCA9685.PreviousValue));
 
-            if (newOutputValue != currentServoPCA9685.PreviousValue)
+            if (ForceUpdate || (newOutputValue != currentServoPCA9685.PreviousValue))
             {
                 // DEBUG_V (String ("ChannelId: ") + String (OutputDataIndex));
                 // DEBUG_V (String (" MinLevel: ") + String (currentServoPCA9685.MinLevel));
@@ -324,13 +444,300 @@ void c_OutputServoPCA9685::Render ()
                     // DEBUG_V (String ("pulse_width: ") + String (pulse_width));
                     // DEBUG_V (String ("Final_value: ") + String (Final_value));
                 }
-                pwm->setPWM (OutputDataIndex, 0, Final_value);
+                NewTargets |= SetServoTarget (OutputDataIndex, Final_value, ForceUpdate);
             }
         }
         ++OutputDataIndex;
     }
 
+    if (NewTargets)
+    {
+        // each move takes as long as the show took to send this target
+        uint32_t Now    = micros ();
+        FrameIntervalUs = max (StepPeriodUs, min (Now - LastTargetUs, uint32_t (SERVO_PCA9685_MAX_MOVE_TIME_US)));
+        LastTargetUs    = Now;
+        MoveStartUs     = Now;
+
+        // servos still on their way cover the rest of the distance in the new interval
+        for (ServoPCA9685Channel_t & currentServoPCA9685 : OutputList)
+        {
+            currentServoPCA9685.StartPosition = currentServoPCA9685.Position;
+        }
+    }
+
+    StepServos ();
+    FlushRegisterImages ();
+
     // DEBUG_END;
 } // render
 
+//----------------------------------------------------------------------------
+/*
+    Hand a new pulse width to a channel. Without smoothing (or for the first
+    value after boot) the register image is updated right away. Otherwise
+    the channel starts moving from where it is now and StepServos takes it
+    to the target.
+
+    returns
+        true - the channel started a new move
+*/
+bool c_OutputServoPCA9685::SetServoTarget (uint8_t ChannelId, uint16_t Ticks, bool ForceUpdate)
+{
+    // DEBUG_START;
+
+    ServoPCA9685Channel_t & currentServoPCA9685 = OutputList[ChannelId];
+    bool response = false;
+
+    do // once
+    {
+        if ((SmoothingOff == Smoothing) || !currentServoPCA9685.PositionValid)
+        {
+            if (currentServoPCA9685.Moving)
+            {
+                currentServoPCA9685.Moving = false;
+                --NumMovingServos;
+            }
+            currentServoPCA9685.PositionValid = true;
+            currentServoPCA9685.TargetTicks   = Ticks;
+            currentServoPCA9685.WrittenTicks  = Ticks;
+            currentServoPCA9685.Position      = Ticks;
+            currentServoPCA9685.Velocity      = 0.0;
+            SetChannelPwm (ChannelId, Ticks);
+            break;
+        }
+
+        // a new target or a servo that was stopped short of its target
+        if ((Ticks != currentServoPCA9685.TargetTicks) || (!currentServoPCA9685.Moving && (Ticks != currentServoPCA9685.WrittenTicks)))
+        {
+            if (0 == NumMovingServos)
+            {
+                // the first step measures its time from here
+                LastStepUs = micros ();
+            }
+
+            if (!currentServoPCA9685.Moving)
+            {
+                currentServoPCA9685.Moving = true;
+                ++NumMovingServos;
+            }
+            currentServoPCA9685.TargetTicks   = Ticks;
+            response = true;
+            break;
+        }
+
+        if (ForceUpdate)
+        {
+            SetChannelPwm (ChannelId, currentServoPCA9685.WrittenTicks);
+        }
+
+    } while (false);
+
+    // DEBUG_END;
+    return response;
+
+} // SetServoTarget
+
+//----------------------------------------------------------------------------
+/*
+    Move every servo that has not reached its target one step closer. Runs
+    at StepRate. Idle servos are skipped and a servo whose rounded position
+    did not change is not written, so they cost no I2C traffic.
+
+    The damped mode uses the closed form critically damped spring from Game
+    Programming Gems 4 (1.10). It stays stable for any step size.
+*/
+void c_OutputServoPCA9685::StepServos ()
+{
+    // DEBUG_START;
+
+    do // once
+    {
+        uint32_t Now = micros ();
+        if ((0 == NumMovingServos) || ((Now - LastStepUs) < StepPeriodUs))
+        {
+            break;
+        }
+
+        float DeltaT     = float (Now - LastStepUs) / float (MicroSecondsInASecond);
+        LastStepUs       = Now;
+        ++StepCount;
+
+        float TicksPerUs = (UpdateFrequency * 4096.0) / float (MicroSecondsInASecond);
+        float Fraction   = min (1.0f, float (Now - MoveStartUs) / float (FrameIntervalUs));
+        float Omega      = (4.0 * MicroSecondsInASecond) / float (FrameIntervalUs);
+        float x          = Omega * DeltaT;
+        float Decay      = 1.0 / (1.0 + x + (0.48 * x * x) + (0.235 * x * x * x));
+
+        uint8_t ChannelId = 0;
+        for (ServoPCA9685Channel_t & currentServoPCA9685 : OutputList)
+        {
+            if (ChannelId >= Num_Channels)
+            {
+                break;
+            }
+
+            if (currentServoPCA9685.Moving)
+            {
+                float Target  = currentServoPCA9685.TargetTicks;
+                float Desired = Target;
+
+                if (SmoothingLinear == Smoothing)
+                {
+                    Desired = currentServoPCA9685.StartPosition + ((Target - currentServoPCA9685.StartPosition) * Fraction);
+                }
+                else
+                {
+                    float Change = currentServoPCA9685.Position - Target;
+                    float Temp   = (currentServoPCA9685.Velocity + (Omega * Change)) * DeltaT;
+                    currentServoPCA9685.Velocity = (currentServoPCA9685.Velocity - (Omega * Temp)) * Decay;
+                    Desired = Target + ((Change + Temp) * Decay);
+                }
+
+                if (currentServoPCA9685.VelocityLimit)
+                {
+                    float MaxVelocity = float (currentServoPCA9685.VelocityLimit) * TicksPerUs;
+                    float MaxStep     = MaxVelocity * DeltaT;
+                    Desired = max (currentServoPCA9685.Position - MaxStep, min (currentServoPCA9685.Position + MaxStep, Desired));
+                    currentServoPCA9685.Velocity = max (-MaxVelocity, min (MaxVelocity, currentServoPCA9685.Velocity));
+                }
+                currentServoPCA9685.Position = Desired;
+
+                // close enough and slow enough to stop
+                if ((fabs (Target - Desired) < 0.5) && (fabs (currentServoPCA9685.Velocity) < (0.5 * StepRate)))
+                {
+                    currentServoPCA9685.Position = Target;
+                    currentServoPCA9685.Velocity = 0.0;
+                    currentServoPCA9685.Moving   = false;
+                    --NumMovingServos;
+                }
+
+                uint16_t Ticks = uint16_t (currentServoPCA9685.Position + 0.5);
+                if (Ticks != currentServoPCA9685.WrittenTicks)
+                {
+                    currentServoPCA9685.WrittenTicks = Ticks;
+                    SetChannelPwm (ChannelId, Ticks);
+                }
+            }
+            ++ChannelId;
+        }
+
+    } while (false);
+
+    // DEBUG_END;
+} // StepServos
+
+//----------------------------------------------------------------------------
+void c_OutputServoPCA9685::SetChannelPwm (size_t ChannelId, uint16_t OffValue)
+{
+    ServoPCA9685Board_t & CurrentBoard = Boards[ChannelId / SERVO_PCA9685_CHANNELS_PER_BOARD];
+    uint8_t BoardChannelId = uint8_t (ChannelId % SERVO_PCA9685_CHANNELS_PER_BOARD);
+    uint8_t * pRegisters   = &CurrentBoard.RegisterImage[BoardChannelId * SERVO_PCA9685_BYTES_PER_CHANNEL];
+
+    // the pulse always starts at the beginning of the PWM cycle
+    pRegisters[0] = 0;
+    pRegisters[1] = 0;
+    pRegisters[2] = uint8_t (OffValue);
+    pRegisters[3] = uint8_t (OffValue >> 8);
+
+    CurrentBoard.FirstDirtyChannel = min (CurrentBoard.FirstDirtyChannel, BoardChannelId);
+    CurrentBoard.LastDirtyChannel  = max (CurrentBoard.LastDirtyChannel,  BoardChannelId);
+
+} // SetChannelPwm
+
+//----------------------------------------------------------------------------
+/*
+    Write the changed span of each register image using auto increment
+    bursts. The bus time of each burst is estimated from the I2C clock.
+    When the budget for this render is used up the remaining spans are sent
+    on the next render, starting with the board that was cut off.
+*/
+void c_OutputServoPCA9685::FlushRegisterImages ()
+{
+    // DEBUG_START;
+
+    uint32_t StartTimeUs = micros ();
+    uint32_t BudgetUs    = uint32_t ((float (MicroSecondsInASecond) * SERVO_PCA9685_BUS_BUDGET_PERCENT) / (100.0 * UpdateFrequency));
+    uint32_t UsedUs      = 0;
+    bool     OutOfTime   = false;
+
+    for (uint8_t BoardCount = 0; (BoardCount < NumBoards) && !OutOfTime; ++BoardCount)
+    {
+        uint8_t BoardId = (NextBoardToFlush + BoardCount) % NumBoards;
+        ServoPCA9685Board_t & CurrentBoard = Boards[BoardId];
+
+        while (CurrentBoard.FirstDirtyChannel <= CurrentBoard.LastDirtyChannel)
+        {
+            uint8_t FirstChannel = CurrentBoard.FirstDirtyChannel;
+            uint8_t NumChannels  = min (uint8_t (SERVO_PCA9685_CHANNELS_PER_BURST), uint8_t (CurrentBoard.LastDirtyChannel - FirstChannel + 1));
+            size_t  NumBytes     = NumChannels * SERVO_PCA9685_BYTES_PER_CHANNEL;
+
+            // address + register + data, 9 clocks per byte, plus start / stop
+            uint32_t BurstTimeUs = (((NumBytes + 2) * 9 + 2) * MicroSecondsInASecond) / SERVO_PCA9685_I2C_CLOCK_HZ;
+            if (UsedUs && ((UsedUs + BurstTimeUs) > BudgetUs))
+            {
+                NextBoardToFlush = BoardId;
+                OutOfTime = true;
+                ++DeferredFlushes;
+                break;
+            }
+
+            Wire.beginTransmission (CurrentBoard.Address);
+            Wire.write (uint8_t (SERVO_PCA9685_LED0_ON_L + (FirstChannel * SERVO_PCA9685_BYTES_PER_CHANNEL)));
+            Wire.write (&CurrentBoard.RegisterImage[FirstChannel * SERVO_PCA9685_BYTES_PER_CHANNEL], NumBytes);
+            if (0 != Wire.endTransmission ())
+            {
+                ++I2cErrors;
+            }
+
+            UsedUs       += BurstTimeUs;
+            BytesWritten += NumBytes;
+            ++BurstCount;
+
+            CurrentBoard.FirstDirtyChannel += NumChannels;
+            if (CurrentBoard.FirstDirtyChannel > CurrentBoard.LastDirtyChannel)
+            {
+                CurrentBoard.FirstDirtyChannel = SERVO_PCA9685_CHANNELS_PER_BOARD;
+                CurrentBoard.LastDirtyChannel  = 0;
+            }
+        }
+    }
+
+    if (UsedUs)
+    {
+        BusTimeUs = micros () - StartTimeUs;
+    }
+
+    if (!OutOfTime && FrameLatencyPending)
+    {
+        LatencyUs           = micros () - FrameLatchTimeUs;
+        MaxLatencyUs        = max (MaxLatencyUs, LatencyUs);
+        FrameLatencyPending = false;
+    }
+
+    // DEBUG_END;
+} // FlushRegisterImages
+
+//----------------------------------------------------------------------------
+void c_OutputServoPCA9685::GetStatus (ArduinoJson::JsonObject & jsonStatus)
+{
+    // DEBUG_START;
+
+    c_OutputCommon::GetStatus (jsonStatus);
+
+    JsonObject PcaStatus = jsonStatus.createNestedObject (F ("PCA9685"));
+    PcaStatus[F ("Boards")]          = NumBoards;
+    PcaStatus[F ("LatencyUs")]       = LatencyUs;
+    PcaStatus[F ("MaxLatencyUs")]    = MaxLatencyUs;
+    PcaStatus[F ("BusTimeUs")]       = BusTimeUs;
+    PcaStatus[F ("Bursts")]          = BurstCount;
+    PcaStatus[F ("BytesWritten")]    = BytesWritten;
+    PcaStatus[F ("DeferredFlushes")] = DeferredFlushes;
+    PcaStatus[F ("I2cErrors")]       = I2cErrors;
+    PcaStatus[F ("MovingServos")]    = NumMovingServos;
+    PcaStatus[F ("Steps")]           = StepCount;
+
+    // DEBUG_END;
+} // GetStatus
+
+
 #endif // def SUPPORT_OutputType_Servo_PCA9685
@@ -22,6 +22,7 @@ GNU General Public License for more details.
 
 #include "OutputCommon.hpp"
 #include <Adafruit_PWMServoDriver.h>
+#include <Wire.h>
 
 class c_OutputServoPCA9685 : public c_OutputCommon  
 {
@@ -40,9 +41,55 @@ private:
         bool        Is16Bit         = false;
         bool        IsScaled        = true;
         uint8_t     HomeValue       = 0;
+        uint16_t    VelocityLimit   = 0;        ///< us of pulse width per second. 0 = no limit
+
+        // motion state in PWM ticks
+        bool        PositionValid   = false;
+        bool        Moving          = false;
+        uint16_t    TargetTicks     = 0;
+        uint16_t    WrittenTicks    = 0;        ///< value in the register image
+        float       StartPosition   = 0.0;
+        float       Position        = 0.0;
+        float       Velocity        = 0.0;      ///< ticks per second
 
     } ServoPCA9685Channel_t;
 
+    enum ServoPCA9685Smoothing_t
+    {
+        SmoothingOff = 0,       ///< jump to each new frame value
+        SmoothingLinear,        ///< constant speed to the new target over one frame interval
+        SmoothingDamped,        ///< critically damped spring that settles in about one frame interval
+        SmoothingEnd
+    };
+
+#define SERVO_PCA9685_CHANNELS_PER_BOARD        16
+#define SERVO_PCA9685_MAX_BOARDS                4
+#define SERVO_PCA9685_BASE_ADDRESS              0x40    ///< board n is at 0x40 + n
+#define SERVO_PCA9685_I2C_CLOCK_HZ              400000
+#define SERVO_PCA9685_LED0_ON_L                 0x06
+#define SERVO_PCA9685_BYTES_PER_CHANNEL         4       ///< ON_L, ON_H, OFF_L, OFF_H
+#define SERVO_PCA9685_BUS_BUDGET_PERCENT        50      ///< share of the servo frame the I2C bus may use per render
+#define SERVO_PCA9685_STEP_RATE_MIN             20
+#define SERVO_PCA9685_STEP_RATE_MAX             200     ///< the output task renders at least every 5ms
+#define SERVO_PCA9685_STEP_RATE_DEFAULT         100
+#define SERVO_PCA9685_MAX_MOVE_TIME_US          500000  ///< longest move between two targets
+#ifdef ARDUINO_ARCH_ESP32
+#   define SERVO_PCA9685_CHANNELS_PER_BURST     16      ///< 128 byte Wire buffer
+#else
+#   define SERVO_PCA9685_CHANNELS_PER_BURST     7       ///< 32 byte Wire buffer
+#endif // def ARDUINO_ARCH_ESP32
+
+    // register image of one board. Only the changed span is written.
+    typedef struct ServoPCA9685Board_s
+    {
+        Adafruit_PWMServoDriver * pwm           = nullptr;
+        uint8_t     Address                     = SERVO_PCA9685_BASE_ADDRESS;
+        uint8_t     RegisterImage[SERVO_PCA9685_CHANNELS_PER_BOARD * SERVO_PCA9685_BYTES_PER_CHANNEL];
+        uint8_t     FirstDirtyChannel           = SERVO_PCA9685_CHANNELS_PER_BOARD;
+        uint8_t     LastDirtyChannel            = 0;
+
+    } ServoPCA9685Board_t;
+
 public: 
 
     // These functions are inherited from c_OutputCommon
@@ -58,12 +105,13 @@ public:
     void   GetConfig (ArduinoJson::JsonObject & jsonConfig); ///< Get the current config used by the driver
     void   Render ();                                        ///< Call from loop(),  renders output data
     void   GetDriverName (String& sDriverName);
-    void   GetStatus (ArduinoJson::JsonObject & jsonStatus) { c_OutputCommon::GetStatus (jsonStatus); }
+    void   GetStatus (ArduinoJson::JsonObject & jsonStatus);
     size_t GetNumChannelsNeeded () { return Num_Channels; }
     // void   ClearBuffer();
 
 private:
-#   define OM_SERVO_PCA9685_CHANNEL_LIMIT           16
+#   define OM_SERVO_PCA9685_CHANNEL_LIMIT           (SERVO_PCA9685_CHANNELS_PER_BOARD * SERVO_PCA9685_MAX_BOARDS)
+#   define OM_SERVO_PCA9685_BOARDS_NAME             CN_boards
 #   define OM_SERVO_PCA9685_UPDATE_INTERVAL_NAME    CN_updateinterval
 #   define OM_SERVO_PCA9685_CHANNELS_NAME           CN_channels
 #   define OM_SERVO_PCA9685_CHANNEL_ENABLED_NAME    CN_en
@@ -75,18 +123,46 @@ private:
 #   define OM_SERVO_PCA9685_CHANNEL_16BITS          CN_b16
 #   define OM_SERVO_PCA9685_CHANNEL_SCALED          CN_sca
 #   define OM_SERVO_PCA9685_CHANNEL_HOME            CN_hv
+#   define OM_SERVO_PCA9685_CHANNEL_VELOCITY_LIMIT  CN_vmax
+#   define OM_SERVO_PCA9685_SMOOTHING_NAME          CN_smoothing
+#   define OM_SERVO_PCA9685_STEP_RATE_NAME          CN_steprate
 #   define SERVO_PCA9685_UPDATE_FREQUENCY           50
 
     bool    validate ();
+    void    UpdateBoards ();
+    void    SetChannelPwm (size_t ChannelId, uint16_t OffValue);
+    void    FlushRegisterImages ();
+    bool    SetServoTarget (uint8_t ChannelId, uint16_t Ticks, bool ForceUpdate);
+    void    StepServos ();
 
     // config data
     ServoPCA9685Channel_t     OutputList[OM_SERVO_PCA9685_CHANNEL_LIMIT];
-    Adafruit_PWMServoDriver * pwm = nullptr;
+    ServoPCA9685Board_t       Boards[SERVO_PCA9685_MAX_BOARDS];
+    uint8_t                   NumBoards = 1;
     float                     UpdateFrequency = SERVO_PCA9685_UPDATE_FREQUENCY;
+    uint8_t                   Smoothing       = SmoothingOff;
+    uint16_t                  StepRate        = SERVO_PCA9685_STEP_RATE_DEFAULT;   ///< interpolation steps per second
 
     // non config data
     String      OutputName;
-    uint16_t    Num_Channels = OM_SERVO_PCA9685_CHANNEL_LIMIT;
+    uint16_t    Num_Channels = SERVO_PCA9685_CHANNELS_PER_BOARD;
+    uint8_t     NextBoardToFlush     = 0;
+    bool        FrameLatencyPending  = false;
+    uint32_t    FrameLatchTimeUs     = 0;
+    uint32_t    LatencyUs            = 0;   ///< frame received to last register written
+    uint32_t    MaxLatencyUs         = 0;
+    uint32_t    BusTimeUs            = 0;
+    uint32_t    BurstCount           = 0;
+    uint32_t    BytesWritten         = 0;
+    uint32_t    DeferredFlushes      = 0;   ///< renders that ran out of bus time
+    uint32_t    I2cErrors            = 0;
+    uint32_t    StepPeriodUs         = MicroSecondsInASecond / SERVO_PCA9685_STEP_RATE_DEFAULT;
+    uint32_t    LastStepUs           = 0;
+    uint32_t    LastTargetUs         = 0;
+    uint32_t    MoveStartUs          = 0;
+    uint32_t    FrameIntervalUs      = SERVO_PCA9685_MAX_MOVE_TIME_US;  ///< time between the last two targets
+    uint8_t     NumMovingServos      = 0;
+    uint32_t    StepCount            = 0;
 
 }; // c_OutputServoPCA9685
 
@@ -21,7 +21,7 @@
 
 #include "OutputSpi.hpp"
 #include "driver/spi_master.h"
-// #include <esp_heap_alloc_caps.h>
+#include <esp_heap_caps.h>
 
 //----------------------------------------------------------------------------
 /* shell function to set the 'this' pointer of the real ISR
@@ -123,34 +123,150 @@ void c_OutputSpi::Begin (c_OutputPixel* _OutputPixel)
     SpiBusConfiguration.sclk_io_num = ClockPin;
     SpiBusConfiguration.quadwp_io_num = -1;
     SpiBusConfiguration.quadhd_io_num = -1;
-    SpiBusConfiguration.max_transfer_sz = OM_MAX_NUM_CHANNELS;
+    SpiBusConfiguration.max_transfer_sz = SPI_MAX_TRANSFER_SIZE;
     SpiBusConfiguration.flags = SPICOMMON_BUSFLAG_MASTER;
 
+    ESP_ERROR_CHECK (spi_bus_initialize (SPI_SPI_HOST, &SpiBusConfiguration, SPI_SPI_DMA_CHANNEL));
+    ESP_ERROR_CHECK (AddDevice (ClockRateHz));
+
+    spi_transfer_callback_enabled = true;
+
+    HasBeenInitialized = true;
+
+    // DEBUG_END;
+
+} // Begin
+
+//----------------------------------------------------------------------------
+/*
+    spi_device_handle is only replaced when the device was added.
+*/
+esp_err_t c_OutputSpi::AddDevice (uint32_t DeviceClockRateHz)
+{
+    // DEBUG_START;
+
     spi_device_interface_config_t SpiDeviceConfiguration;
     memset ( (void*)&SpiDeviceConfiguration, 0x00, sizeof (SpiDeviceConfiguration));
     // SpiDeviceConfiguration.command_bits = 0; // No command to send
     // SpiDeviceConfiguration.address_bits = 0; // No bus address to send
     // SpiDeviceConfiguration.dummy_bits = 0; // No dummy bits to send
     // SpiDeviceConfiguration.duty_cycle_pos = 0; // 50% Duty cycle
-    SpiDeviceConfiguration.clock_speed_hz = SPI_SPI_MASTER_FREQ_1M;
+    SpiDeviceConfiguration.clock_speed_hz = DeviceClockRateHz;
     SpiDeviceConfiguration.mode = 0;                                // SPI mode 0
     SpiDeviceConfiguration.spics_io_num = -1;                       // we will NOT use CS pin
     SpiDeviceConfiguration.queue_size = 10 * SPI_NUM_TRANSACTIONS;    // We want to be able to queue 2 transactions at a time
     // SpiDeviceConfiguration.pre_cb = nullptr;                     // Specify pre-transfer callback to handle D/C line
     SpiDeviceConfiguration.post_cb = spi_transfer_callback;      // Specify post-transfer callback to handle D/C line
-    // SpiDeviceConfiguration.flags = 0;
+    SpiDeviceConfiguration.flags = SPI_DEVICE_NO_DUMMY;             // output only. Allows the higher clock rates through the GPIO matrix
 
-    ESP_ERROR_CHECK (spi_bus_initialize (SPI_SPI_HOST, &SpiBusConfiguration, SPI_SPI_DMA_CHANNEL));
-    ESP_ERROR_CHECK (spi_bus_add_device (SPI_SPI_HOST, &SpiDeviceConfiguration, &spi_device_handle));
-    ESP_ERROR_CHECK (spi_device_acquire_bus (spi_device_handle, portMAX_DELAY));
+    spi_device_handle_t NewDeviceHandle = 0;
+    esp_err_t Response = spi_bus_add_device (SPI_SPI_HOST, &SpiDeviceConfiguration, &NewDeviceHandle);
+    if (ESP_OK == Response)
+    {
+        spi_device_handle = NewDeviceHandle;
+        ESP_ERROR_CHECK (spi_device_acquire_bus (spi_device_handle, portMAX_DELAY));
+    }
 
-    spi_transfer_callback_enabled = true;
+    // DEBUG_END;
+    return Response;
 
-    HasBeenInitialized = true;
+} // AddDevice
+
+//----------------------------------------------------------------------------
+/*
+    The clock can only be changed by re-adding the device to the bus. Wait
+    for the current frame to finish before taking the device away. The new
+    rate is only kept once the device has been added with it.
+*/
+void c_OutputSpi::SetClockRate (uint32_t NewClockRateHz)
+{
+    // DEBUG_START;
+
+    NewClockRateHz = max (uint32_t (SPI_MIN_CLOCK_HZ), min (uint32_t (SPI_MAX_CLOCK_HZ), NewClockRateHz));
+
+    do // once
+    {
+        if (NewClockRateHz == ClockRateHz)
+        {
+            break;
+        }
+
+        if (!HasBeenInitialized)
+        {
+            // Begin will use the new rate
+            ClockRateHz = NewClockRateHz;
+            break;
+        }
+
+        if (!CollectCompletedTransactions (pdMS_TO_TICKS (100)))
+        {
+            logcon (F ("SPI output did not finish the current frame. Clock rate change will take effect after a reboot."));
+            break;
+        }
+
+        spi_device_release_bus (spi_device_handle);
+        ESP_ERROR_CHECK (spi_bus_remove_device (spi_device_handle));
+
+        esp_err_t Result = AddDevice (NewClockRateHz);
+        if (ESP_OK != Result)
+        {
+            logcon (String (F ("Could not set the SPI clock to ")) + String (NewClockRateHz) + String (F (" Hz. Error: ")) + String (esp_err_to_name (Result)) + String (F (". Keeping ")) + String (ClockRateHz) + String (F (" Hz.")));
+            ESP_ERROR_CHECK (AddDevice (ClockRateHz));
+            break;
+        }
+
+        ClockRateHz = NewClockRateHz;
+
+    } while (false);
+
+    // DEBUG_V (String ("ClockRateHz: ") + String (ClockRateHz));
 
     // DEBUG_END;
 
-} // Begin
+} // SetClockRate
+
+//----------------------------------------------------------------------------
+/*
+    The output manager frees the pixel buffers once this returns so the task
+    and any queued DMA transactions must be done with them.
+*/
+void c_OutputSpi::PauseOutput (bool State)
+{
+    // DEBUG_START;
+
+    do // once
+    {
+        if (OutputIsPaused == State)
+        {
+            // DEBUG_V ("no change. Ignore the call");
+            break;
+        }
+
+        OutputIsPaused = State;
+
+        if (!State || !HasBeenInitialized)
+        {
+            break;
+        }
+
+        // the task suspends itself once the transaction it is building has been queued
+        uint32_t WaitTimeMs = 0;
+        while ((eSuspended != eTaskGetState (SendIntensityDataTaskHandle)) && (WaitTimeMs++ < SPI_PAUSE_MAX_WAIT_MS))
+        {
+            vTaskDelay (pdMS_TO_TICKS (1));
+        }
+
+        if (!WaitForTaskTransactions ())
+        {
+            logcon (F ("SPI task transactions did not complete."));
+        }
+        CollectCompletedTransactions (portMAX_DELAY);
+
+    } while (false);
+
+    // DEBUG_END;
+
+} // PauseOutput
 
 //----------------------------------------------------------------------------
 void c_OutputSpi::SendIntensityData ()
@@ -158,7 +274,7 @@ void c_OutputSpi::SendIntensityData ()
     // DEBUG_START;
     SendIntensityDataCounter++;
 
-    if (OutputPixel->ISR_MoreDataToSend ())
+    if (!OutputIsPaused && OutputPixel->ISR_MoreDataToSend ())
     {
         spi_transaction_t & TransactionToFill = Transactions[NextTransactionToFill];
         memset ( (void*)&Transactions[NextTransactionToFill], 0x00, sizeof (spi_transaction_t));
@@ -181,6 +297,7 @@ void c_OutputSpi::SendIntensityData ()
         }
 
         ESP_ERROR_CHECK (spi_device_queue_trans (spi_device_handle, &Transactions[NextTransactionToFill], portMAX_DELAY));
+        ++TaskTransactionsInFlight;
 
         if (++NextTransactionToFill >= SPI_NUM_TRANSACTIONS)
         {
@@ -188,10 +305,216 @@ void c_OutputSpi::SendIntensityData ()
         }
     }
 
+    // Collect after queuing so the count only drops to zero once the frame is done.
+    // The task is the only reader of the results while it has transactions in flight.
+    spi_transaction_t * pCompletedTransaction = nullptr;
+    while (TaskTransactionsInFlight && (ESP_OK == spi_device_get_trans_result (spi_device_handle, &pCompletedTransaction, 0)))
+    {
+        --TaskTransactionsInFlight;
+    }
+
     // DEBUG_END;
 
 } // SendIntensityData
 
+//----------------------------------------------------------------------------
+/*
+    Make sure the frame buffer can hold the complete frame. Frames that do
+    not fit (or if the memory is not available) are sent by the task one
+    transaction at a time.
+*/
+bool c_OutputSpi::UpdateFrameBuffer ()
+{
+    // DEBUG_START;
+
+    size_t NewFrameBufferSize = (OutputPixel->GetPreparedFrameSizeNeeded () + 3) & ~size_t(3);
+
+    do // once
+    {
+        if (NewFrameBufferSize == FrameBufferSize)
+        {
+            break;
+        }
+
+        // the DMA may still be reading the current buffer. The task
+        // transactions must be gone too or their results would be
+        // collected as frame transactions.
+        if (!WaitForTaskTransactions () || !CollectCompletedTransactions (portMAX_DELAY))
+        {
+            logcon (F ("SPI output did not finish the current frame. Using the SPI task to send the data."));
+            break;
+        }
+
+        if (pFrameBuffer)
+        {
+            free (pFrameBuffer);
+            pFrameBuffer = nullptr;
+        }
+        FrameBufferSize = 0;
+
+        if ((0 == NewFrameBufferSize) || (NewFrameBufferSize > (SPI_NUM_TRANSACTIONS * SPI_MAX_TRANSFER_SIZE)))
+        {
+            break;
+        }
+
+        pFrameBuffer = (uint8_t *)heap_caps_malloc (NewFrameBufferSize, MALLOC_CAP_DMA | MALLOC_CAP_8BIT);
+        if (nullptr == pFrameBuffer)
+        {
+            logcon (String (F ("Could not allocate ")) + String (NewFrameBufferSize) + String (F (" bytes for the SPI frame buffer. Using the SPI task to send the data.")));
+            break;
+        }
+
+        FrameBufferSize = NewFrameBufferSize;
+
+    } while (false);
+
+    // DEBUG_END;
+    return (0 != FrameBufferSize) && (NewFrameBufferSize == FrameBufferSize);
+
+} // UpdateFrameBuffer
+
+//----------------------------------------------------------------------------
+/*
+    Returns true when all of the frame transactions are done. A transaction
+    only stops counting as in flight once its result has been collected.
+    Only called from the output task, and only once the task transactions
+    are done.
+*/
+bool c_OutputSpi::CollectCompletedTransactions (TickType_t TicksToWait)
+{
+    spi_transaction_t * pCompletedTransaction = nullptr;
+
+    while (TransactionsInFlight)
+    {
+        if (ESP_OK != spi_device_get_trans_result (spi_device_handle, &pCompletedTransaction, TicksToWait))
+        {
+            break;
+        }
+        --TransactionsInFlight;
+    }
+
+    return (0 == TransactionsInFlight);
+
+} // CollectCompletedTransactions
+
+//----------------------------------------------------------------------------
+/*
+    The task collects the results of its own transactions. Wait for it.
+*/
+bool c_OutputSpi::WaitForTaskTransactions ()
+{
+    uint32_t WaitTimeMs = 0;
+    while (TaskTransactionsInFlight && (WaitTimeMs++ < SPI_PAUSE_MAX_WAIT_MS))
+    {
+        vTaskDelay (pdMS_TO_TICKS (1));
+    }
+
+    return (0 == TaskTransactionsInFlight);
+
+} // WaitForTaskTransactions
+
+//----------------------------------------------------------------------------
+/*
+    True while the DMA is still sending the previous frame, either from the
+    task transactions or from the frame buffer.
+*/
+bool c_OutputSpi::IsBusy ()
+{
+    return (0 != TaskTransactionsInFlight) || !CollectCompletedTransactions (0);
+
+} // IsBusy
+
+//----------------------------------------------------------------------------
+/*
+    Called on every poll where a frame is due but the bus is busy. The
+    frame is only counted once no matter how many polls it waits.
+*/
+void c_OutputSpi::FrameSkippedBusy ()
+{
+    if (!BusySkipCounted)
+    {
+        BusySkipCounted = true;
+        ++FramesSkippedBusy;
+    }
+
+} // FrameSkippedBusy
+
+//----------------------------------------------------------------------------
+size_t c_OutputSpi::FillFrameBuffer (uint8_t * pMem, size_t NumBytes)
+{
+    uint8_t * pStart = pMem;
+    uint8_t * pEnd   = pMem + NumBytes;
+
+    while ((pMem < pEnd) && OutputPixel->ISR_MoreDataToSend ())
+    {
+        *pMem++ = uint8_t (OutputPixel->ISR_GetNextIntensityToSend ());
+    }
+
+    return size_t (pMem - pStart);
+
+} // FillFrameBuffer
+
+//----------------------------------------------------------------------------
+void c_OutputSpi::QueueFrameTransaction (uint32_t TransactionId, uint8_t * pMem, size_t NumBytes)
+{
+    spi_transaction_t & TransactionToFill = Transactions[TransactionId];
+    memset ( (void*)&TransactionToFill, 0x00, sizeof (spi_transaction_t));
+
+    TransactionToFill.user      = this;
+    TransactionToFill.tx_buffer = pMem;
+    TransactionToFill.length    = SPI_BITS_PER_INTENSITY * NumBytes;
+
+    ESP_ERROR_CHECK (spi_device_queue_trans (spi_device_handle, &TransactionToFill, portMAX_DELAY));
+    ++TransactionsInFlight;
+
+} // QueueFrameTransaction
+
+//----------------------------------------------------------------------------
+/*
+    Build the frame (start frame, pixel headers, pixel data, end frame) in
+    the frame buffer and hand it to the DMA. Large frames are split in two
+    so the first half is on the wire while the second half is built.
+*/
+bool c_OutputSpi::RenderFrameBuffer ()
+{
+    bool Response = false;
+
+    // DEBUG_START;
+
+    do // once
+    {
+        uint32_t StartTime = micros ();
+
+        OutputPixel->StartNewFrame ();
+
+        size_t FirstTransactionSize = (FrameBufferSize > SPI_FRAME_SPLIT_SIZE) ? (FrameBufferSize / 2) : FrameBufferSize;
+        FirstTransactionSize = min (FirstTransactionSize, size_t (SPI_MAX_TRANSFER_SIZE));
+
+        size_t NumBytes = FillFrameBuffer (pFrameBuffer, FirstTransactionSize);
+        TransactionsPerFrame = 0;
+        if (NumBytes)
+        {
+            QueueFrameTransaction (TransactionsPerFrame++, pFrameBuffer, NumBytes);
+        }
+
+        uint8_t * pSecondHalf = pFrameBuffer + NumBytes;
+        NumBytes = FillFrameBuffer (pSecondHalf, FrameBufferSize - NumBytes);
+        if (NumBytes)
+        {
+            QueueFrameTransaction (TransactionsPerFrame++, pSecondHalf, NumBytes);
+        }
+
+        FrameBuildTimeUs = micros () - StartTime;
+        Response = true;
+
+    } while (false);
+
+    // DEBUG_END;
+
+    return Response;
+
+} // RenderFrameBuffer
+
 //----------------------------------------------------------------------------
 bool c_OutputSpi::Render ()
 {
@@ -199,6 +522,19 @@ bool c_OutputSpi::Render ()
 
     // DEBUG_START;
 
+    if (OutputIsPaused || IsBusy ())
+    {
+        return false;
+    }
+
+    BusySkipCounted = false;
+
+    FrameBufferInUse = UpdateFrameBuffer ();
+    if (FrameBufferInUse)
+    {
+        return RenderFrameBuffer ();
+    }
+
     OutputPixel->StartNewFrame ();
 
     // fill all the available buffers
@@ -218,4 +554,20 @@ bool c_OutputSpi::Render ()
     return Response;
 } // render
 
+//----------------------------------------------------------------------------
+void c_OutputSpi::GetStatus (ArduinoJson::JsonObject & jsonStatus)
+{
+    // DEBUG_START;
+
+    JsonObject SpiStatus = jsonStatus.createNestedObject (F ("SPI"));
+    SpiStatus[F ("ClockRateKHz")]         = ClockRateHz / 1000;
+    SpiStatus[F ("Mode")]                 = (FrameBufferInUse) ? F ("Frame") : F ("Task");
+    SpiStatus[F ("FrameBufferSize")]      = FrameBufferSize;
+    SpiStatus[F ("TransactionsPerFrame")] = TransactionsPerFrame;
+    SpiStatus[F ("FrameBuildTimeUs")]     = FrameBuildTimeUs;
+    SpiStatus[F ("FramesSkippedBusy")]    = FramesSkippedBusy;
+
+    // DEBUG_END;
+} // GetStatus
+
 #endif // def SUPPORT_SPI_OUTPUT
@@ -38,10 +38,16 @@ public:
     // functions to be provided by the derived class
     void    Begin (c_OutputPixel* _OutputPixel);
     bool    Render ();                                        ///< Call from loop (),  renders output data
-    TaskHandle_t GetTaskHandle () { return SendIntensityDataTaskHandle; }
+    TaskHandle_t GetTaskHandle () { return (FrameBufferInUse) ? NULL : SendIntensityDataTaskHandle; } ///< The task only refills transactions when the frame is not sent from the frame buffer
     void    GetDriverName (String& Name) { Name = "OutputSpi"; }
     void    DataOutputTask (void* pvParameters);
     void    SendIntensityData ();
+    void    SetClockRate (uint32_t NewClockRateHz);
+    void    PauseOutput (bool State);                          ///< Returns once the task and the DMA no longer read the pixel data
+    uint32_t GetClockRate () { return ClockRateHz; }
+    bool    IsBusy ();                                         ///< The previous frame is still being sent
+    void    FrameSkippedBusy ();                               ///< A frame was due while the previous one was being sent
+    void    GetStatus (ArduinoJson::JsonObject & jsonStatus);
 
     uint32_t DataTaskcounter = 0;
     uint32_t DataCbCounter = 0;
@@ -54,6 +60,11 @@ private:
 #define SPI_BITS_PER_INTENSITY               8
 #define SPI_SPI_HOST                         VSPI_HOST
 #define SPI_SPI_DMA_CHANNEL                  2
+#define SPI_MIN_CLOCK_HZ                     (100 * 1000)
+#define SPI_MAX_CLOCK_HZ                     (APB_CLK_FREQ/4)     // 20Mhz. Limit of the GPIO matrix
+#define SPI_MAX_TRANSFER_SIZE                (32 * 1024)          // largest single DMA transaction
+#define SPI_FRAME_SPLIT_SIZE                 1024                 // bigger frames are sent in two transactions so the first half goes out while the second half is built
+#define SPI_PAUSE_MAX_WAIT_MS                100                  // longest wait for the task to finish the transaction it is building
 
     uint8_t NumIntensityValuesPerInterrupt = 0;
     uint8_t NumIntensityBitsPerInterrupt = 0;
@@ -69,6 +80,28 @@ private:
     uint8_t NextTransactionToFill = 0;
     TaskHandle_t SendIntensityDataTaskHandle = NULL;
 
+    uint32_t ClockRateHz = SPI_SPI_MASTER_FREQ_1M;
+
+    // The whole frame is built in one DMA capable buffer and sent in one or two transactions
+    uint8_t * pFrameBuffer           = nullptr;
+    size_t    FrameBufferSize        = 0;
+    bool      FrameBufferInUse       = false;
+    bool      OutputIsPaused         = false;
+    uint32_t  TransactionsInFlight   = 0;                 ///< frame buffer transactions. Collected by the output task.
+    volatile uint32_t TaskTransactionsInFlight = 0;       ///< queued by the task. Collected by the task.
+    uint32_t  TransactionsPerFrame   = 0;
+    uint32_t  FrameBuildTimeUs       = 0;
+    uint32_t  FramesSkippedBusy      = 0;
+    bool      BusySkipCounted        = false;             ///< the frame that is waiting for the bus has been counted
+
+    esp_err_t AddDevice (uint32_t DeviceClockRateHz);
+    bool    UpdateFrameBuffer ();
+    bool    CollectCompletedTransactions (TickType_t TicksToWait);
+    bool    WaitForTaskTransactions ();
+    size_t  FillFrameBuffer (uint8_t * pMem, size_t NumBytes);
+    void    QueueFrameTransaction (uint32_t TransactionId, uint8_t * pMem, size_t NumBytes);
+    bool    RenderFrameBuffer ();
+
     gpio_num_t DataPin = DEFAULT_SPI_DATA_GPIO;
     gpio_num_t ClockPin = DEFAULT_SPI_CLOCK_GPIO;
 
@@ -42,6 +42,7 @@ public:
     bool    SetConfig (ArduinoJson::JsonObject& jsonConfig);  ///< Set a new config in the driver
     void    Render ();                                        ///< Call from loop (),  renders output data
     void    GetStatus (ArduinoJson::JsonObject& jsonStatus);
+    void    PauseOutput (bool State) {c_OutputTM1814::PauseOutput (State); Rmt.PauseOutput (State);}
     void    SetOutputBufferSize (uint16_t NumChannelsAvailable);
 
 private:
@@ -48,6 +48,11 @@ extern "C"
 #endif
 } // extern C
 
+#ifdef SUPPORT_UART_DMA
+#   include <driver/periph_ctrl.h>
+#   include <esp_heap_caps.h>
+#endif // def SUPPORT_UART_DMA
+
 #ifndef UART_INV_MASK
 #   define UART_INV_MASK (0x3f << 19)
 #endif // ndef UART_INV_MASK
@@ -133,6 +138,7 @@ c_OutputUart::c_OutputUart()
     // DEBUG_START;
 
     memset((void *)&Intensity2Uart[0],   0x00, sizeof(Intensity2Uart));
+    memset((void *)&Nibble2UartSymbols[0], 0x00, sizeof(Nibble2UartSymbols));
     // DEBUG_END;
 } // c_OutputUart
 
@@ -143,6 +149,19 @@ c_OutputUart::~c_OutputUart ()
 
     TerminateUartOperation();
 
+#ifdef SUPPORT_UART_DMA
+    if (pDmaBuffer)
+    {
+        free (pDmaBuffer);
+        pDmaBuffer = nullptr;
+    }
+    if (pDmaDescriptors)
+    {
+        free (pDmaDescriptors);
+        pDmaDescriptors = nullptr;
+    }
+#endif // def SUPPORT_UART_DMA
+
 #ifdef ARDUINO_ARCH_ESP8266
 
     OutputTimerArray[OutputUartConfig.ChannelId] = nullptr;
@@ -293,6 +312,16 @@ void c_OutputUart::GetStatus(ArduinoJson::JsonObject &jsonStatus)
 {
     // DEBUG_START;
 
+#ifdef SUPPORT_UART_DMA
+    jsonStatus[F("TxMode")] = (UseDma ()) ? F("DMA") : F("ISR");
+    if (UseDma ())
+    {
+        jsonStatus[F("DmaBufferSize")]       = DmaBufferSize;
+        jsonStatus[F("DmaFrames")]           = DmaFrameCount;
+        jsonStatus[F("DmaIncompleteFrames")] = DmaIncompleteFrames;
+    }
+#endif // def SUPPORT_UART_DMA
+
 #ifdef USE_UART_DEBUG_COUNTERS
     JsonObject debugStatus = jsonStatus.createNestedObject("UART Debug");
     debugStatus["ChannelId"]                     = OutputUartConfig.ChannelId;
@@ -317,6 +346,8 @@ void c_OutputUart::GetStatus(ArduinoJson::JsonObject &jsonStatus)
     debugStatus["TimerIsrSendData"]              = TimerIsrSendData;
     debugStatus["FiFoNotEmpty"]                  = FiFoNotEmpty;
     debugStatus["FiFoEmpty"]                     = FiFoEmpty;
+    debugStatus["NumUartSymbolsPerNibble"]       = NumUartSymbolsPerNibble;
+    debugStatus["SymbolTableMismatches"]         = SymbolTableMismatches;
     debugStatus["UartFifoLength"]                = getUartFifoLength();
 
     debugStatus["UART_CONF0"] = String(READ_PERI_REG(UART_CONF0(OutputUartConfig.UartId)), HEX);
@@ -527,6 +558,229 @@ void c_OutputUart::InitializeUart()
 } // InitializeUart
 #endif
 
+#ifdef SUPPORT_UART_DMA
+//----------------------------------------------------------------------------
+/*
+    Attach a UHCI block to the UART. UHCI is normally used for SLIP framed
+    transfers. All of the framing, header, CRC and escape options are turned
+    off so the bytes in the DMA buffer go out on the wire unchanged.
+*/
+void c_OutputUart::InitializeDma ()
+{
+    // DEBUG_START;
+
+    do // once
+    {
+        DmaIsAvailable = false;
+
+        if (UART_NUM_1 == OutputUartConfig.UartId)
+        {
+            pUhci = &UHCI0;
+            periph_module_enable (PERIPH_UHCI0_MODULE);
+        }
+        else if (UART_NUM_2 == OutputUartConfig.UartId)
+        {
+            pUhci = &UHCI1;
+            periph_module_enable (PERIPH_UHCI1_MODULE);
+        }
+        else
+        {
+            // DEBUG_V ("No UHCI block for this UART");
+            pUhci = nullptr;
+            break;
+        }
+
+        pUhci->conf0.val               = 0;
+        pUhci->conf0.out_rst           = 1;
+        pUhci->conf0.out_rst           = 0;
+        pUhci->conf0.ahbm_rst          = 1;
+        pUhci->conf0.ahbm_rst          = 0;
+        pUhci->conf0.ahbm_fifo_rst     = 1;
+        pUhci->conf0.ahbm_fifo_rst     = 0;
+        pUhci->conf0.uart1_ce          = (UART_NUM_1 == OutputUartConfig.UartId);
+        pUhci->conf0.uart2_ce          = (UART_NUM_2 == OutputUartConfig.UartId);
+        pUhci->conf0.outdscr_burst_en  = 1;
+        pUhci->conf0.out_data_burst_en = 1;
+        pUhci->conf0.clk_en            = 1;
+
+        pUhci->conf1.val               = 0;
+        pUhci->conf1.crc_disable       = 1;
+        pUhci->escape_conf.val         = 0;
+        pUhci->int_ena.val             = 0;
+        pUhci->int_clr.val             = UINT32_MAX;
+
+        DmaIsAvailable = true;
+
+    } while (false);
+
+    // DEBUG_END;
+
+} // InitializeDma
+
+//----------------------------------------------------------------------------
+void c_OutputUart::TerminateDma ()
+{
+    // DEBUG_START;
+
+    if (pUhci)
+    {
+        pUhci->dma_out_link.stop = 1;
+        pUhci->int_clr.val       = UINT32_MAX;
+    }
+
+    // DEBUG_END;
+
+} // TerminateDma
+
+//----------------------------------------------------------------------------
+/*
+    The DMA buffer grows to fit the largest frame seen so far. This only
+    allocates during the first frames after a config change.
+*/
+bool c_OutputUart::GrowDmaBuffer (size_t MinSize)
+{
+    // DEBUG_START;
+
+    bool Response = false;
+
+    do // once
+    {
+        size_t NewBufferSize = ((MinSize + UART_DMA_BUFFER_INCREMENT - 1) / UART_DMA_BUFFER_INCREMENT) * UART_DMA_BUFFER_INCREMENT;
+        uint8_t * pNewBuffer = (uint8_t *)heap_caps_realloc (pDmaBuffer, NewBufferSize, MALLOC_CAP_DMA | MALLOC_CAP_8BIT);
+        if (nullptr == pNewBuffer)
+        {
+            break;
+        }
+        pDmaBuffer    = pNewBuffer;
+        DmaBufferSize = NewBufferSize;
+
+        size_t NewNumDescriptors = (NewBufferSize + UART_DMA_MAX_DESCRIPTOR_SIZE - 1) / UART_DMA_MAX_DESCRIPTOR_SIZE;
+        if (NewNumDescriptors > NumDmaDescriptors)
+        {
+            lldesc_t * pNewDescriptors = (lldesc_t *)heap_caps_realloc (pDmaDescriptors, NewNumDescriptors * sizeof (lldesc_t), MALLOC_CAP_DMA | MALLOC_CAP_8BIT);
+            if (nullptr == pNewDescriptors)
+            {
+                break;
+            }
+            pDmaDescriptors   = pNewDescriptors;
+            NumDmaDescriptors = NewNumDescriptors;
+        }
+
+        Response = true;
+
+    } while (false);
+
+    if (!Response)
+    {
+        logcon (String (F ("Not enough DMA memory for UART ")) + String (OutputUartConfig.UartId) + F (". Using interrupts."));
+        DmaIsAvailable = false;
+    }
+
+    // DEBUG_END;
+
+    return Response;
+
+} // GrowDmaBuffer
+
+//----------------------------------------------------------------------------
+/*
+    Translate the whole frame into UART data. Runs in task context so the
+    ISR is not involved at all while the frame is on the wire.
+*/
+bool c_OutputUart::ExpandFrameForDma ()
+{
+    // DEBUG_START;
+
+    bool Response = true;
+    DmaFrameSize  = 0;
+
+#if defined(SUPPORT_OutputType_DMX) || defined(SUPPORT_OutputType_Serial) || defined(SUPPORT_OutputType_Renard)
+    if (nullptr != OutputUartConfig.pSerialDataSource)
+    {
+        // The serial frame is already encoded. Copy it in one piece.
+        size_t EncodedFrameSize = OutputUartConfig.pSerialDataSource->GetEncodedFrameSize ();
+        if ((EncodedFrameSize > DmaBufferSize) && !GrowDmaBuffer (EncodedFrameSize))
+        {
+            Response = false;
+        }
+        else
+        {
+            const uint8_t * pEncodedData;
+            DmaFrameSize = OutputUartConfig.pSerialDataSource->ISR_GetNextBlockToSend (&pEncodedData, DmaBufferSize);
+            memcpy (pDmaBuffer, pEncodedData, DmaFrameSize);
+        }
+    }
+#endif // defined(SUPPORT_OutputType_DMX) || defined(SUPPORT_OutputType_Serial) || defined(SUPPORT_OutputType_Renard)
+
+    while (Response && MoreDataToSend ())
+    {
+        if ((DmaBufferSize - DmaFrameSize) < UART_MAX_SLOTS_PER_INTENSITY)
+        {
+            if (!GrowDmaBuffer (DmaBufferSize + UART_DMA_BUFFER_INCREMENT))
+            {
+                Response = false;
+                break;
+            }
+        }
+
+        DmaFrameSize += TranslateIntensity (GetNextIntensityToSend (), &pDmaBuffer[DmaFrameSize]);
+    }
+
+    // DEBUG_END;
+
+    return Response;
+
+} // ExpandFrameForDma
+
+//----------------------------------------------------------------------------
+void c_OutputUart::StartDmaTransfer ()
+{
+    // DEBUG_START;
+
+    do // once
+    {
+        if (0 == DmaFrameSize)
+        {
+            break;
+        }
+
+        // chain the descriptors over the expanded frame
+        size_t     RemainingBytes = DmaFrameSize;
+        uint8_t  * pData          = pDmaBuffer;
+        lldesc_t * pDescriptor    = pDmaDescriptors;
+        while (RemainingBytes)
+        {
+            size_t DescriptorLength = min (RemainingBytes, size_t (UART_DMA_MAX_DESCRIPTOR_SIZE));
+            RemainingBytes -= DescriptorLength;
+
+            pDescriptor->size   = (DescriptorLength + 3) & ~3;
+            pDescriptor->length = DescriptorLength;
+            pDescriptor->offset = 0;
+            pDescriptor->sosf   = 0;
+            pDescriptor->eof    = (0 == RemainingBytes);
+            pDescriptor->owner  = 1;
+            pDescriptor->buf    = pData;
+            pDescriptor->qe.stqe_next = (RemainingBytes) ? (pDescriptor + 1) : nullptr;
+
+            pData += DescriptorLength;
+            ++pDescriptor;
+        }
+
+        pUhci->int_clr.val        = UINT32_MAX;
+        pUhci->conf0.out_rst      = 1;
+        pUhci->conf0.out_rst      = 0;
+        pUhci->dma_out_link.addr  = uint32_t (pDmaDescriptors) & 0xFFFFF;
+        pUhci->dma_out_link.start = 1;
+
+        ++DmaFrameCount;
+
+    } while (false);
+
+    // DEBUG_END;
+
+} // StartDmaTransfer
+#endif // def SUPPORT_UART_DMA
+
 //----------------------------------------------------------------------------
 bool IRAM_ATTR c_OutputUart::MoreDataToSend()
 {
@@ -736,58 +990,40 @@ void IRAM_ATTR c_OutputUart::ISR_Handler_SendIntensityData ()
     }
 #endif // def USE_UART_DEBUG_COUNTERS
 
-    while (MoreDataToSend() && NumAvailableIntensitySlotsToFill)
+#if defined(SUPPORT_OutputType_DMX) || defined(SUPPORT_OutputType_Serial) || defined(SUPPORT_OutputType_Renard)
+    if ((nullptr != OutputUartConfig.pSerialDataSource) && (0 == OutputUartConfig.NumInterIntensityBreakBits))
     {
+        // pre-encoded serial frame. Copy straight into the FIFO.
+        const uint8_t * pEncodedData;
+        size_t NumBytes = OutputUartConfig.pSerialDataSource->ISR_GetNextBlockToSend (&pEncodedData, NumAvailableIntensitySlotsToFill);
 #ifdef USE_UART_DEBUG_COUNTERS
-        IntensityValuesSent++;
+        IntensityValuesSent += NumBytes;
+        IntensityBitsSent   += NumBytes * OutputUartConfig.IntensityDataWidth;
 #endif // def USE_UART_DEBUG_COUNTERS
+        while (NumBytes--)
+        {
+            enqueueUartData(*pEncodedData++);
+        }
+        return;
+    }
+#endif // defined(SUPPORT_OutputType_DMX) || defined(SUPPORT_OutputType_Serial) || defined(SUPPORT_OutputType_Renard)
 
-        NumAvailableIntensitySlotsToFill--;
+    uint8_t UartData[UART_MAX_SLOTS_PER_INTENSITY];
 
-        uint32_t IntensityValue = GetNextIntensityToSend();
-        if (OutputUartConfig.TranslateIntensityData == TranslateIntensityData_t::NoTranslation)
-        {
-            for (uint32_t count = 0; count < NumUartSlotsPerIntensityValue; count++)
-            {
-                enqueueUartData(IntensityValue & 0xFF);
-                IntensityValue >>= 8;
+    while (MoreDataToSend() && NumAvailableIntensitySlotsToFill)
+    {
 #ifdef USE_UART_DEBUG_COUNTERS
-                IntensityBitsSent += 8;
+        IntensityValuesSent++;
+        IntensityBitsSent += OutputUartConfig.IntensityDataWidth;
 #endif // def USE_UART_DEBUG_COUNTERS
-            }
-        } // end no translation
 
-        else if (OutputUartConfig.TranslateIntensityData == TranslateIntensityData_t::OneToOne)
-        { // 1:1
-            for (uint32_t mask = TxIntensityDataStartingMask; 0 != mask; mask >>= 1)
-            {
-                // convert the intensity data into UART data
-                enqueueUartData(Intensity2Uart[(IntensityValue & mask) ? UartDataBitTranslationId_t::Uart_DATA_BIT_01_ID : UartDataBitTranslationId_t::Uart_DATA_BIT_00_ID]);
-#ifdef USE_UART_DEBUG_COUNTERS
-                IntensityBitsSent += 1;
-#endif // def USE_UART_DEBUG_COUNTERS
-            }
-        } // end 1:1
+        NumAvailableIntensitySlotsToFill--;
 
-        else // 2:1
+        size_t NumUartBytes = TranslateIntensity(GetNextIntensityToSend(), UartData);
+        for (size_t index = 0; index < NumUartBytes; index++)
         {
-            // Mask is used as a shift counter that is decremented by 2.
-            for (uint32_t NumBitsToShift = TxIntensityDataStartingMask - 2; 
-                 0 < NumBitsToShift; 
-                 NumBitsToShift -= 2)
-            {
-                // convert the intensity data into UART data
-                enqueueUartData(Intensity2Uart[(IntensityValue >> NumBitsToShift) & 0x3]);
-#ifdef USE_UART_DEBUG_COUNTERS
-                IntensityBitsSent += 2;
-#endif // def USE_UART_DEBUG_COUNTERS
-            }
-            // handle the last two bits
-            enqueueUartData(Intensity2Uart[IntensityValue & 0x3]);
-#ifdef USE_UART_DEBUG_COUNTERS
-            IntensityBitsSent += 2;
-#endif    // def USE_UART_DEBUG_COUNTERS
-        } // end 2:1
+            enqueueUartData(UartData[index]);
+        }
 
         if (OutputUartConfig.NumInterIntensityBreakBits)
         {
@@ -800,6 +1036,108 @@ void IRAM_ATTR c_OutputUart::ISR_Handler_SendIntensityData ()
 
 } // ISR_Handler_SendIntensityData
 
+//----------------------------------------------------------------------------
+/*
+    Convert one intensity value into the bytes that represent it on the wire.
+    Returns the number of bytes written to pUartData.
+*/
+size_t IRAM_ATTR c_OutputUart::TranslateIntensity(uint32_t IntensityValue, uint8_t * pUartData)
+{
+    uint8_t * pCurrentUartData = pUartData;
+
+    if (OutputUartConfig.TranslateIntensityData == TranslateIntensityData_t::NoTranslation)
+    {
+        for (uint32_t count = 0; count < NumUartSlotsPerIntensityValue; count++)
+        {
+            *pCurrentUartData++ = uint8_t(IntensityValue & 0xFF);
+            IntensityValue >>= 8;
+        }
+    } // end no translation
+
+    else if (NumUartSymbolsPerNibble)
+    {
+        pCurrentUartData += UartSymbolsTranslateByNibble(IntensityValue,
+                                                         OutputUartConfig.IntensityDataWidth,
+                                                         Nibble2UartSymbols,
+                                                         NumUartSymbolsPerNibble,
+                                                         pCurrentUartData);
+    } // end table lookup
+
+    else
+    {
+        pCurrentUartData += TranslateIntensityBitByBit(IntensityValue, pCurrentUartData);
+    }
+
+    return size_t(pCurrentUartData - pUartData);
+
+} // TranslateIntensity
+
+//----------------------------------------------------------------------------
+/*
+    Reference translation one bit (1:1) or bit pair (2:1) at a time. Used for
+    data widths the nibble table cannot handle and to check the table.
+*/
+size_t IRAM_ATTR c_OutputUart::TranslateIntensityBitByBit(uint32_t IntensityValue, uint8_t * pUartData)
+{
+    return UartSymbolsTranslateBitByBit(IntensityValue,
+                                        (OutputUartConfig.TranslateIntensityData == TranslateIntensityData_t::OneToOne),
+                                        TxIntensityDataStartingMask,
+                                        Intensity2Uart,
+                                        pUartData);
+
+} // TranslateIntensityBitByBit
+
+//----------------------------------------------------------------------------
+/*
+    Build the nibble to UART symbol table from the current translation set.
+    Called whenever the data width or a translation entry changes.
+*/
+void c_OutputUart::BuildUartSymbolTable()
+{
+    // DEBUG_START;
+
+    NumUartSymbolsPerNibble = 0;
+
+    do // once
+    {
+        if (OutputUartConfig.TranslateIntensityData == TranslateIntensityData_t::NoTranslation)
+        {
+            // DEBUG_V("Table not used");
+            break;
+        }
+
+        NumUartSymbolsPerNibble = UartSymbolsBuildNibbleTable(Intensity2Uart,
+                                                              (OutputUartConfig.TranslateIntensityData == TranslateIntensityData_t::OneToOne),
+                                                              OutputUartConfig.IntensityDataWidth,
+                                                              Nibble2UartSymbols);
+        if (0 == NumUartSymbolsPerNibble)
+        {
+            // DEBUG_V("Data width is not a multiple of 4");
+            break;
+        }
+
+#ifdef USE_UART_DEBUG_COUNTERS
+        // check the table against the bit by bit translation
+        uint32_t NumValuesToCheck = 1 << min(OutputUartConfig.IntensityDataWidth, size_t(16));
+        for (uint32_t IntensityValue = 0; IntensityValue < NumValuesToCheck; ++IntensityValue)
+        {
+            uint8_t TableData[UART_MAX_SLOTS_PER_INTENSITY];
+            uint8_t BitData[UART_MAX_SLOTS_PER_INTENSITY];
+            size_t  TableSize = TranslateIntensity(IntensityValue, TableData);
+            size_t  BitSize   = TranslateIntensityBitByBit(IntensityValue, BitData);
+            if ((TableSize != BitSize) || (0 != memcmp(TableData, BitData, BitSize)))
+            {
+                SymbolTableMismatches++;
+            }
+        }
+#endif // def USE_UART_DEBUG_COUNTERS
+
+    } while (false);
+
+    // DEBUG_END;
+
+} // BuildUartSymbolTable
+
 //----------------------------------------------------------------------------
 void c_OutputUart::PauseOutput(bool PauseOutput)
 {
@@ -813,6 +1151,9 @@ void c_OutputUart::PauseOutput(bool PauseOutput)
     {
         // DEBUG_V("stop the output");
         DisableUartInterrupts();
+#ifdef SUPPORT_UART_DMA
+        TerminateDma();
+#endif // def SUPPORT_UART_DMA
     }
 
     OutputIsPaused = PauseOutput;
@@ -878,6 +1219,7 @@ bool c_OutputUart::SetConfig(JsonObject &jsonConfig)
 void c_OutputUart::SetIntensity2Uart(uint8_t value, UartDataBitTranslationId_t ID)
 {
     Intensity2Uart[ID] = value;
+    BuildUartSymbolTable();
 } // SetIntensity2Uart
 
 //----------------------------------------------------------------------------
@@ -908,6 +1250,8 @@ void c_OutputUart::SetIntensityDataWidth()
         TxIntensityDataStartingMask   = OutputUartConfig.IntensityDataWidth;
     }
 
+    BuildUartSymbolTable();
+
     // DEBUG_V(String("  TxIntensityDataStartingMask: 0x") + String(TxIntensityDataStartingMask, HEX));
     // DEBUG_V(String("NumUartSlotsPerIntensityValue: ")   + String(NumUartSlotsPerIntensityValue));
 
@@ -1026,6 +1370,18 @@ void c_OutputUart::StartNewFrame()
 
     DisableUartInterrupts();
 
+#ifdef SUPPORT_UART_DMA
+    if (UseDma())
+    {
+        // the last frame should have been handed to the UART by now
+        if (DmaFrameCount && !pUhci->int_raw.out_total_eof)
+        {
+            DmaIncompleteFrames++;
+        }
+        TerminateDma();
+    }
+#endif // def SUPPORT_UART_DMA
+
 #ifdef USE_UART_DEBUG_COUNTERS
     FrameStartCounter++;
 
@@ -1055,8 +1411,29 @@ void c_OutputUart::StartNewFrame()
         EnableUartInterrupts();
     }
 #else
-    ISR_Handler_SendIntensityData();
-    EnableUartInterrupts();
+#   ifdef SUPPORT_UART_DMA
+    if (UseDma())
+    {
+        // The DMA engine feeds the FIFO. No interrupts while the frame is sent.
+        if (ExpandFrameForDma())
+        {
+            StartDmaTransfer();
+        }
+        else
+        {
+            // Out of DMA memory. Part of the frame is already in the DMA
+            // buffer so rewind the source and send the whole frame through the ISR.
+            StartNewDataFrame();
+            ISR_Handler_SendIntensityData();
+            EnableUartInterrupts();
+        }
+    }
+    else
+#   endif // def SUPPORT_UART_DMA
+    {
+        ISR_Handler_SendIntensityData();
+        EnableUartInterrupts();
+    }
 #endif // defined(ARDUINO_ARCH_ESP32)
 
     // DEBUG_END;
@@ -1082,6 +1459,10 @@ void c_OutputUart::StartUart()
         // Initialize uart also sets pin
         InitializeUart();
 
+#ifdef SUPPORT_UART_DMA
+        InitializeDma();
+#endif // def SUPPORT_UART_DMA
+
         // Atttach interrupt handler
         RegisterUartIsrHandler();
 
@@ -1152,6 +1533,10 @@ void c_OutputUart::TerminateUartOperation()
     }
 #endif // def ARDUINO_ARCH_ESP32
 
+#ifdef SUPPORT_UART_DMA
+    TerminateDma();
+#endif // def SUPPORT_UART_DMA
+
     // DEBUG_END;
 
 } // TerminateUartOperation
@@ -27,8 +27,18 @@
 #   include <driver/gpio.h>
 #endif
 
+// Stream whole frames into the UART with the UHCI DMA engine instead of
+// refilling the FIFO from an ISR. The ESP32 has two UHCI blocks, one for
+// each of the UARTs used for output.
+#if defined(ARDUINO_ARCH_ESP32) && defined(CONFIG_IDF_TARGET_ESP32)
+#   define SUPPORT_UART_DMA
+#   include <soc/lldesc.h>
+#   include <soc/uhci_struct.h>
+#endif // defined(ARDUINO_ARCH_ESP32) && defined(CONFIG_IDF_TARGET_ESP32)
+
 #include "OutputPixel.hpp"
 #include "OutputSerial.hpp"
+#include "OutputUartSymbols.hpp"
 
 class c_OutputUart
 {
@@ -127,7 +137,16 @@ private:
 
     OutputUartConfig_t OutputUartConfig;
 
+    // Largest number of UART bytes one intensity value can expand into
+#define UART_MAX_SLOTS_PER_INTENSITY 32
+
     uint8_t Intensity2Uart[UartDataBitTranslationId_t::Uart_LIST_END];
+
+    // UART symbols for each 4 bit nibble of intensity data, first symbol on
+    // the wire in the low byte. 4 symbols per nibble for 1:1, 2 for 2:1.
+    // Zero symbols per nibble when the data width is not a multiple of 4.
+    uint32_t        Nibble2UartSymbols[UART_SYMBOLS_NIBBLE_TABLE_SIZE];
+    uint32_t        NumUartSymbolsPerNibble         = 0;
     bool            OutputIsPaused                  = false;
     uint32_t        LastFrameStartTime              = 0;
     uint32_t        FrameMinDurationInMicroSec      = 25000;
@@ -140,6 +159,9 @@ private:
     intr_handle_t   IsrHandle                       = nullptr;
 #endif // defined(ARDUINO_ARCH_ESP32)
 
+    size_t   IRAM_ATTR      TranslateIntensity(uint32_t IntensityValue, uint8_t * pUartData);
+    size_t   IRAM_ATTR      TranslateIntensityBitByBit(uint32_t IntensityValue, uint8_t * pUartData);
+    void                    BuildUartSymbolTable();
     bool     IRAM_ATTR      MoreDataToSend();
     uint32_t IRAM_ATTR      GetNextIntensityToSend();
     void     IRAM_ATTR      StartNewDataFrame();
@@ -150,6 +172,28 @@ private:
     inline void IRAM_ATTR   ClearUartInterrupts();
     inline void IRAM_ATTR   DisableUartInterrupts();
 
+#ifdef SUPPORT_UART_DMA
+#   define UART_DMA_BUFFER_INCREMENT    1024
+#   define UART_DMA_MAX_DESCRIPTOR_SIZE 4092  ///< word aligned and below the 12 bit length limit
+
+    void        InitializeDma       ();
+    void        TerminateDma        ();
+    bool        ExpandFrameForDma   ();
+    bool        GrowDmaBuffer       (size_t MinSize);
+    void        StartDmaTransfer    ();
+    inline bool UseDma ()           { return DmaIsAvailable && (0 == OutputUartConfig.NumInterIntensityBreakBits); }
+
+    uhci_dev_t *pUhci               = nullptr;
+    bool        DmaIsAvailable      = false;
+    uint8_t   * pDmaBuffer          = nullptr;
+    size_t      DmaBufferSize       = 0;
+    size_t      DmaFrameSize        = 0;
+    lldesc_t  * pDmaDescriptors     = nullptr;
+    size_t      NumDmaDescriptors   = 0;
+    uint32_t    DmaFrameCount       = 0;
+    uint32_t    DmaIncompleteFrames = 0;
+#endif // def SUPPORT_UART_DMA
+
 // #define USE_UART_DEBUG_COUNTERS
 #ifdef USE_UART_DEBUG_COUNTERS
     // debug counters
@@ -177,6 +221,7 @@ private:
     uint32_t EnqueueCounter = 0;
     uint32_t FiFoNotEmpty = 0;
     uint32_t FiFoEmpty = 0;
+    uint32_t SymbolTableMismatches = 0;
 
 #endif // def USE_UART_DEBUG_COUNTERS
 
@@ -0,0 +1,135 @@
+#pragma once
+/*
+* OutputUartSymbols.hpp - Intensity to UART symbol translation
+*
+* Project: ESPixelStick - An ESP8266 / ESP32 and E1.31 based pixel driver
+* Copyright (c) 2021, 2022 Shelby Merrick
+* http://www.forkineye.com
+*
+*  This program is provided free for you to use in any way that you wish,
+*  subject to the laws and regulations where you are using it.  Due diligence
+*  is strongly suggested before using this code.  Please give credit where due.
+*
+*  The Author makes no warranty of any kind, express or implied, with regard
+*  to this program or the documentation contained in this document.  The
+*  Author shall not be liable in any event for incidental or consequential
+*  damages in connection with, or arising out of, the furnishing, performance
+*  or use of these programs.
+*
+*   Each UART byte on the wire carries one intensity bit (1:1) or one pair
+*   of intensity bits (2:1). Intensity2Uart holds the four symbols indexed
+*   by the bit pair value (00, 01, 10, 11). 1:1 only uses 00 and 01.
+*
+*/
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define UART_SYMBOLS_NIBBLE_TABLE_SIZE  16
+
+//----------------------------------------------------------------------------
+/*
+    Build the UART symbols for each 4 bit nibble of intensity data, first
+    symbol on the wire in the low byte. Returns the number of symbols per
+    nibble (4 for 1:1, 2 for 2:1) or 0 when the data width is not a
+    multiple of 4 and the table cannot be used.
+*/
+inline uint32_t UartSymbolsBuildNibbleTable (const uint8_t * Intensity2Uart,
+                                             bool            OneToOne,
+                                             size_t          IntensityDataWidth,
+                                             uint32_t *      Nibble2UartSymbols)
+{
+    if (0 != (IntensityDataWidth % 4))
+    {
+        return 0;
+    }
+
+    uint32_t SymbolsPerNibble = (OneToOne) ? 4 : 2;
+    uint32_t BitsPerSymbol    = (OneToOne) ? 1 : 2;
+    uint32_t SymbolMask       = (OneToOne) ? 0x1 : 0x3;
+
+    for (uint32_t Nibble = 0; Nibble < UART_SYMBOLS_NIBBLE_TABLE_SIZE; ++Nibble)
+    {
+        uint32_t Symbols = 0;
+        for (uint32_t SymbolIndex = 0; SymbolIndex < SymbolsPerNibble; ++SymbolIndex)
+        {
+            uint32_t NumBitsToShift = 4 - (BitsPerSymbol * (SymbolIndex + 1));
+            Symbols |= uint32_t (Intensity2Uart[(Nibble >> NumBitsToShift) & SymbolMask]) << (8 * SymbolIndex);
+        }
+        Nibble2UartSymbols[Nibble] = Symbols;
+    }
+
+    return SymbolsPerNibble;
+
+} // UartSymbolsBuildNibbleTable
+
+//----------------------------------------------------------------------------
+/*
+    One table lookup per nibble, most significant nibble first.
+    Returns the number of bytes written to pUartData.
+*/
+inline __attribute__((always_inline)) size_t UartSymbolsTranslateByNibble (uint32_t         IntensityValue,
+                                                                           size_t           IntensityDataWidth,
+                                                                           const uint32_t * Nibble2UartSymbols,
+                                                                           uint32_t         NumUartSymbolsPerNibble,
+                                                                           uint8_t *        pUartData)
+{
+    uint8_t * pCurrentUartData = pUartData;
+
+    for (int32_t NumBitsToShift = int32_t (IntensityDataWidth) - 4;
+         0 <= NumBitsToShift;
+         NumBitsToShift -= 4)
+    {
+        uint32_t Symbols = Nibble2UartSymbols[(IntensityValue >> NumBitsToShift) & 0xF];
+        *pCurrentUartData++ = uint8_t (Symbols);
+        *pCurrentUartData++ = uint8_t (Symbols >> 8);
+        if (4 == NumUartSymbolsPerNibble)
+        {
+            *pCurrentUartData++ = uint8_t (Symbols >> 16);
+            *pCurrentUartData++ = uint8_t (Symbols >> 24);
+        }
+    }
+
+    return size_t (pCurrentUartData - pUartData);
+
+} // UartSymbolsTranslateByNibble
+
+//----------------------------------------------------------------------------
+/*
+    Reference translation one bit (1:1) or bit pair (2:1) at a time. Used
+    for data widths the nibble table cannot handle and to check the table.
+    TxIntensityDataStartingMask is the mask of the first bit for 1:1 and
+    the data width for 2:1.
+*/
+inline __attribute__((always_inline)) size_t UartSymbolsTranslateBitByBit (uint32_t        IntensityValue,
+                                                                           bool            OneToOne,
+                                                                           uint32_t        TxIntensityDataStartingMask,
+                                                                           const uint8_t * Intensity2Uart,
+                                                                           uint8_t *       pUartData)
+{
+    uint8_t * pCurrentUartData = pUartData;
+
+    if (OneToOne)
+    {
+        for (uint32_t mask = TxIntensityDataStartingMask; 0 != mask; mask >>= 1)
+        {
+            *pCurrentUartData++ = Intensity2Uart[(IntensityValue & mask) ? 1 : 0];
+        }
+    } // end 1:1
+
+    else // 2:1
+    {
+        // Mask is used as a shift counter that is decremented by 2.
+        for (uint32_t NumBitsToShift = TxIntensityDataStartingMask - 2;
+             0 < NumBitsToShift;
+             NumBitsToShift -= 2)
+        {
+            *pCurrentUartData++ = Intensity2Uart[(IntensityValue >> NumBitsToShift) & 0x3];
+        }
+        // handle the last two bits
+        *pCurrentUartData++ = Intensity2Uart[IntensityValue & 0x3];
+    } // end 2:1
+
+    return size_t (pCurrentUartData - pUartData);
+
+} // UartSymbolsTranslateBitByBit
@@ -0,0 +1,49 @@
+#pragma once
+/*
+* OutputWS2811I2s.h - WS2811 driver code for ESPixelStick I2S parallel lane
+*
+* Project: ESPixelStick - An ESP8266 / ESP32 and E1.31 based pixel driver
+* Copyright (c) 2015, 2022 Shelby Merrick
+* http://www.forkineye.com
+*
+*  This program is provided free for you to use in any way that you wish,
+*  subject to the laws and regulations where you are using it.  Due diligence
+*  is strongly suggested before using this code.  Please give credit where due.
+*
+*  The Author makes no warranty of any kind, express or implied, with regard
+*  to this program or the documentation contained in this document.  The
+*  Author shall not be liable in any event for incidental or consequential
+*  damages in connection with, or arising out of, the furnishing, performance
+*  or use of these programs.
+*
+*   This is a derived class that converts data in the output buffer into
+*   pixel intensities and hands them to the shared I2S parallel engine.
+*
+*/
+#include "../ESPixelStick.h"
+#if defined(SUPPORT_OutputType_WS2811) && defined(SUPPORT_I2S_OUTPUT)
+
+#include "OutputWS2811.hpp"
+#include "OutputI2s.hpp"
+
+class c_OutputWS2811I2s : public c_OutputWS2811
+{
+public:
+    // These functions are inherited from c_OutputCommon
+    c_OutputWS2811I2s (c_OutputMgr::e_OutputChannelIds OutputChannelId,
+        gpio_num_t outputGpio,
+        uart_port_t uart,
+        c_OutputMgr::e_OutputType outputType);
+    virtual ~c_OutputWS2811I2s ();
+
+    // functions to be provided by the derived class
+    void    Begin ();                                         ///< set up the operating environment based on the current config (or defaults)
+    bool    SetConfig (ArduinoJson::JsonObject& jsonConfig);  ///< Set a new config in the driver
+    void    Render ();                                        ///< Call from loop (),  renders output data
+    void    GetStatus (ArduinoJson::JsonObject& jsonStatus);
+    void    PauseOutput (bool State) {c_OutputWS2811::PauseOutput (State); OutputI2s.PauseOutput (State);}
+    void    SetOutputBufferSize (uint16_t NumChannelsAvailable);
+
+}; // c_OutputWS2811I2s
+
+#endif // defined(SUPPORT_OutputType_WS2811) && defined(SUPPORT_I2S_OUTPUT)
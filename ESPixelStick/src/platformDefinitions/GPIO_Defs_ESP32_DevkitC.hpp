@@ -31,6 +31,14 @@
 #define DEFAULT_RMT_3_GPIO      gpio_num_t::GPIO_NUM_33
 #define RMT_LAST                OutputChannelId_RMT_4
 
+// I2S parallel output. Each lane is one WS2811 string. Up to 16 lanes.
+#define SUPPORT_I2S_OUTPUT
+#define DEFAULT_I2S_0_GPIO      gpio_num_t::GPIO_NUM_21
+#define DEFAULT_I2S_1_GPIO      gpio_num_t::GPIO_NUM_22
+#define DEFAULT_I2S_2_GPIO      gpio_num_t::GPIO_NUM_25
+#define DEFAULT_I2S_3_GPIO      gpio_num_t::GPIO_NUM_26
+#define I2S_LAST                OutputChannelId_I2S_4
+
 // SPI Output
 #define SUPPORT_SPI_OUTPUT
 #define DEFAULT_SPI_DATA_GPIO   gpio_num_t::GPIO_NUM_16
@@ -60,6 +68,6 @@
 #define SUPPORT_OutputType_UCS1903          // UART / RMT
 #define SUPPORT_OutputType_UCS8903          // UART / RMT
 #define SUPPORT_OutputType_WS2801           // SPI
-#define SUPPORT_OutputType_WS2811           // UART / RMT
+#define SUPPORT_OutputType_WS2811           // UART / RMT / I2S
 #define SUPPORT_OutputType_Relay            // GPIO
 #define SUPPORT_OutputType_Servo_PCA9685    // I2C (default pins)
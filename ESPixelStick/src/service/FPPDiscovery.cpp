@@ -403,7 +403,9 @@ void c_FPPDiscovery::ProcessBlankPacket ()
 
     if (IsEnabled)
     {
+        OutputMgr.BeginDirectWrite ();
         memset (OutputMgr.GetBufferAddress(), 0x0, OutputMgr.GetBufferUsedSize ());
+        OutputMgr.EndDirectWrite ();
     }
     // DEBUG_END;
 } // ProcessBlankPacket
@@ -603,6 +603,13 @@ function ProcessModeConfigurationDataRelay(RelayConfig)
 
     let ChannelConfigs = RelayConfig.channels;
 
+    if ({}.hasOwnProperty.call(RelayConfig, "fadetime")) {
+        $("#fadetimegroup").removeClass("hidden");
+    }
+    else {
+        $("#fadetimegroup").addClass("hidden");
+    }
+
     let HasPwmFrequency = false;
     if ({}.hasOwnProperty.call(ChannelConfigs[0], "Frequency")) {
         HasPwmFrequency = true;
@@ -674,8 +681,9 @@ function ProcessModeConfigurationDataServoPCA9685(ServoConfig)
         let MaxLevelPattern = '<td><input type="number"   id="ServoMaxLevel_'                + (CurrentRowId) + '"step="1" min="10" max="4095"  value="0"  class="form-control is-valid"></td>';
         let RestingPattern  = '<td><input type="number"   id="ServoHomeValue_'               + (CurrentRowId) + '"step="1" min="0"  max="255"   value="0"  class="form-control is-valid"></td>';
         let DataType        = '<td><select class="form-control is-valid" id="ServoDataType_' + (CurrentRowId) + '" title="Effect to generate"></select></td>';
+        let VelocityPattern = '<td><input type="number"   id="ServoVelocityLimit_'           + (CurrentRowId) + '"step="1" min="0"  max="65535" value="0"  class="form-control is-valid" title="Fastest pulse width change when smoothing. 0 = no limit"></td>';
         
-        let rowPattern = '<tr>' + ChanIdPattern + EnabledPattern + MinLevelPattern + MaxLevelPattern + DataType + RestingPattern + '</tr>';
+        let rowPattern = '<tr>' + ChanIdPattern + EnabledPattern + MinLevelPattern + MaxLevelPattern + DataType + RestingPattern + VelocityPattern + '</tr>';
 
         $('#servo_pca9685channelconfigurationtable tr:last').after(rowPattern);
 
@@ -685,6 +693,7 @@ function ProcessModeConfigurationDataServoPCA9685(ServoConfig)
         $('#ServoMaxLevel_'  + CurrentRowId).attr('style', $('#ServoMaxLevel_hr').attr('style'));
         $('#ServoHomeValue_' + CurrentRowId).attr('style', $('#ServoHomeValue_hr').attr('style'));
         $('#ServoDataType_'  + CurrentRowId).attr('style', $('#ServoDataType_hr').attr('style'));
+        $('#ServoVelocityLimit_' + CurrentRowId).attr('style', $('#ServoVelocityLimit_hr').attr('style'));
     }
 
     $.each(ChannelConfigs, function (i, CurrentChannelConfig) {
@@ -695,6 +704,7 @@ function ProcessModeConfigurationDataServoPCA9685(ServoConfig)
         $('#ServoMinLevel_'  + (currentChannelRowId)).val(CurrentChannelConfig.Min);
         $('#ServoMaxLevel_'  + (currentChannelRowId)).val(CurrentChannelConfig.Max);
         $('#ServoHomeValue_' + (currentChannelRowId)).val(CurrentChannelConfig.hv);
+        $('#ServoVelocityLimit_' + (currentChannelRowId)).val(CurrentChannelConfig.vmax);
 
         let jqSelector = "#ServoDataType_" + (currentChannelRowId);
 
@@ -1100,6 +1110,12 @@ function ExtractChannelConfigFromHtmlPage(JsonConfig, SectionName)
         if ((ChannelConfig.type === "Relay") && ($("#relaychannelconfigurationtable").length))
         {
             ChannelConfig.updateinterval = parseInt($('#updateinterval').val(), 10);
+            ChannelConfig.keepalive = parseInt($('#keepalive').val(), 10);
+            ChannelConfig.gamma = parseFloat($('#gamma').val());
+            ChannelConfig.pwmbits = parseInt($('#pwmbits').val(), 10);
+            if ({}.hasOwnProperty.call(ChannelConfig, "fadetime")) {
+                ChannelConfig.fadetime = parseInt($('#fadetime').val(), 10);
+            }
             $.each(ChannelConfig.channels, function (i, CurrentChannelConfig) {
                 // console.info("Current Channel Id = " + CurrentChannelConfig.id);
                 let currentChannelRowId = CurrentChannelConfig.id + 1;
@@ -1109,7 +1125,7 @@ function ExtractChannelConfigFromHtmlPage(JsonConfig, SectionName)
                 CurrentChannelConfig.gid  = parseInt($('#gpioId_' + (currentChannelRowId)).val(), 10);
                 CurrentChannelConfig.trig = parseInt($('#threshhold_' + (currentChannelRowId)).val(), 10);
 
-                if ({}.hasOwnProperty.call(ChannelConfig, "Frequency")) {
+                if ({}.hasOwnProperty.call(CurrentChannelConfig, "Frequency")) {
                     CurrentChannelConfig.Frequency = parseInt($('#Frequency_' + (currentChannelRowId)).val(), 10);
 				}
             });
@@ -1117,6 +1133,10 @@ function ExtractChannelConfigFromHtmlPage(JsonConfig, SectionName)
         else if ((ChannelConfig.type === "Servo PCA9685") && ($("#servo_pca9685channelconfigurationtable").length))
         {
             ChannelConfig.updateinterval = parseInt($('#updateinterval').val(), 10);
+            ChannelConfig.keepalive = parseInt($('#keepalive').val(), 10);
+            ChannelConfig.boards = parseInt($('#boards').val(), 10);
+            ChannelConfig.smoothing = parseInt($('#smoothing').val(), 10);
+            ChannelConfig.steprate = parseInt($('#steprate').val(), 10);
             $.each(ChannelConfig.channels, function (i, CurrentChannelConfig) {
                 // console.info("Current Channel Id = " + CurrentChannelConfig.id);
                 let currentChannelRowId  = CurrentChannelConfig.id + 1;
@@ -1124,6 +1144,7 @@ function ExtractChannelConfigFromHtmlPage(JsonConfig, SectionName)
                 CurrentChannelConfig.Min = parseInt($('#ServoMinLevel_'  + (currentChannelRowId)).val(), 10);
                 CurrentChannelConfig.Max = parseInt($('#ServoMaxLevel_'  + (currentChannelRowId)).val(), 10);
                 CurrentChannelConfig.hv  = parseInt($('#ServoHomeValue_' + (currentChannelRowId)).val(), 10);
+                CurrentChannelConfig.vmax = parseInt($('#ServoVelocityLimit_' + (currentChannelRowId)).val(), 10);
                 let ServoDataType        = parseInt($('#ServoDataType_'  + (currentChannelRowId)).val(), 10);
 
                 CurrentChannelConfig.rev = (ServoDataType & 0x01) ? true : false;
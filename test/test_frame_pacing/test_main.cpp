@@ -0,0 +1,137 @@
+/*
+* test_main.cpp - Host checks for the output frame pacing
+*
+* Project: ESPixelStick - An ESP8266 / ESP32 and E1.31 based pixel driver
+* Copyright (c) 2022 Shelby Merrick
+* http://www.forkineye.com
+*
+*  This program is provided free for you to use in any way that you wish,
+*  subject to the laws and regulations where you are using it.  Due diligence
+*  is strongly suggested before using this code.  Please give credit where due.
+*
+*  The Author makes no warranty of any kind, express or implied, with regard
+*  to this program or the documentation contained in this document.  The
+*  Author shall not be liable in any event for incidental or consequential
+*  damages in connection with, or arising out of, the furnishing, performance
+*  or use of these programs.
+*
+*   The frame time comes from the wire time and the target refresh rate.
+*   The statistics are fed simulated frame start times.
+*
+*   pio test -e native -f test_frame_pacing -v
+*
+*/
+
+#include <unity.h>
+#include "OutputFramePacing.hpp"
+
+// WS2811 at 800KHz with the 300us reset used by c_OutputPixel
+#define TEST_WS2811_BIT_TIME_US     1.25
+#define TEST_WS2811_RESET_US        300
+
+//----------------------------------------------------------------------------
+void setUp ()
+{
+} // setUp
+
+//----------------------------------------------------------------------------
+void tearDown ()
+{
+} // tearDown
+
+//----------------------------------------------------------------------------
+static uint32_t WS2811WireTime (uint32_t NumPixels)
+{
+    return FramePacingWireTimeInMicroSec (float (NumPixels * 3), 8.0, TEST_WS2811_BIT_TIME_US, TEST_WS2811_RESET_US, 1, 0.0);
+
+} // WS2811WireTime
+
+//----------------------------------------------------------------------------
+void test_wire_time ()
+{
+    // 50 pixels: 1200 bits at 1.25us plus the reset
+    TEST_ASSERT_EQUAL_UINT32 (1800, WS2811WireTime (50));
+
+    // 680 pixels: 16320 bits at 1.25us plus the reset
+    TEST_ASSERT_EQUAL_UINT32 (20700, WS2811WireTime (680));
+
+    // a 10us pause after every 3 bytes of a 30 byte frame
+    TEST_ASSERT_EQUAL_UINT32 (uint32_t (240 * TEST_WS2811_BIT_TIME_US) + TEST_WS2811_RESET_US + 100,
+                              FramePacingWireTimeInMicroSec (30.0, 8.0, TEST_WS2811_BIT_TIME_US, TEST_WS2811_RESET_US, 3, 10.0));
+
+    // a block size of 0 is treated as 1
+    TEST_ASSERT_EQUAL_UINT32 (FramePacingWireTimeInMicroSec (30.0, 8.0, 1.0, 0, 1, 2.0),
+                              FramePacingWireTimeInMicroSec (30.0, 8.0, 1.0, 0, 0, 2.0));
+
+} // test_wire_time
+
+//----------------------------------------------------------------------------
+void test_short_strings_are_not_capped_at_40fps ()
+{
+    uint32_t WireTime = WS2811WireTime (50);
+
+    // as fast as the wire allows
+    TEST_ASSERT_EQUAL_UINT32 (WireTime, FramePacingDurationInMicroSec (WireTime, 0));
+
+    // the target rate sets the pace when the wire is faster
+    TEST_ASSERT_EQUAL_UINT32 (8333, FramePacingDurationInMicroSec (WireTime, 120));
+    TEST_ASSERT_EQUAL_UINT32 (25000, FramePacingDurationInMicroSec (WireTime, 40));
+
+    // the wire time is the floor when the target rate asks for too much
+    TEST_ASSERT_EQUAL_UINT32 (WS2811WireTime (680), FramePacingDurationInMicroSec (WS2811WireTime (680), 120));
+
+} // test_short_strings_are_not_capped_at_40fps
+
+//----------------------------------------------------------------------------
+void test_achieved_rate_and_jitter ()
+{
+    c_FramePacingStats Stats;
+    uint32_t FrameDuration = FramePacingDurationInMicroSec (WS2811WireTime (50), 120);
+    uint32_t Now = 0;
+
+    // two seconds of frames that each start 10us late
+    for (uint32_t FrameCount = 0; FrameCount < 240; ++FrameCount)
+    {
+        Now += FrameDuration + 10;
+        Stats.FrameStarted (Now, FrameDuration + 10, FrameDuration, 0 != FrameCount);
+    }
+
+    TEST_ASSERT_UINT32_WITHIN (1, 120, Stats.AchievedRefreshRate);
+    TEST_ASSERT_EQUAL_UINT32 (0,  Stats.MissedDeadlines);
+    TEST_ASSERT_EQUAL_UINT32 (10, Stats.LastFrameStartJitterInMicroSec);
+    TEST_ASSERT_EQUAL_UINT32 (10, Stats.MaxFrameStartJitterInMicroSec);
+
+} // test_achieved_rate_and_jitter
+
+//----------------------------------------------------------------------------
+void test_missed_deadlines ()
+{
+    c_FramePacingStats Stats;
+    uint32_t FrameDuration = 10000;
+
+    // on time, late but inside half a period, then two frames that slipped a whole period
+    Stats.FrameStarted (10000, 10000, FrameDuration, true);
+    Stats.FrameStarted (24000, 14000, FrameDuration, true);
+    Stats.FrameStarted (44000, 20000, FrameDuration, true);
+    Stats.FrameStarted (64000, 20000, FrameDuration, true);
+
+    TEST_ASSERT_EQUAL_UINT32 (2,    Stats.MissedDeadlines);
+    TEST_ASSERT_EQUAL_UINT32 (4000, Stats.MaxFrameStartJitterInMicroSec);
+
+    // hold mode kept this frame back on purpose
+    Stats.FrameStarted (94000, 30000, FrameDuration, false);
+    TEST_ASSERT_EQUAL_UINT32 (2,    Stats.MissedDeadlines);
+
+} // test_missed_deadlines
+
+//----------------------------------------------------------------------------
+int main (int, char **)
+{
+    UNITY_BEGIN ();
+    RUN_TEST (test_wire_time);
+    RUN_TEST (test_short_strings_are_not_capped_at_40fps);
+    RUN_TEST (test_achieved_rate_and_jitter);
+    RUN_TEST (test_missed_deadlines);
+    return UNITY_END ();
+
+} // main
@@ -0,0 +1,253 @@
+/*
+* test_main.cpp - Host check that the I2S lanes send the same WS2811 bits as RMT
+*
+* Project: ESPixelStick - An ESP8266 / ESP32 and E1.31 based pixel driver
+* Copyright (c) 2022 Shelby Merrick
+* http://www.forkineye.com
+*
+*  This program is provided free for you to use in any way that you wish,
+*  subject to the laws and regulations where you are using it.  Due diligence
+*  is strongly suggested before using this code.  Please give credit where due.
+*
+*  The Author makes no warranty of any kind, express or implied, with regard
+*  to this program or the documentation contained in this document.  The
+*  Author shall not be liable in any event for incidental or consequential
+*  damages in connection with, or arising out of, the furnishing, performance
+*  or use of these programs.
+*
+*   The same intensity data is encoded for 16 I2S lanes and, one lane at a
+*   time, as the RMT item stream c_OutputWS2811Rmt sends. Both waveforms are
+*   decoded back into high time and bit period per bit. The decoded bits
+*   must match the data, every high time must be inside the WS2811 datasheet
+*   window and both outputs must use the same bit period.
+*
+*   pio test -e native -f test_i2s_vs_rmt -v
+*
+*/
+
+#include <unity.h>
+#include <vector>
+#include "OutputI2sTranspose.hpp"
+#include "OutputRmtItems.hpp"
+
+// WS2811 at 800KHz, as in OutputWS2811.hpp. +/- 150ns per datasheet.
+#define TEST_WS2811_NS_BIT_TOTAL        1250.0
+#define TEST_WS2811_NS_BIT_0_HIGH       250.0
+#define TEST_WS2811_NS_BIT_1_HIGH       600.0
+#define TEST_WS2811_NS_TOLERANCE        150.0
+
+// RMT: 80MHz APB clock, divisor 2. Same tick counts as OutputWS2811Rmt.cpp
+#define TEST_RMT_TICK_NS                25.0
+#define TEST_RMT_ITEM(d0, l0, d1, l1)   (uint32_t (d0) | (uint32_t (l0) << 15) | (uint32_t (d1) << 16) | (uint32_t (l1) << 31))
+#define TEST_RMT_ZERO_BIT               TEST_RMT_ITEM (TEST_WS2811_NS_BIT_0_HIGH / TEST_RMT_TICK_NS, 1, (TEST_WS2811_NS_BIT_TOTAL - TEST_WS2811_NS_BIT_0_HIGH) / TEST_RMT_TICK_NS, 0)
+#define TEST_RMT_ONE_BIT                TEST_RMT_ITEM ((TEST_WS2811_NS_BIT_1_HIGH / TEST_RMT_TICK_NS) - 1.0, 1, ((TEST_WS2811_NS_BIT_TOTAL - TEST_WS2811_NS_BIT_1_HIGH) / TEST_RMT_TICK_NS) + 1.0, 0)
+
+// I2S: 3.2MHz slot clock
+#define TEST_I2S_SLOT_NS                312.5
+
+#define TEST_NUM_INTENSITIES            (50 * 3)
+
+struct TestRmtItem_t
+{
+    uint32_t val;
+};
+
+// one bit as seen on the wire
+struct TestWireBit_t
+{
+    double HighNs;
+    double PeriodNs;
+};
+
+//----------------------------------------------------------------------------
+static bool DecodeBit (const TestWireBit_t & WireBit)
+{
+    // the decision point the WS2811 uses is between the two high times
+    return WireBit.HighNs > ((TEST_WS2811_NS_BIT_0_HIGH + TEST_WS2811_NS_BIT_1_HIGH) / 2.0);
+
+} // DecodeBit
+
+//----------------------------------------------------------------------------
+/*
+    Encode every intensity for all 16 lanes and decode the waveform of one
+    lane. Lanes that are not in ActiveLanes must stay low.
+*/
+static void DecodeI2sLane (const std::vector<uint8_t> * LaneData, uint16_t ActiveLanes, uint32_t Lane, std::vector<TestWireBit_t> & WireBits)
+{
+    for (size_t IntensityIndex = 0; IntensityIndex < TEST_NUM_INTENSITIES; ++IntensityIndex)
+    {
+        uint8_t  LaneIntensities[I2S_MAX_LANES];
+        uint16_t DmaWords[I2S_WORDS_PER_INTENSITY];
+
+        for (uint32_t CurrentLane = 0; CurrentLane < I2S_MAX_LANES; ++CurrentLane)
+        {
+            LaneIntensities[CurrentLane] = LaneData[CurrentLane][IntensityIndex];
+        }
+        I2sEncodeIntensity (LaneIntensities, ActiveLanes, DmaWords);
+
+        for (uint32_t BitIndex = 0; BitIndex < I2S_BITS_PER_INTENSITY; ++BitIndex)
+        {
+            TestWireBit_t WireBit = {0.0, 0.0};
+            bool          StillHigh = true;
+            for (uint32_t Slot = 0; Slot < I2S_SLOTS_PER_BIT; ++Slot)
+            {
+                uint32_t SlotIndex = (BitIndex * I2S_SLOTS_PER_BIT) + Slot;
+                bool     LaneIsHigh = 0 != (DmaWords[I2S_DMA_WORD_INDEX (SlotIndex)] & (1 << Lane));
+
+                // a WS2811 bit is one high pulse followed by low
+                TEST_ASSERT_FALSE (LaneIsHigh && !StillHigh);
+                StillHigh = StillHigh && LaneIsHigh;
+                WireBit.HighNs   += (StillHigh) ? TEST_I2S_SLOT_NS : 0.0;
+                WireBit.PeriodNs += TEST_I2S_SLOT_NS;
+            }
+            WireBits.push_back (WireBit);
+        }
+    }
+
+} // DecodeI2sLane
+
+//----------------------------------------------------------------------------
+static void DecodeRmt (const std::vector<uint8_t> & Data, std::vector<TestWireBit_t> & WireBits)
+{
+    uint32_t Nibble2Rmt[RMT_NUM_NIBBLE_VALUES][RMT_ITEMS_PER_NIBBLE];
+    RmtBuildNibbleTable (TEST_RMT_ONE_BIT, TEST_RMT_ZERO_BIT, Nibble2Rmt);
+
+    // big enough that the ring never wraps
+    std::vector<TestRmtItem_t> Items (Data.size () * 8);
+    volatile TestRmtItem_t *   pStart   = &Items[0];
+    volatile TestRmtItem_t *   pEnd     = &Items[Items.size () - 1];
+    volatile TestRmtItem_t *   pCurrent = pStart;
+    volatile size_t            NumAvailableSlotsToFill = Items.size ();
+
+    for (uint8_t Intensity : Data)
+    {
+        RmtEnqueueIntensityByNibble (pCurrent, pStart, pEnd, NumAvailableSlotsToFill, Intensity, 8 - RMT_ITEMS_PER_NIBBLE, Nibble2Rmt);
+    }
+
+    for (const TestRmtItem_t & Item : Items)
+    {
+        uint32_t Duration0 = Item.val & 0x7FFF;
+        uint32_t Level0    = (Item.val >> 15) & 0x1;
+        uint32_t Duration1 = (Item.val >> 16) & 0x7FFF;
+        uint32_t Level1    = (Item.val >> 31) & 0x1;
+
+        TEST_ASSERT_EQUAL (1, Level0);
+        TEST_ASSERT_EQUAL (0, Level1);
+        WireBits.push_back ({Duration0 * TEST_RMT_TICK_NS, (Duration0 + Duration1) * TEST_RMT_TICK_NS});
+    }
+
+} // DecodeRmt
+
+//----------------------------------------------------------------------------
+static void CheckWs2811Timing (const TestWireBit_t & WireBit, bool BitValue)
+{
+    double HighNs = (BitValue) ? TEST_WS2811_NS_BIT_1_HIGH : TEST_WS2811_NS_BIT_0_HIGH;
+
+    TEST_ASSERT_TRUE (WireBit.HighNs >= (HighNs - TEST_WS2811_NS_TOLERANCE));
+    TEST_ASSERT_TRUE (WireBit.HighNs <= (HighNs + TEST_WS2811_NS_TOLERANCE));
+    TEST_ASSERT_TRUE (WireBit.PeriodNs == TEST_WS2811_NS_BIT_TOTAL);
+
+} // CheckWs2811Timing
+
+//----------------------------------------------------------------------------
+void setUp ()
+{
+} // setUp
+
+//----------------------------------------------------------------------------
+void tearDown ()
+{
+} // tearDown
+
+//----------------------------------------------------------------------------
+void test_i2s_lanes_match_rmt ()
+{
+    std::vector<uint8_t> LaneData[I2S_MAX_LANES];
+    uint32_t Seed = 0x1252;
+    for (std::vector<uint8_t> & Data : LaneData)
+    {
+        for (size_t IntensityIndex = 0; IntensityIndex < TEST_NUM_INTENSITIES; ++IntensityIndex)
+        {
+            Seed = (Seed * 1664525) + 1013904223;
+            Data.push_back (uint8_t (Seed >> 24));
+        }
+    }
+    // the extremes on the first two lanes
+    for (size_t IntensityIndex = 0; IntensityIndex < TEST_NUM_INTENSITIES; ++IntensityIndex)
+    {
+        LaneData[0][IntensityIndex] = 0x00;
+        LaneData[1][IntensityIndex] = 0xFF;
+    }
+
+    static const uint16_t ActiveLaneSets[] = {0xFFFF, 0x0001, 0x8000, 0x5A5A};
+    for (uint16_t ActiveLanes : ActiveLaneSets)
+    {
+        for (uint32_t Lane = 0; Lane < I2S_MAX_LANES; ++Lane)
+        {
+            std::vector<TestWireBit_t> I2sBits;
+            DecodeI2sLane (LaneData, ActiveLanes, Lane, I2sBits);
+
+            if (0 == (ActiveLanes & (1 << Lane)))
+            {
+                // an idle lane never goes high
+                for (const TestWireBit_t & WireBit : I2sBits)
+                {
+                    TEST_ASSERT_TRUE (0.0 == WireBit.HighNs);
+                }
+                continue;
+            }
+
+            std::vector<TestWireBit_t> RmtBits;
+            DecodeRmt (LaneData[Lane], RmtBits);
+            TEST_ASSERT_EQUAL (RmtBits.size (), I2sBits.size ());
+
+            for (size_t BitIndex = 0; BitIndex < I2sBits.size (); ++BitIndex)
+            {
+                bool BitValue = 0 != (LaneData[Lane][BitIndex / 8] & (0x80 >> (BitIndex % 8)));
+
+                TEST_ASSERT_EQUAL (BitValue, DecodeBit (RmtBits[BitIndex]));
+                TEST_ASSERT_EQUAL (BitValue, DecodeBit (I2sBits[BitIndex]));
+                CheckWs2811Timing (RmtBits[BitIndex], BitValue);
+                CheckWs2811Timing (I2sBits[BitIndex], BitValue);
+            }
+        }
+    }
+
+} // test_i2s_lanes_match_rmt
+
+//----------------------------------------------------------------------------
+void test_transpose_matches_reference ()
+{
+    uint32_t Seed = 0x0812;
+    for (uint32_t count = 0; count < 10000; ++count)
+    {
+        uint8_t LaneIntensities[I2S_MAX_LANES];
+        for (uint8_t & Intensity : LaneIntensities)
+        {
+            Seed = (Seed * 1664525) + 1013904223;
+            Intensity = uint8_t (Seed >> 24);
+        }
+        uint16_t ActiveLanes = uint16_t (Seed >> 8);
+
+        uint16_t DmaWords[I2S_WORDS_PER_INTENSITY];
+        uint16_t ReferenceWords[I2S_WORDS_PER_INTENSITY];
+        I2sEncodeIntensity (LaneIntensities, ActiveLanes, DmaWords);
+        I2sEncodeIntensityReference (LaneIntensities, ActiveLanes, ReferenceWords);
+
+        for (uint32_t WordIndex = 0; WordIndex < I2S_WORDS_PER_INTENSITY; ++WordIndex)
+        {
+            TEST_ASSERT_EQUAL_UINT16 (ReferenceWords[WordIndex], DmaWords[WordIndex]);
+        }
+    }
+
+} // test_transpose_matches_reference
+
+//----------------------------------------------------------------------------
+int main (int, char **)
+{
+    UNITY_BEGIN ();
+    RUN_TEST (test_i2s_lanes_match_rmt);
+    RUN_TEST (test_transpose_matches_reference);
+    return UNITY_END ();
+
+} // main
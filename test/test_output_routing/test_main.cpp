@@ -0,0 +1,253 @@
+/*
+* test_main.cpp - Host checks and benchmark for the output routing table
+*
+* Project: ESPixelStick - An ESP8266 / ESP32 and E1.31 based pixel driver
+* Copyright (c) 2022 Shelby Merrick
+* http://www.forkineye.com
+*
+*  This program is provided free for you to use in any way that you wish,
+*  subject to the laws and regulations where you are using it.  Due diligence
+*  is strongly suggested before using this code.  Please give credit where due.
+*
+*  The Author makes no warranty of any kind, express or implied, with regard
+*  to this program or the documentation contained in this document.  The
+*  Author shall not be liable in any event for incidental or consequential
+*  damages in connection with, or arising out of, the furnishing, performance
+*  or use of these programs.
+*
+*   RoutingTableFind must return the output that owns every channel no
+*   matter which entry the previous write used. The benchmark feeds E1.31
+*   sized writes through the routed walk used by c_OutputMgr and through
+*   the linear scan over every output it replaced, for 1, 8 and 16 outputs.
+*
+*   pio test -e native -f test_output_routing -v
+*
+*/
+
+#include <unity.h>
+#include <chrono>
+#include <vector>
+#include <string.h>
+#include <stdio.h>
+#include "OutputRoutingTable.hpp"
+
+#define TEST_CHANNELS_PER_OUTPUT    (680 * 3)
+#define TEST_CHANNELS_PER_WRITE     510
+#define TEST_BENCHMARK_FRAMES       2000
+
+//----------------------------------------------------------------------------
+// The parts of c_OutputMgr::DriverInfo_t and c_OutputCommon the walk uses
+struct TestOutput_t
+{
+    size_t               StartingChannelId = 0;
+    size_t               ChannelCount      = 0;
+    size_t               EndChannelId      = 0;
+    bool                 BackBufferUpdated = false;
+    std::vector<uint8_t> BackBuffer;
+
+    bool WriteChannelData (size_t StartChannelId, size_t ChannelCount, const uint8_t * pSourceData)
+    {
+        bool response = (0 != memcmp (&BackBuffer[StartChannelId], pSourceData, ChannelCount));
+        if (response)
+        {
+            memcpy (&BackBuffer[StartChannelId], pSourceData, ChannelCount);
+        }
+        return response;
+    }
+};
+
+class c_TestOutputs
+{
+public:
+    c_TestOutputs (size_t NumOutputs) : Outputs (NumOutputs)
+    {
+        size_t StartingChannelId = 0;
+        for (TestOutput_t & Output : Outputs)
+        {
+            Output.StartingChannelId = StartingChannelId;
+            Output.ChannelCount      = TEST_CHANNELS_PER_OUTPUT;
+            Output.EndChannelId      = StartingChannelId + TEST_CHANNELS_PER_OUTPUT;
+            Output.BackBuffer.assign (TEST_CHANNELS_PER_OUTPUT, 0);
+            RoutingTable.push_back (&Output);
+            StartingChannelId = Output.EndChannelId;
+        }
+        UsedBufferSize = StartingChannelId;
+    }
+
+    // same walk as c_OutputMgr::WriteChannelData
+    void WriteRouted (size_t StartChannelId, size_t ChannelCount, const uint8_t * pSourceData)
+    {
+        size_t EndChannelId = StartChannelId + ChannelCount;
+        size_t RoutingTableIndex = LastRoutingTableIndex;
+        RoutingTableFind (RoutingTable.data (), RoutingTable.size (), StartChannelId, RoutingTableIndex);
+        LastRoutingTableIndex = RoutingTableIndex;
+
+        while ((StartChannelId < EndChannelId) && (RoutingTableIndex < RoutingTable.size ()))
+        {
+            TestOutput_t & Output = *RoutingTable[RoutingTableIndex];
+
+            size_t lastChannelToSet = std::min (EndChannelId, Output.EndChannelId);
+            size_t ChannelsToSet = lastChannelToSet - StartChannelId;
+            if (Output.WriteChannelData (StartChannelId - Output.StartingChannelId, ChannelsToSet, pSourceData))
+            {
+                Output.BackBufferUpdated = true;
+            }
+
+            StartChannelId += ChannelsToSet;
+            pSourceData += ChannelsToSet;
+            ++RoutingTableIndex;
+        }
+    }
+
+    // the scan over every output that the routing table replaced
+    void WriteLinear (size_t StartChannelId, size_t ChannelCount, const uint8_t * pSourceData)
+    {
+        size_t EndChannelId = StartChannelId + ChannelCount;
+        for (TestOutput_t & Output : Outputs)
+        {
+            if (StartChannelId < Output.StartingChannelId)
+            {
+                break;
+            }
+
+            if (StartChannelId > Output.EndChannelId)
+            {
+                continue;
+            }
+
+            size_t lastChannelToSet = std::min (EndChannelId, Output.EndChannelId);
+            size_t ChannelsToSet = lastChannelToSet - StartChannelId;
+            if (ChannelsToSet)
+            {
+                if (Output.WriteChannelData (StartChannelId - Output.StartingChannelId, ChannelsToSet, pSourceData))
+                {
+                    Output.BackBufferUpdated = true;
+                }
+            }
+
+            StartChannelId += ChannelsToSet;
+            pSourceData += ChannelsToSet;
+
+            if (StartChannelId >= EndChannelId)
+            {
+                break;
+            }
+        }
+    }
+
+    std::vector<TestOutput_t>   Outputs;
+    std::vector<TestOutput_t *> RoutingTable;
+    size_t                      LastRoutingTableIndex = 0;
+    size_t                      UsedBufferSize        = 0;
+
+}; // c_TestOutputs
+
+static const size_t TestOutputCounts[] = {1, 8, 16};
+
+//----------------------------------------------------------------------------
+void setUp ()
+{
+} // setUp
+
+//----------------------------------------------------------------------------
+void tearDown ()
+{
+} // tearDown
+
+//----------------------------------------------------------------------------
+void test_find_returns_owner_from_any_previous_entry ()
+{
+    for (size_t NumOutputs : TestOutputCounts)
+    {
+        c_TestOutputs Outputs (NumOutputs);
+
+        for (size_t PreviousIndex = 0; PreviousIndex <= NumOutputs; ++PreviousIndex)
+        {
+            for (size_t ChannelId = 0; ChannelId < Outputs.UsedBufferSize; ChannelId += 7)
+            {
+                size_t Index = PreviousIndex;
+                bool   CacheHit = RoutingTableFind (Outputs.RoutingTable.data (), Outputs.RoutingTable.size (), ChannelId, Index);
+
+                TEST_ASSERT_EQUAL (ChannelId / TEST_CHANNELS_PER_OUTPUT, Index);
+                TEST_ASSERT_EQUAL ((PreviousIndex == Index), CacheHit);
+            }
+        }
+    }
+
+} // test_find_returns_owner_from_any_previous_entry
+
+//----------------------------------------------------------------------------
+void test_unchanged_data_does_not_flag_the_output ()
+{
+    c_TestOutputs Outputs (8);
+    std::vector<uint8_t> Data (Outputs.UsedBufferSize, 0);
+
+    // a write that spans two outputs
+    Data[TEST_CHANNELS_PER_OUTPUT - 1] = 1;
+    Outputs.WriteRouted (TEST_CHANNELS_PER_OUTPUT - 10, 20, &Data[TEST_CHANNELS_PER_OUTPUT - 10]);
+    TEST_ASSERT_TRUE (Outputs.Outputs[0].BackBufferUpdated);
+    TEST_ASSERT_FALSE (Outputs.Outputs[1].BackBufferUpdated);
+
+    Outputs.Outputs[0].BackBufferUpdated = false;
+    Outputs.WriteRouted (TEST_CHANNELS_PER_OUTPUT - 10, 20, &Data[TEST_CHANNELS_PER_OUTPUT - 10]);
+    TEST_ASSERT_FALSE (Outputs.Outputs[0].BackBufferUpdated);
+    TEST_ASSERT_FALSE (Outputs.Outputs[1].BackBufferUpdated);
+
+} // test_unchanged_data_does_not_flag_the_output
+
+//----------------------------------------------------------------------------
+template <typename Writer_t>
+static double MeasureNsPerWrite (c_TestOutputs & Outputs, Writer_t Writer)
+{
+    std::vector<uint8_t> Data (Outputs.UsedBufferSize + TEST_CHANNELS_PER_WRITE);
+    size_t NumWrites = 0;
+
+    auto Start = std::chrono::steady_clock::now ();
+
+    for (uint32_t FrameCount = 0; FrameCount < TEST_BENCHMARK_FRAMES; ++FrameCount)
+    {
+        // every frame carries new data so the copy is always done
+        Data[FrameCount % Data.size ()]++;
+
+        for (size_t ChannelId = 0; ChannelId < Outputs.UsedBufferSize; ChannelId += TEST_CHANNELS_PER_WRITE)
+        {
+            size_t ChannelCount = std::min (size_t (TEST_CHANNELS_PER_WRITE), Outputs.UsedBufferSize - ChannelId);
+            (Outputs.*Writer) (ChannelId, ChannelCount, &Data[ChannelId]);
+            ++NumWrites;
+        }
+    }
+
+    std::chrono::duration<double, std::nano> Elapsed = std::chrono::steady_clock::now () - Start;
+    return Elapsed.count () / double (NumWrites);
+
+} // MeasureNsPerWrite
+
+//----------------------------------------------------------------------------
+void test_benchmark_routed_vs_linear ()
+{
+    for (size_t NumOutputs : TestOutputCounts)
+    {
+        c_TestOutputs Linear (NumOutputs);
+        c_TestOutputs Routed (NumOutputs);
+
+        double LinearNs = MeasureNsPerWrite (Linear, &c_TestOutputs::WriteLinear);
+        double RoutedNs = MeasureNsPerWrite (Routed, &c_TestOutputs::WriteRouted);
+
+        char Message[128];
+        snprintf (Message, sizeof (Message), "%2u outputs  linear %6.1f ns/write  routed %6.1f ns/write  x%.2f",
+                  unsigned (NumOutputs), LinearNs, RoutedNs, LinearNs / RoutedNs);
+        TEST_MESSAGE (Message);
+    }
+
+} // test_benchmark_routed_vs_linear
+
+//----------------------------------------------------------------------------
+int main (int, char **)
+{
+    UNITY_BEGIN ();
+    RUN_TEST (test_find_returns_owner_from_any_previous_entry);
+    RUN_TEST (test_unchanged_data_does_not_flag_the_output);
+    RUN_TEST (test_benchmark_routed_vs_linear);
+    return UNITY_END ();
+
+} // main
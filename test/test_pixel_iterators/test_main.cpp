@@ -0,0 +1,209 @@
+/*
+* test_main.cpp - Host checks and benchmark for the pixel intensity iterators
+*
+* Project: ESPixelStick - An ESP8266 / ESP32 and E1.31 based pixel driver
+* Copyright (c) 2022 Shelby Merrick
+* http://www.forkineye.com
+*
+*  This program is provided free for you to use in any way that you wish,
+*  subject to the laws and regulations where you are using it.  Due diligence
+*  is strongly suggested before using this code.  Please give credit where due.
+*
+*  The Author makes no warranty of any kind, express or implied, with regard
+*  to this program or the documentation contained in this document.  The
+*  Author shall not be liable in any event for incidental or consequential
+*  damages in connection with, or arising out of, the furnishing, performance
+*  or use of these programs.
+*
+*   Every templated iterator must send exactly the same intensities as the
+*   generic state machine. The benchmark reports bytes per second for both.
+*
+*   pio test -e native -f test_pixel_iterators -v
+*
+*/
+
+#include <unity.h>
+#include <chrono>
+#include <vector>
+#include "OutputPixelIterator.hpp"
+
+#define TEST_PIXEL_COUNT        680
+#define TEST_BENCHMARK_FRAMES   2000
+
+//----------------------------------------------------------------------------
+// Exposes the iterator and sets it up the way c_OutputPixel::SetConfig does
+class c_TestIterator : public c_OutputPixelIterator
+{
+public:
+    void Configure (size_t NumBytesPerPixel, size_t ZigSize, size_t GroupSize, uint16_t * pMap)
+    {
+        NumIntensityBytesPerPixel = NumBytesPerPixel;
+        pixel_count               = TEST_PIXEL_COUNT;
+        zig_size                  = ZigSize;
+        PixelGroupSize            = GroupSize;
+        pPixelMap                 = pMap;
+        AdjustedBrightness        = 200;
+
+        ZigPixelCount = (2 > zig_size) ? pixel_count + 1 : zig_size + 1;
+        ZagPixelCount = (2 > zig_size) ? pixel_count + 1 : zig_size + 1;
+
+        // grb order and a table that changes every value
+        ColorOffsets.offset.r = 1;
+        ColorOffsets.offset.g = 0;
+        ColorOffsets.offset.b = 2;
+        ColorOffsets.offset.w = 3;
+        for (uint32_t index = 0; index < sizeof (gamma_table); ++index)
+        {
+            gamma_table[index] = uint8_t (index ^ 0x5A);
+        }
+
+        SelectIntensityIterator ();
+    }
+
+    bool HasFastIterator () { return nullptr != pIntensityIterator; }
+    void UseGenericIterator () { pIntensityIterator = nullptr; }
+
+    size_t SendFrame (uint8_t * pData, size_t DataSize, uint8_t * pOutput)
+    {
+        size_t NumIntensities = 0;
+        StartIterator (pData, DataSize);
+        while (IteratorHasMoreData ())
+        {
+            pOutput[NumIntensities++] = uint8_t (GetNextIteratorIntensity ());
+        }
+        return NumIntensities;
+    }
+
+}; // c_TestIterator
+
+struct TestShape_t
+{
+    const char * Name;
+    size_t       NumBytesPerPixel;
+    size_t       ZigSize;
+    size_t       GroupSize;
+    bool         Mapped;
+};
+
+static const TestShape_t TestShapes[] =
+{
+    {"RGB",                3,  0, 1, false},
+    {"RGB zig zag",        3, 17, 1, false},
+    {"RGB grouped",        3,  0, 4, false},
+    {"RGB zig zag group",  3, 17, 4, false},
+    {"RGB mapped",         3,  0, 1, true },
+    {"RGBW",               4,  0, 1, false},
+    {"RGBW zig zag",       4, 17, 1, false},
+    {"RGBW grouped",       4,  0, 4, false},
+    {"RGBW mapped",        4,  0, 1, true },
+};
+
+static std::vector<uint8_t>  PixelData;
+static std::vector<uint16_t> PixelMap;
+
+//----------------------------------------------------------------------------
+void setUp ()
+{
+    PixelData.resize (TEST_PIXEL_COUNT * 4);
+    for (size_t index = 0; index < PixelData.size (); ++index)
+    {
+        PixelData[index] = uint8_t ((index * 7) + (index >> 8));
+    }
+
+    // a map that is neither the identity nor a simple reverse
+    PixelMap.resize (TEST_PIXEL_COUNT);
+    for (size_t index = 0; index < PixelMap.size (); ++index)
+    {
+        PixelMap[index] = uint16_t ((index * 37) % TEST_PIXEL_COUNT);
+    }
+} // setUp
+
+//----------------------------------------------------------------------------
+void tearDown ()
+{
+} // tearDown
+
+//----------------------------------------------------------------------------
+static void ConfigureShape (c_TestIterator & Iterator, const TestShape_t & Shape)
+{
+    Iterator.Configure (Shape.NumBytesPerPixel, Shape.ZigSize, Shape.GroupSize, (Shape.Mapped) ? PixelMap.data () : nullptr);
+
+} // ConfigureShape
+
+//----------------------------------------------------------------------------
+void test_fast_iterators_match_generic ()
+{
+    for (const TestShape_t & Shape : TestShapes)
+    {
+        c_TestIterator Fast;
+        c_TestIterator Generic;
+        ConfigureShape (Fast, Shape);
+        ConfigureShape (Generic, Shape);
+        Generic.UseGenericIterator ();
+
+        TEST_ASSERT_TRUE_MESSAGE (Fast.HasFastIterator (), Shape.Name);
+
+        size_t ExpectedSize = TEST_PIXEL_COUNT * Shape.GroupSize * Shape.NumBytesPerPixel;
+        std::vector<uint8_t> FastOutput (ExpectedSize + 1);
+        std::vector<uint8_t> GenericOutput (ExpectedSize + 1);
+
+        // two frames so the state is known to rewind correctly
+        for (uint32_t FrameCount = 0; FrameCount < 2; ++FrameCount)
+        {
+            TEST_ASSERT_EQUAL_MESSAGE (ExpectedSize, Fast.SendFrame (PixelData.data (), PixelData.size (), FastOutput.data ()), Shape.Name);
+            TEST_ASSERT_EQUAL_MESSAGE (ExpectedSize, Generic.SendFrame (PixelData.data (), PixelData.size (), GenericOutput.data ()), Shape.Name);
+            TEST_ASSERT_EQUAL_UINT8_ARRAY_MESSAGE (GenericOutput.data (), FastOutput.data (), ExpectedSize, Shape.Name);
+        }
+    }
+
+} // test_fast_iterators_match_generic
+
+//----------------------------------------------------------------------------
+static double MeasureBytesPerSecond (c_TestIterator & Iterator, std::vector<uint8_t> & Output)
+{
+    size_t NumBytes = 0;
+    auto   Start    = std::chrono::steady_clock::now ();
+
+    for (uint32_t FrameCount = 0; FrameCount < TEST_BENCHMARK_FRAMES; ++FrameCount)
+    {
+        NumBytes += Iterator.SendFrame (PixelData.data (), PixelData.size (), Output.data ());
+    }
+
+    std::chrono::duration<double> Elapsed = std::chrono::steady_clock::now () - Start;
+    return double (NumBytes) / Elapsed.count ();
+
+} // MeasureBytesPerSecond
+
+//----------------------------------------------------------------------------
+void test_benchmark_fast_vs_generic ()
+{
+    for (const TestShape_t & Shape : TestShapes)
+    {
+        c_TestIterator Fast;
+        c_TestIterator Generic;
+        ConfigureShape (Fast, Shape);
+        ConfigureShape (Generic, Shape);
+        Generic.UseGenericIterator ();
+
+        std::vector<uint8_t> Output (TEST_PIXEL_COUNT * Shape.GroupSize * Shape.NumBytesPerPixel + 1);
+
+        double GenericRate = MeasureBytesPerSecond (Generic, Output);
+        double FastRate    = MeasureBytesPerSecond (Fast, Output);
+
+        char Message[128];
+        snprintf (Message, sizeof (Message), "%-18s generic %7.1f MB/s  fast %7.1f MB/s  x%.2f",
+                  Shape.Name, GenericRate / 1.0e6, FastRate / 1.0e6, FastRate / GenericRate);
+        TEST_MESSAGE (Message);
+    }
+
+} // test_benchmark_fast_vs_generic
+
+//----------------------------------------------------------------------------
+int main (int, char **)
+{
+    UNITY_BEGIN ();
+    RUN_TEST (test_fast_iterators_match_generic);
+    RUN_TEST (test_benchmark_fast_vs_generic);
+    return UNITY_END ();
+
+} // main
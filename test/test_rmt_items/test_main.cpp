@@ -0,0 +1,260 @@
+/*
+* test_main.cpp - Host checks and benchmark for the RMT item encoders
+*
+* Project: ESPixelStick - An ESP8266 / ESP32 and E1.31 based pixel driver
+* Copyright (c) 2022 Shelby Merrick
+* http://www.forkineye.com
+*
+*  This program is provided free for you to use in any way that you wish,
+*  subject to the laws and regulations where you are using it.  Due diligence
+*  is strongly suggested before using this code.  Please give credit where due.
+*
+*  The Author makes no warranty of any kind, express or implied, with regard
+*  to this program or the documentation contained in this document.  The
+*  Author shall not be liable in any event for incidental or consequential
+*  damages in connection with, or arising out of, the furnishing, performance
+*  or use of these programs.
+*
+*   The nibble table encoder used by c_OutputRmt must write the same items
+*   to the same ring positions as the bit by bit loop it replaced, including
+*   across the wrap point. The benchmark runs the refill loop of
+*   c_OutputRmt::ISR_Handler_SendIntensityData over a 680 pixel WS2811
+*   frame with each encoder. The figures are host figures: they show the
+*   relative cost of the two loops, not ESP32 ccount cycles.
+*
+*   pio test -e native -f test_rmt_items -v
+*
+*/
+
+#include <unity.h>
+#include <chrono>
+#include <vector>
+#include <stdio.h>
+#include "OutputRmtItems.hpp"
+
+// same layout as rmt_item32_t: duration0:15, level0:1, duration1:15, level1:1
+struct TestRmtItem_t
+{
+    uint32_t val;
+};
+#define TEST_RMT_ITEM(d0, l0, d1, l1)   (uint32_t (d0) | (uint32_t (l0) << 15) | (uint32_t (d1) << 16) | (uint32_t (l1) << 31))
+
+// WS2811 with 25ns ticks, as built by c_OutputWS2811Rmt
+#define TEST_WS2811_ZERO_BIT            TEST_RMT_ITEM (10, 1, 40, 0)
+#define TEST_WS2811_ONE_BIT             TEST_RMT_ITEM (23, 1, 27, 0)
+
+// one memory block of 64 items, refilled 48 items at a time
+#define TEST_NUM_RMT_SLOTS              64
+#define TEST_NUM_RMT_SLOTS_PER_INT      48
+#define TEST_BENCHMARK_INTENSITIES      (680 * 3)
+#define TEST_BENCHMARK_FRAMES           2000
+
+//----------------------------------------------------------------------------
+// The channel state c_OutputRmt keeps for its memory block
+class c_TestRmtRing
+{
+public:
+    c_TestRmtRing (size_t NumSlots, size_t NumSlotsPerInterrupt) :
+        Items (NumSlots + 1),
+        NumRmtSlots (NumSlots),
+        NumRmtSlotsPerInterrupt (NumSlotsPerInterrupt)
+    {
+        RmtStartAddr   = &Items[0];
+        RmtEndAddr     = &Items[NumSlots - 1];
+        RmtCurrentAddr = RmtStartAddr;
+        NumAvailableRmtSlotsToFill = NumSlots;
+    }
+
+    void StartAt (size_t Slot)
+    {
+        RmtCurrentAddr = RmtStartAddr + Slot;
+    }
+
+    // the threshold interrupt: the hardware has sent another block of items
+    void Refill ()
+    {
+        NumAvailableRmtSlotsToFill += NumRmtSlotsPerInterrupt;
+        if (NumRmtSlots < NumAvailableRmtSlotsToFill)
+        {
+            NumAvailableRmtSlotsToFill = NumRmtSlots;
+        }
+    }
+
+    std::vector<TestRmtItem_t>       Items;
+    volatile TestRmtItem_t *         RmtStartAddr               = nullptr;
+    volatile TestRmtItem_t *         RmtCurrentAddr             = nullptr;
+    volatile TestRmtItem_t *         RmtEndAddr                 = nullptr;
+    volatile size_t                  NumAvailableRmtSlotsToFill = 0;
+    size_t                           NumRmtSlots;
+    size_t                           NumRmtSlotsPerInterrupt;
+
+}; // c_TestRmtRing
+
+static uint32_t Nibble2Rmt[RMT_NUM_NIBBLE_VALUES][RMT_ITEMS_PER_NIBBLE];
+
+//----------------------------------------------------------------------------
+static void EnqueueByNibble (c_TestRmtRing & Ring, uint32_t IntensityValue, uint32_t IntensityDataWidth)
+{
+    RmtEnqueueIntensityByNibble (Ring.RmtCurrentAddr, Ring.RmtStartAddr, Ring.RmtEndAddr, Ring.NumAvailableRmtSlotsToFill,
+                                 IntensityValue, int32_t (IntensityDataWidth - RMT_ITEMS_PER_NIBBLE), Nibble2Rmt);
+} // EnqueueByNibble
+
+//----------------------------------------------------------------------------
+static void EnqueueBitByBit (c_TestRmtRing & Ring, uint32_t IntensityValue, uint32_t IntensityDataWidth)
+{
+    RmtEnqueueIntensityBitByBit (Ring.RmtCurrentAddr, Ring.RmtStartAddr, Ring.RmtEndAddr, Ring.NumAvailableRmtSlotsToFill,
+                                 IntensityValue, uint32_t (1) << (IntensityDataWidth - 1), TEST_WS2811_ONE_BIT, TEST_WS2811_ZERO_BIT);
+} // EnqueueBitByBit
+
+//----------------------------------------------------------------------------
+/*
+    Same refill loop as c_OutputRmt::ISR_Handler_SendIntensityData. Returns
+    the number of threshold interrupts the frame needed.
+*/
+template <typename Encoder_t>
+static uint32_t SendFrame (c_TestRmtRing & Ring, const uint8_t * pData, size_t DataSize, Encoder_t Encoder)
+{
+    uint32_t NumInterrupts = 0;
+    size_t   Index = 0;
+
+    while (Index < DataSize)
+    {
+        while ((Ring.NumAvailableRmtSlotsToFill > 8) && (Index < DataSize))
+        {
+            Encoder (Ring, pData[Index++], 8);
+        }
+        Ring.RmtCurrentAddr->val = 0;
+        Ring.Refill ();
+        ++NumInterrupts;
+    }
+
+    return NumInterrupts;
+
+} // SendFrame
+
+//----------------------------------------------------------------------------
+void setUp ()
+{
+    RmtBuildNibbleTable (TEST_WS2811_ONE_BIT, TEST_WS2811_ZERO_BIT, Nibble2Rmt);
+} // setUp
+
+//----------------------------------------------------------------------------
+void tearDown ()
+{
+} // tearDown
+
+//----------------------------------------------------------------------------
+void test_nibble_table_items ()
+{
+    for (uint32_t NibbleValue = 0; NibbleValue < RMT_NUM_NIBBLE_VALUES; ++NibbleValue)
+    {
+        for (uint32_t ItemIndex = 0; ItemIndex < RMT_ITEMS_PER_NIBBLE; ++ItemIndex)
+        {
+            bool BitIsSet = 0 != (NibbleValue & (0x8 >> ItemIndex));
+            TEST_ASSERT_EQUAL_UINT32 ((BitIsSet) ? TEST_WS2811_ONE_BIT : TEST_WS2811_ZERO_BIT, Nibble2Rmt[NibbleValue][ItemIndex]);
+        }
+    }
+
+} // test_nibble_table_items
+
+//----------------------------------------------------------------------------
+void test_nibble_matches_bit_by_bit_across_the_wrap ()
+{
+    static const uint32_t Widths[] = {4, 8, 12, 16, 24, 32};
+
+    for (uint32_t IntensityDataWidth : Widths)
+    {
+        uint32_t ValueMask = (32 == IntensityDataWidth) ? ~uint32_t (0) : ((uint32_t (1) << IntensityDataWidth) - 1);
+
+        // every start position so the wrap point lands inside each nibble
+        for (size_t StartSlot = 0; StartSlot < TEST_NUM_RMT_SLOTS; ++StartSlot)
+        {
+            c_TestRmtRing Nibble (TEST_NUM_RMT_SLOTS, TEST_NUM_RMT_SLOTS_PER_INT);
+            c_TestRmtRing BitByBit (TEST_NUM_RMT_SLOTS, TEST_NUM_RMT_SLOTS_PER_INT);
+            Nibble.StartAt (StartSlot);
+            BitByBit.StartAt (StartSlot);
+
+            uint32_t Seed = uint32_t (StartSlot * 7919) + IntensityDataWidth;
+            for (uint32_t count = 0; count < 40; ++count)
+            {
+                Seed = (Seed * 1664525) + 1013904223;
+                uint32_t IntensityValue = Seed & ValueMask;
+
+                if (Nibble.NumAvailableRmtSlotsToFill < IntensityDataWidth)
+                {
+                    Nibble.Refill ();
+                    BitByBit.Refill ();
+                }
+
+                EnqueueByNibble (Nibble, IntensityValue, IntensityDataWidth);
+                EnqueueBitByBit (BitByBit, IntensityValue, IntensityDataWidth);
+
+                TEST_ASSERT_EQUAL (BitByBit.RmtCurrentAddr - BitByBit.RmtStartAddr, Nibble.RmtCurrentAddr - Nibble.RmtStartAddr);
+                TEST_ASSERT_EQUAL (BitByBit.NumAvailableRmtSlotsToFill, Nibble.NumAvailableRmtSlotsToFill);
+                for (size_t Slot = 0; Slot <= TEST_NUM_RMT_SLOTS; ++Slot)
+                {
+                    TEST_ASSERT_EQUAL_UINT32 (BitByBit.Items[Slot].val, Nibble.Items[Slot].val);
+                }
+            }
+        }
+    }
+
+} // test_nibble_matches_bit_by_bit_across_the_wrap
+
+//----------------------------------------------------------------------------
+template <typename Encoder_t>
+static double MeasureNsPerIntensity (size_t NumSlots, size_t NumSlotsPerInterrupt, const std::vector<uint8_t> & Data, Encoder_t Encoder)
+{
+    c_TestRmtRing Ring (NumSlots, NumSlotsPerInterrupt);
+
+    auto Start = std::chrono::steady_clock::now ();
+
+    for (uint32_t FrameCount = 0; FrameCount < TEST_BENCHMARK_FRAMES; ++FrameCount)
+    {
+        SendFrame (Ring, Data.data (), Data.size (), Encoder);
+    }
+
+    std::chrono::duration<double, std::nano> Elapsed = std::chrono::steady_clock::now () - Start;
+    return Elapsed.count () / double (size_t (TEST_BENCHMARK_FRAMES) * Data.size ());
+
+} // MeasureNsPerIntensity
+
+//----------------------------------------------------------------------------
+void test_benchmark_nibble_vs_bit_by_bit ()
+{
+    std::vector<uint8_t> Data (TEST_BENCHMARK_INTENSITIES);
+    uint32_t Seed = 0x2811;
+    for (uint8_t & Intensity : Data)
+    {
+        Seed = (Seed * 1664525) + 1013904223;
+        Intensity = uint8_t (Seed >> 24);
+    }
+
+    // one memory block, then two blocks refilled half at a time
+    static const size_t NumBlocks[] = {1, 2};
+    for (size_t Blocks : NumBlocks)
+    {
+        size_t NumSlots             = TEST_NUM_RMT_SLOTS * Blocks;
+        size_t NumSlotsPerInterrupt = (1 == Blocks) ? TEST_NUM_RMT_SLOTS_PER_INT : (NumSlots / 2);
+
+        double BitByBitNs = MeasureNsPerIntensity (NumSlots, NumSlotsPerInterrupt, Data, EnqueueBitByBit);
+        double NibbleNs   = MeasureNsPerIntensity (NumSlots, NumSlotsPerInterrupt, Data, EnqueueByNibble);
+
+        char Message[160];
+        snprintf (Message, sizeof (Message), "%u block(s)  bit by bit %6.2f ns/intensity  nibble table %6.2f ns/intensity  x%.2f (host)",
+                  unsigned (Blocks), BitByBitNs, NibbleNs, BitByBitNs / NibbleNs);
+        TEST_MESSAGE (Message);
+    }
+
+} // test_benchmark_nibble_vs_bit_by_bit
+
+//----------------------------------------------------------------------------
+int main (int, char **)
+{
+    UNITY_BEGIN ();
+    RUN_TEST (test_nibble_table_items);
+    RUN_TEST (test_nibble_matches_bit_by_bit_across_the_wrap);
+    RUN_TEST (test_benchmark_nibble_vs_bit_by_bit);
+    return UNITY_END ();
+
+} // main
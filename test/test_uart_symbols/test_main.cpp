@@ -0,0 +1,224 @@
+/*
+* test_main.cpp - Host checks for the UART nibble symbol table
+*
+* Project: ESPixelStick - An ESP8266 / ESP32 and E1.31 based pixel driver
+* Copyright (c) 2022 Shelby Merrick
+* http://www.forkineye.com
+*
+*  This program is provided free for you to use in any way that you wish,
+*  subject to the laws and regulations where you are using it.  Due diligence
+*  is strongly suggested before using this code.  Please give credit where due.
+*
+*  The Author makes no warranty of any kind, express or implied, with regard
+*  to this program or the documentation contained in this document.  The
+*  Author shall not be liable in any event for incidental or consequential
+*  damages in connection with, or arising out of, the furnishing, performance
+*  or use of these programs.
+*
+*   c_OutputUart translates intensity data with a nibble table when the data
+*   width allows it. For every chipset translation set the table output
+*   must match the bit by bit translation it replaced, at the chipset data
+*   width and at every other width the table accepts.
+*
+*   pio test -e native -f test_uart_symbols -v
+*
+*/
+
+#include <unity.h>
+#include <string.h>
+#include <stdio.h>
+#include "OutputUartSymbols.hpp"
+
+// same limit as c_OutputUart
+#define UART_MAX_SLOTS_PER_INTENSITY    32
+#define TEST_MAX_DATA_WIDTH             UART_MAX_SLOTS_PER_INTENSITY
+#define TEST_MAX_EXHAUSTIVE_WIDTH       16
+#define TEST_NUM_SAMPLED_VALUES         100000
+
+//----------------------------------------------------------------------------
+// The translation sets and data widths the UART chipset drivers configure
+struct TestTranslationSet_t
+{
+    const char * Name;
+    uint8_t      Intensity2Uart[4];
+    bool         OneToOne;
+    size_t       IntensityDataWidth;
+};
+
+static const TestTranslationSet_t TestTranslationSets[] =
+{
+    {"WS2811",  {0b00110111, 0b00000111, 0b00110100, 0b00000100}, false, 8},
+    {"GS8208",  {0b00110111, 0b00000111, 0b00110100, 0b00000100}, false, 8},
+    {"UCS1903", {0b00110111, 0b00000111, 0b00110100, 0b00000100}, false, 8},
+    {"TM1814",  {0b11111100, 0b11000000, 0, 0},                   true,  8},
+    {"UCS8903", {0b11111100, 0b11000000, 0, 0},                   true,  16},
+    {"GECE",    {0b11101111, 0b11101000, 0b00001111, 0b00001000}, false, 26},
+};
+
+//----------------------------------------------------------------------------
+// same starting mask as c_OutputUart::SetIntensityDataWidth
+static uint32_t StartingMask (bool OneToOne, size_t IntensityDataWidth)
+{
+    return (OneToOne) ? (uint32_t (1) << (IntensityDataWidth - 1)) : uint32_t (IntensityDataWidth);
+
+} // StartingMask
+
+//----------------------------------------------------------------------------
+/*
+    Compare the table and bit by bit output for one value. Returns false
+    and describes the mismatch in Message.
+*/
+static bool CheckValue (const TestTranslationSet_t & Set,
+                        size_t                       IntensityDataWidth,
+                        const uint32_t *             Nibble2UartSymbols,
+                        uint32_t                     NumUartSymbolsPerNibble,
+                        uint32_t                     IntensityValue,
+                        char *                       Message,
+                        size_t                       MessageSize)
+{
+    uint8_t TableData[TEST_MAX_DATA_WIDTH];
+    uint8_t BitData[TEST_MAX_DATA_WIDTH];
+
+    size_t TableSize = UartSymbolsTranslateByNibble (IntensityValue, IntensityDataWidth, Nibble2UartSymbols, NumUartSymbolsPerNibble, TableData);
+    size_t BitSize   = UartSymbolsTranslateBitByBit (IntensityValue, Set.OneToOne, StartingMask (Set.OneToOne, IntensityDataWidth), Set.Intensity2Uart, BitData);
+
+    if ((TableSize == BitSize) && (0 == memcmp (TableData, BitData, BitSize)))
+    {
+        return true;
+    }
+
+    snprintf (Message, MessageSize, "%s width %u value 0x%x: table %u bytes, bit by bit %u bytes",
+              Set.Name, unsigned (IntensityDataWidth), unsigned (IntensityValue), unsigned (TableSize), unsigned (BitSize));
+    return false;
+
+} // CheckValue
+
+//----------------------------------------------------------------------------
+/*
+    Every value up to 16 bits, a spread of values above that.
+*/
+static void CheckWidth (const TestTranslationSet_t & Set, size_t IntensityDataWidth)
+{
+    uint32_t Nibble2UartSymbols[UART_SYMBOLS_NIBBLE_TABLE_SIZE];
+    uint32_t NumUartSymbolsPerNibble = UartSymbolsBuildNibbleTable (Set.Intensity2Uart, Set.OneToOne, IntensityDataWidth, Nibble2UartSymbols);
+    char     Message[128];
+
+    TEST_ASSERT_EQUAL_UINT32 ((Set.OneToOne) ? 4 : 2, NumUartSymbolsPerNibble);
+
+    if (IntensityDataWidth <= TEST_MAX_EXHAUSTIVE_WIDTH)
+    {
+        for (uint32_t IntensityValue = 0; IntensityValue < (uint32_t (1) << IntensityDataWidth); ++IntensityValue)
+        {
+            if (!CheckValue (Set, IntensityDataWidth, Nibble2UartSymbols, NumUartSymbolsPerNibble, IntensityValue, Message, sizeof (Message))) { TEST_FAIL_MESSAGE (Message); }
+        }
+    }
+    else
+    {
+        uint32_t ValueMask = (32 == IntensityDataWidth) ? ~uint32_t (0) : ((uint32_t (1) << IntensityDataWidth) - 1);
+        uint32_t Seed = 0x12345678;
+        for (uint32_t count = 0; count < TEST_NUM_SAMPLED_VALUES; ++count)
+        {
+            Seed = (Seed * 1664525) + 1013904223;
+            if (!CheckValue (Set, IntensityDataWidth, Nibble2UartSymbols, NumUartSymbolsPerNibble, Seed & ValueMask, Message, sizeof (Message))) { TEST_FAIL_MESSAGE (Message); }
+        }
+        if (!CheckValue (Set, IntensityDataWidth, Nibble2UartSymbols, NumUartSymbolsPerNibble, ValueMask, Message, sizeof (Message))) { TEST_FAIL_MESSAGE (Message); }
+    }
+
+} // CheckWidth
+
+//----------------------------------------------------------------------------
+void setUp ()
+{
+} // setUp
+
+//----------------------------------------------------------------------------
+void tearDown ()
+{
+} // tearDown
+
+//----------------------------------------------------------------------------
+void test_table_matches_bit_by_bit_at_chipset_width ()
+{
+    for (const TestTranslationSet_t & Set : TestTranslationSets)
+    {
+        if (0 != (Set.IntensityDataWidth % 4))
+        {
+            continue;
+        }
+        CheckWidth (Set, Set.IntensityDataWidth);
+    }
+
+} // test_table_matches_bit_by_bit_at_chipset_width
+
+//----------------------------------------------------------------------------
+void test_table_matches_bit_by_bit_at_every_width ()
+{
+    for (const TestTranslationSet_t & Set : TestTranslationSets)
+    {
+        // 1:1 at 32 bits fills all UART_MAX_SLOTS_PER_INTENSITY slots
+        for (size_t IntensityDataWidth = 4; IntensityDataWidth <= 32; IntensityDataWidth += 4)
+        {
+            CheckWidth (Set, IntensityDataWidth);
+        }
+    }
+
+} // test_table_matches_bit_by_bit_at_every_width
+
+//----------------------------------------------------------------------------
+void test_table_not_used_when_width_is_not_a_multiple_of_4 ()
+{
+    uint32_t Nibble2UartSymbols[UART_SYMBOLS_NIBBLE_TABLE_SIZE];
+
+    for (const TestTranslationSet_t & Set : TestTranslationSets)
+    {
+        for (size_t IntensityDataWidth = 1; IntensityDataWidth <= 32; ++IntensityDataWidth)
+        {
+            uint32_t NumUartSymbolsPerNibble = UartSymbolsBuildNibbleTable (Set.Intensity2Uart, Set.OneToOne, IntensityDataWidth, Nibble2UartSymbols);
+            TEST_ASSERT_EQUAL_UINT32 ((0 == (IntensityDataWidth % 4)) ? ((Set.OneToOne) ? 4 : 2) : 0, NumUartSymbolsPerNibble);
+        }
+    }
+
+} // test_table_not_used_when_width_is_not_a_multiple_of_4
+
+//----------------------------------------------------------------------------
+void test_bit_by_bit_known_symbols ()
+{
+    uint8_t UartData[TEST_MAX_DATA_WIDTH];
+
+    // WS2811 0x1B = 00 01 10 11, first pair on the wire first
+    const TestTranslationSet_t & Ws2811 = TestTranslationSets[0];
+    TEST_ASSERT_EQUAL (4, UartSymbolsTranslateBitByBit (0x1B, false, StartingMask (false, 8), Ws2811.Intensity2Uart, UartData));
+    TEST_ASSERT_EQUAL_HEX8 (0b00110111, UartData[0]);
+    TEST_ASSERT_EQUAL_HEX8 (0b00000111, UartData[1]);
+    TEST_ASSERT_EQUAL_HEX8 (0b00110100, UartData[2]);
+    TEST_ASSERT_EQUAL_HEX8 (0b00000100, UartData[3]);
+
+    // TM1814 0x81 = 1000 0001, one byte per bit, MSB first
+    const TestTranslationSet_t & Tm1814 = TestTranslationSets[3];
+    TEST_ASSERT_EQUAL (8, UartSymbolsTranslateBitByBit (0x81, true, StartingMask (true, 8), Tm1814.Intensity2Uart, UartData));
+    TEST_ASSERT_EQUAL_HEX8 (0b11000000, UartData[0]);
+    TEST_ASSERT_EQUAL_HEX8 (0b11111100, UartData[1]);
+    TEST_ASSERT_EQUAL_HEX8 (0b11111100, UartData[6]);
+    TEST_ASSERT_EQUAL_HEX8 (0b11000000, UartData[7]);
+
+    // GECE uses the bit by bit path: 26 bits is 13 UART bytes
+    const TestTranslationSet_t & Gece = TestTranslationSets[5];
+    TEST_ASSERT_EQUAL (13, UartSymbolsTranslateBitByBit (0x3FFFFFF, false, StartingMask (false, 26), Gece.Intensity2Uart, UartData));
+    for (size_t Index = 0; Index < 13; ++Index)
+    {
+        TEST_ASSERT_EQUAL_HEX8 (0b00001000, UartData[Index]);
+    }
+
+} // test_bit_by_bit_known_symbols
+
+//----------------------------------------------------------------------------
+int main (int, char **)
+{
+    UNITY_BEGIN ();
+    RUN_TEST (test_table_matches_bit_by_bit_at_chipset_width);
+    RUN_TEST (test_table_matches_bit_by_bit_at_every_width);
+    RUN_TEST (test_table_not_used_when_width_is_not_a_multiple_of_4);
+    RUN_TEST (test_bit_by_bit_known_symbols);
+    return UNITY_END ();
+
+} // main